@@ -0,0 +1,56 @@
+#include <sys/stat.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "asset_pack.h"
+#include "mime_types.h"
+
+// 用法: webserver_assetpack_builder <docroot> <output.pack>
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <docroot> <output.pack>" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path root = std::filesystem::canonical(argv[1]);
+    AssetPack::Builder builder;
+    size_t files = 0;
+
+    for (const auto& item : std::filesystem::recursive_directory_iterator(root)) {
+        if (!item.is_regular_file()) {
+            continue;
+        }
+        const auto& path = item.path();
+        // 预压缩旁路文件由资源包自身的 gzip 变体取代
+        if (path.extension() == ".gz" || path.extension() == ".zst") {
+            continue;
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream body;
+        body << in.rdbuf();
+        if (!in) {
+            std::cerr << "read failed: " << path << std::endl;
+            return 1;
+        }
+
+        struct stat st {};
+        ::stat(path.c_str(), &st);
+
+        std::string uri = "/" + std::filesystem::relative(path, root).generic_string();
+        auto mime = MimeTypes::getMimeType(uri);
+        builder.add(uri, std::string(mime), std::move(body).str(), st.st_mtim.tv_sec, MimeTypes::isTextType(mime));
+        ++files;
+    }
+
+    std::string error;
+    if (!builder.write(argv[2], error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cout << "packed " << files << " files into " << argv[2] << std::endl;
+    return 0;
+}
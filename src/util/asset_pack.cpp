@@ -0,0 +1,302 @@
+#include "asset_pack.h"
+#include "compression.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint32_t kMaxSeedAttempts = 1u << 24;
+
+    uint64_t alignUp(uint64_t value, uint64_t align) {
+        return (value + align - 1) / align * align;
+    }
+
+    std::string httpDate(int64_t seconds) {
+        std::time_t t = static_cast<std::time_t>(seconds);
+        std::tm tm {};
+        gmtime_r(&t, &tm);
+        char buf[64];
+        std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return buf;
+    }
+
+    bool writeAll(int fd, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool inRange(uint64_t offset, uint64_t len, uint64_t limit) {
+        return offset <= limit && len <= limit - offset;
+    }
+}
+
+namespace AssetPack {
+    uint64_t hash(std::string_view key, uint64_t seed) {
+        uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    Pack::~Pack() {
+        if (base_) {
+            ::munmap(const_cast<char*>(base_), size_);
+        }
+    }
+
+    std::shared_ptr<const Pack> Pack::open(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "open failed: " + std::string(strerror(errno));
+            return nullptr;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            error = "file too small";
+            return nullptr;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        // MAP_SHARED：部署时 rename 新包覆盖旧路径，旧映射仍指向原 inode，不受影响
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            error = "mmap failed: " + std::string(strerror(errno));
+            return nullptr;
+        }
+
+        std::shared_ptr<Pack> pack(new Pack());
+        pack->base_ = static_cast<const char*>(addr);
+        pack->size_ = size;
+        pack->header_ = reinterpret_cast<const Header*>(pack->base_);
+
+        const Header& h = *pack->header_;
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion) {
+            error = "bad magic or version";
+            return nullptr;
+        }
+        if (h.total_size != size || h.bucket_count == 0 ||
+            !inRange(h.seeds_offset, uint64_t {h.bucket_count} * sizeof(uint32_t), size) ||
+            !inRange(h.entries_offset, uint64_t {h.count} * sizeof(Entry), size) ||
+            !inRange(h.strings_offset, h.strings_size, size) ||
+            h.seeds_offset % alignof(uint32_t) != 0 || h.entries_offset % alignof(Entry) != 0) {
+            error = "corrupted header";
+            return nullptr;
+        }
+
+        pack->seeds_ = reinterpret_cast<const uint32_t*>(pack->base_ + h.seeds_offset);
+        pack->entries_ = reinterpret_cast<const Entry*>(pack->base_ + h.entries_offset);
+        pack->strings_ = pack->base_ + h.strings_offset;
+
+        // 启动时一次性校验所有条目，请求路径上不再做边界检查
+        for (uint32_t i = 0; i < h.count; ++i) {
+            const Entry& e = pack->entries_[i];
+            if (!inRange(e.body_offset, e.body_len, size) || !inRange(e.gzip_offset, e.gzip_len, size) ||
+                !inRange(e.uri_offset, e.uri_len, h.strings_size) ||
+                !inRange(e.etag_offset, e.etag_len, h.strings_size) ||
+                !inRange(e.headers_offset, e.headers_len, h.strings_size) ||
+                !inRange(e.gzip_headers_offset, e.gzip_headers_len, h.strings_size)) {
+                error = "corrupted entry " + std::to_string(i);
+                return nullptr;
+            }
+        }
+        return pack;
+    }
+
+    bool Pack::find(std::string_view uri, Asset& asset) const {
+        const Header& h = *header_;
+        if (h.count == 0) {
+            return false;
+        }
+        uint32_t seed = seeds_[hash(uri, 0) % h.bucket_count];
+        const Entry& e = entries_[hash(uri, seed) % h.count];
+        if (std::string_view(strings_ + e.uri_offset, e.uri_len) != uri) {
+            return false;
+        }
+        asset.body = {base_ + e.body_offset, e.body_len};
+        asset.gzip = {base_ + e.gzip_offset, e.gzip_len};
+        asset.etag = {strings_ + e.etag_offset, e.etag_len};
+        asset.headers = {strings_ + e.headers_offset, e.headers_len};
+        asset.gzip_headers = {strings_ + e.gzip_headers_offset, e.gzip_headers_len};
+        asset.mtime = e.mtime;
+        return true;
+    }
+
+    void Builder::add(std::string uri, std::string content_type, std::string body, int64_t mtime, bool compress) {
+        Item item {std::move(uri), std::move(content_type), std::move(body), {}, mtime};
+        if (compress && (!Compression::compress(Compression::Encoding::GZIP, item.body, item.gzip, 9) ||
+                         item.gzip.size() >= item.body.size())) {
+            item.gzip.clear();
+        }
+        items_.push_back(std::move(item));
+    }
+
+    bool Builder::write(const std::string& path, std::string& error) const {
+        const uint32_t count = static_cast<uint32_t>(items_.size());
+        const uint32_t bucket_count = count / 2 + 1;
+
+        // 最小完美哈希（hash-and-displace）：按桶大小降序，为每个桶寻找让其所有 key 落到空槽的种子
+        std::vector<std::vector<uint32_t>> buckets(bucket_count);
+        for (uint32_t i = 0; i < count; ++i) {
+            buckets[hash(items_[i].uri, 0) % bucket_count].push_back(i);
+        }
+        std::vector<uint32_t> order(bucket_count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+        std::vector<uint32_t> seeds(bucket_count, 0);
+        std::vector<int64_t> slot_of(count, -1); // 槽位 -> 条目
+        std::vector<uint32_t> slots;
+        for (uint32_t b : order) {
+            const auto& keys = buckets[b];
+            if (keys.empty()) {
+                break;
+            }
+            uint32_t seed = 1;
+            for (; seed < kMaxSeedAttempts; ++seed) {
+                slots.clear();
+                bool ok = true;
+                for (uint32_t k : keys) {
+                    uint32_t slot = static_cast<uint32_t>(hash(items_[k].uri, seed) % count);
+                    if (slot_of[slot] >= 0 || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        ok = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (ok) {
+                    break;
+                }
+            }
+            if (seed == kMaxSeedAttempts) {
+                error = "perfect hash construction failed (duplicate uri " + items_[keys[0]].uri + "?)";
+                return false;
+            }
+            seeds[b] = seed;
+            for (size_t i = 0; i < keys.size(); ++i) {
+                slot_of[slots[i]] = keys[i];
+            }
+        }
+
+        // strings 区：URI、ETag、两份预序列化响应头
+        std::string strings;
+        std::vector<Entry> entries(count);
+        auto append = [&strings](std::string_view s, uint32_t& offset, uint32_t& len) {
+            offset = static_cast<uint32_t>(strings.size());
+            len = static_cast<uint32_t>(s.size());
+            strings.append(s);
+        };
+
+        for (uint32_t slot = 0; slot < count; ++slot) {
+            const Item& item = items_[slot_of[slot]];
+            Entry& e = entries[slot];
+            e = {};
+            e.mtime = item.mtime;
+
+            char digest[17];
+            std::snprintf(digest, sizeof(digest), "%016llx",
+                          static_cast<unsigned long long>(hash(item.body, 0x5eed)));
+            std::string etag = "\"" + std::string(digest) + "\"";
+            std::string gzip_etag = "\"" + std::string(digest) + "-gzip\"";
+
+            std::string common = "Content-Type: " + item.content_type + "\r\n" +
+                                 "Last-Modified: " + httpDate(item.mtime) + "\r\n" +
+                                 "Accept-Ranges: bytes\r\n";
+            if (!item.gzip.empty()) {
+                common += "Vary: Accept-Encoding\r\n";
+            }
+
+            append(item.uri, e.uri_offset, e.uri_len);
+            append(etag, e.etag_offset, e.etag_len);
+            append(common + "ETag: " + etag + "\r\n", e.headers_offset, e.headers_len);
+            if (!item.gzip.empty()) {
+                append(common + "ETag: " + gzip_etag + "\r\nContent-Encoding: gzip\r\n",
+                       e.gzip_headers_offset, e.gzip_headers_len);
+            }
+        }
+
+        Header header {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.count = count;
+        header.bucket_count = bucket_count;
+        header.seeds_offset = alignUp(sizeof(Header), alignof(Entry));
+        header.entries_offset = alignUp(header.seeds_offset + seeds.size() * sizeof(uint32_t), alignof(Entry));
+        header.strings_offset = header.entries_offset + entries.size() * sizeof(Entry);
+        header.strings_size = strings.size();
+
+        // 文件体按页对齐，mmap 后可直接作为发送源
+        uint64_t cursor = alignUp(header.strings_offset + header.strings_size, kPageSize);
+        for (uint32_t slot = 0; slot < count; ++slot) {
+            const Item& item = items_[slot_of[slot]];
+            Entry& e = entries[slot];
+            e.body_offset = cursor;
+            e.body_len = item.body.size();
+            cursor = alignUp(cursor + e.body_len, kPageSize);
+            if (!item.gzip.empty()) {
+                e.gzip_offset = cursor;
+                e.gzip_len = item.gzip.size();
+                cursor = alignUp(cursor + e.gzip_len, kPageSize);
+            }
+        }
+        header.total_size = cursor;
+
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = "open " + tmp + " failed: " + strerror(errno);
+            return false;
+        }
+
+        std::string meta(header.strings_offset + header.strings_size, '\0');
+        std::memcpy(meta.data(), &header, sizeof(header));
+        std::memcpy(meta.data() + header.seeds_offset, seeds.data(), seeds.size() * sizeof(uint32_t));
+        std::memcpy(meta.data() + header.entries_offset, entries.data(), entries.size() * sizeof(Entry));
+        std::memcpy(meta.data() + header.strings_offset, strings.data(), strings.size());
+
+        bool ok = writeAll(fd, meta.data(), meta.size());
+        for (uint32_t slot = 0; ok && slot < count; ++slot) {
+            const Item& item = items_[slot_of[slot]];
+            const Entry& e = entries[slot];
+            ok = ::pwrite(fd, item.body.data(), item.body.size(), static_cast<off_t>(e.body_offset)) ==
+                 static_cast<ssize_t>(item.body.size());
+            if (ok && !item.gzip.empty()) {
+                ok = ::pwrite(fd, item.gzip.data(), item.gzip.size(), static_cast<off_t>(e.gzip_offset)) ==
+                     static_cast<ssize_t>(item.gzip.size());
+            }
+        }
+        ok = ok && ::ftruncate(fd, static_cast<off_t>(header.total_size)) == 0 && ::fsync(fd) == 0;
+        ::close(fd);
+
+        if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+            error = "write " + path + " failed: " + strerror(errno);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+#include "compressed_cache.h"
+#include "logger.h"
+#include "threadpool.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // 读取整个文件，并确认读到的内容与 key 中记录的文件身份一致（期间未被替换/截断）
+    bool readFile(const std::string& path, const CompressedCache::Key& key, std::string& out) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || st.st_dev != key.dev || st.st_ino != key.ino || st.st_size != key.size) {
+            ::close(fd);
+            return false;
+        }
+        out.resize(static_cast<size_t>(st.st_size));
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t n = ::pread(fd, out.data() + done, out.size() - done, static_cast<off_t>(done));
+            if (n <= 0) {
+                ::close(fd);
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        ::close(fd);
+        return true;
+    }
+}
+
+CompressedCache::CompressedCache()
+    : hits_(Metrics::counter("compress_cache_hit_total")),
+      misses_(Metrics::counter("compress_cache_miss_total")),
+      bytes_gauge_(Metrics::counter("compress_cache_bytes")) {}
+
+CompressedCache& CompressedCache::Instance() {
+    static CompressedCache instance;
+    return instance;
+}
+
+void CompressedCache::init(size_t budget_bytes, int gzip_level, int zstd_level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budget_bytes;
+    gzip_level_ = gzip_level;
+    zstd_level_ = zstd_level;
+}
+
+size_t CompressedCache::KeyHash::operator()(const Key& key) const {
+    size_t h = std::hash<uint64_t> {}(static_cast<uint64_t>(key.ino));
+    auto mix = [&h](uint64_t v) { h ^= std::hash<uint64_t> {}(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+    mix(static_cast<uint64_t>(key.dev));
+    mix(static_cast<uint64_t>(key.mtime_ns));
+    mix(static_cast<uint64_t>(key.size));
+    mix(static_cast<uint64_t>(key.encoding));
+    return h;
+}
+
+CompressedCache::Blob CompressedCache::lookup(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_.add();
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_.add();
+    return it->second->second;
+}
+
+void CompressedCache::compressAsync(const Key& key, std::string path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (budget_ == 0 || index_.count(key) || !inflight_.insert(key).second) {
+            return;
+        }
+    }
+
+    FThreadPool::getInst().pushTask([this, key, path = std::move(path)](size_t) {
+        std::string input;
+        auto compressed = std::make_shared<std::string>();
+        if (readFile(path, key, input)) {
+            int level = key.encoding == Compression::Encoding::ZSTD ? zstd_level_ : gzip_level_;
+            if (!Compression::compress(key.encoding, input, *compressed, level) || compressed->size() >= input.size()) {
+                compressed->clear(); // 不可压缩：缓存空结果，后续直接回源文件
+            }
+            insert(key, std::move(compressed));
+        } else {
+            LOG_WARN("[CompressedCache] skip {}: file changed or unreadable", path);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        inflight_.erase(key);
+    });
+}
+
+void CompressedCache::insert(const Key& key, Blob blob) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blob->size() > budget_) {
+        blob = std::make_shared<const std::string>();
+    }
+    if (index_.count(key)) {
+        return;
+    }
+    bytes_ += blob->size() + sizeof(Entry);
+    lru_.emplace_front(key, std::move(blob));
+    index_.emplace(key, lru_.begin());
+
+    while (bytes_ > budget_ && !lru_.empty()) {
+        auto& victim = lru_.back();
+        bytes_ -= victim.second->size() + sizeof(Entry);
+        index_.erase(victim.first);
+        lru_.pop_back();
+    }
+    bytes_gauge_.set(bytes_);
+}
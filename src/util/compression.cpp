@@ -0,0 +1,156 @@
+#include "compression.h"
+#include "logger.h"
+
+#include <charconv>
+#include <zlib.h>
+#ifdef WEBSERVER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+    std::string_view trim(std::string_view sv) {
+        while (!sv.empty() && (sv.front() == ' ' || sv.front() == '\t')) sv.remove_prefix(1);
+        while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t')) sv.remove_suffix(1);
+        return sv;
+    }
+
+    bool iequals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if ((a[i] | 0x20) != (b[i] | 0x20)) return false;
+        }
+        return true;
+    }
+
+    // 解析 ";q=0.5"，缺省为 1
+    double parseQuality(std::string_view params) {
+        while (!params.empty()) {
+            auto semi = params.find(';');
+            auto param = trim(params.substr(0, semi));
+            params = semi == std::string_view::npos ? std::string_view {} : params.substr(semi + 1);
+            if (param.size() >= 2 && (param[0] | 0x20) == 'q' && param[1] == '=') {
+                double q = 0;
+                auto value = param.substr(2);
+                auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), q);
+                return ec == std::errc() ? q : 0;
+            }
+        }
+        return 1;
+    }
+
+    bool gzipCompress(std::string_view input, std::string& out, int level) {
+        z_stream zs {};
+        // windowBits 15 + 16：输出 gzip 头而不是 zlib 头
+        if (deflateInit2(&zs, level > 0 ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        out.resize(deflateBound(&zs, input.size()));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        zs.avail_in = static_cast<uInt>(input.size());
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+        int ret = deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        return ret == Z_STREAM_END;
+    }
+
+#ifdef WEBSERVER_HAVE_ZSTD
+    bool zstdCompress(std::string_view input, std::string& out, int level) {
+        out.resize(ZSTD_compressBound(input.size()));
+        size_t n = ZSTD_compress(out.data(), out.size(), input.data(), input.size(),
+                                 level > 0 ? level : ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(n)) {
+            LOG_ERROR("[Compression] zstd failed: {}", ZSTD_getErrorName(n));
+            return false;
+        }
+        out.resize(n);
+        return true;
+    }
+#endif
+}
+
+namespace Compression {
+    std::string_view name(Encoding encoding) {
+        switch (encoding) {
+            case Encoding::GZIP: return "gzip";
+            case Encoding::ZSTD: return "zstd";
+            default:             return "";
+        }
+    }
+
+    std::string_view sidecarSuffix(Encoding encoding) {
+        switch (encoding) {
+            case Encoding::GZIP: return ".gz";
+            case Encoding::ZSTD: return ".zst";
+            default:             return "";
+        }
+    }
+
+    bool available(Encoding encoding) {
+#ifdef WEBSERVER_HAVE_ZSTD
+        return true;
+#else
+        return encoding != Encoding::ZSTD;
+#endif
+    }
+
+    size_t acceptable(std::string_view accept_encoding, Encoding (&out)[2]) {
+        double q_gzip = -1;
+        double q_zstd = -1;
+        double q_any = -1;
+
+        while (!accept_encoding.empty()) {
+            auto comma = accept_encoding.find(',');
+            auto item = trim(accept_encoding.substr(0, comma));
+            accept_encoding = comma == std::string_view::npos ? std::string_view {} : accept_encoding.substr(comma + 1);
+            if (item.empty()) continue;
+
+            auto semi = item.find(';');
+            auto coding = trim(item.substr(0, semi));
+            double q = semi == std::string_view::npos ? 1 : parseQuality(item.substr(semi + 1));
+
+            if (iequals(coding, "gzip") || iequals(coding, "x-gzip")) {
+                q_gzip = q;
+            } else if (iequals(coding, "zstd")) {
+                q_zstd = q;
+            } else if (coding == "*") {
+                q_any = q;
+            }
+        }
+
+        // 未显式列出的编码按 "*" 处理
+        if (q_gzip < 0) q_gzip = q_any;
+        if (q_zstd < 0) q_zstd = q_any;
+        if (!available(Encoding::ZSTD)) q_zstd = -1;
+
+        size_t count = 0;
+        if (q_zstd > 0 && q_zstd >= q_gzip) {
+            out[count++] = Encoding::ZSTD;
+            if (q_gzip > 0) out[count++] = Encoding::GZIP;
+        } else if (q_gzip > 0) {
+            out[count++] = Encoding::GZIP;
+            if (q_zstd > 0) out[count++] = Encoding::ZSTD;
+        }
+        return count;
+    }
+
+    Encoding negotiate(std::string_view accept_encoding) {
+        Encoding candidates[2];
+        return acceptable(accept_encoding, candidates) > 0 ? candidates[0] : Encoding::IDENTITY;
+    }
+
+    bool compress(Encoding encoding, std::string_view input, std::string& out, int level) {
+        switch (encoding) {
+            case Encoding::GZIP:
+                return gzipCompress(input, out, level);
+#ifdef WEBSERVER_HAVE_ZSTD
+            case Encoding::ZSTD:
+                return zstdCompress(input, out, level);
+#endif
+            default:
+                return false;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include "concurrency_limiter.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 空载延迟每隔这么多窗口按当前窗口重新取样，避免一次偶然的低延迟长期压低上限
+    constexpr int kNoLoadResetWindows = 100;
+}
+
+ConcurrencyLimiter::Permit& ConcurrencyLimiter::Permit::operator=(Permit&& other) noexcept {
+    if (this != &other) {
+        release(false, false);
+        owner_ = other.owner_;
+        start_ = other.start_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+void ConcurrencyLimiter::Permit::release(bool sample, bool failed) {
+    if (!owner_) {
+        return;
+    }
+    auto* owner = owner_;
+    owner_ = nullptr;
+    owner->onRelease(std::chrono::steady_clock::now() - start_, sample, failed);
+}
+
+ConcurrencyLimiter::ConcurrencyLimiter(std::string name, const Options& options)
+    : name_(std::move(name)),
+      options_(options),
+      limit_(std::clamp(options.limit, 1, std::max(1, options.max_limit))),
+      window_start_(std::chrono::steady_clock::now()),
+      inflight_gauge_(Metrics::counter("bulkhead_" + name_ + "_inflight")),
+      limit_gauge_(Metrics::counter("bulkhead_" + name_ + "_limit")),
+      rejected_(Metrics::counter("bulkhead_" + name_ + "_rejected_total")),
+      latency_us_(Metrics::histogram("bulkhead_" + name_ + "_latency_us")) {
+    options_.min_limit = std::clamp(options_.min_limit, 1, limit_.load());
+    options_.max_limit = std::max(options_.max_limit, limit_.load());
+    limit_gauge_.set(static_cast<uint64_t>(limit_.load()));
+}
+
+ConcurrencyLimiter::Permit ConcurrencyLimiter::tryAcquire() {
+    int current = inflight_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (current > limit_.load(std::memory_order_relaxed)) {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.add();
+        return {};
+    }
+    inflight_gauge_.set(static_cast<uint64_t>(current));
+    return Permit(this, std::chrono::steady_clock::now());
+}
+
+void ConcurrencyLimiter::onRelease(std::chrono::steady_clock::duration latency, bool sample, bool failed) {
+    int before = inflight_.fetch_sub(1, std::memory_order_relaxed);
+    inflight_gauge_.set(static_cast<uint64_t>(std::max(0, before - 1)));
+    if (!sample) {
+        return; // 请求被取消（连接关闭），不计入统计
+    }
+    auto latency_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    latency_us_.record(latency_us);
+    if (!options_.adaptive) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(window_mutex_);
+    window_sum_us_ += static_cast<double>(latency_us);
+    ++window_count_;
+    window_max_inflight_ = std::max(window_max_inflight_, before);
+    window_failures_ += failed ? 1 : 0;
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = now - window_start_;
+    // 流量很低时最多等 10 个窗口长度
+    if (elapsed < options_.window || (window_count_ < options_.min_samples && elapsed < options_.window * 10)) {
+        return;
+    }
+    adjust(window_sum_us_ / window_count_, window_max_inflight_, window_failures_ * 10 >= window_count_);
+    window_start_ = now;
+    window_sum_us_ = 0;
+    window_count_ = 0;
+    window_max_inflight_ = 0;
+    window_failures_ = 0;
+}
+
+void ConcurrencyLimiter::adjust(double avg_latency_us, int max_inflight, bool failing) {
+    int limit = limit_.load(std::memory_order_relaxed);
+    int next = limit;
+
+    if (++windows_since_reset_ >= kNoLoadResetWindows || no_load_us_ <= 0 || avg_latency_us < no_load_us_) {
+        no_load_us_ = std::max(1.0, avg_latency_us);
+        windows_since_reset_ = 0;
+    }
+
+    if (failing) {
+        // 下游出错（熔断、超时）：乘性收缩
+        next = static_cast<int>(limit * 0.9);
+    } else {
+        // Vegas：limit * (1 - 空载延迟 / 当前延迟) 估算排队中的请求数
+        double queue = limit * (1.0 - no_load_us_ / std::max(avg_latency_us, no_load_us_));
+        int step = std::max(1, static_cast<int>(std::log10(static_cast<double>(limit))));
+        if (queue <= 3.0 * step && max_inflight * 2 >= limit) {
+            next = limit + step; // 上限确实被用到且几乎不排队才放大
+        } else if (queue >= 6.0 * step) {
+            next = limit - step;
+        }
+    }
+
+    next = std::clamp(next, options_.min_limit, options_.max_limit);
+    if (next != limit) {
+        limit_.store(next, std::memory_order_relaxed);
+        limit_gauge_.set(static_cast<uint64_t>(next));
+        LOG_DEBUG("[ConcurrencyLimiter] {} limit {} -> {}, latency {:.0f}us, no-load {:.0f}us",
+                  name_, limit, next, avg_latency_us, no_load_us_);
+    }
+}
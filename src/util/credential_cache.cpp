@@ -0,0 +1,136 @@
+#include "credential_cache.h"
+
+#include <functional>
+
+namespace {
+    uint64_t mixHash(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+}
+
+CredentialCache::CredentialCache()
+    : hits_(Metrics::counter("auth_cache_hit_total")),
+      negative_hits_(Metrics::counter("auth_cache_negative_hit_total")),
+      misses_(Metrics::counter("auth_cache_miss_total")),
+      bloom_rejects_(Metrics::counter("auth_bloom_reject_total")) {}
+
+CredentialCache& CredentialCache::Instance() {
+    static CredentialCache instance;
+    return instance;
+}
+
+void CredentialCache::init(const Options& options) {
+    options_ = options;
+    enabled_ = true;
+    if (options_.bloom_counters > 0) {
+        bloom_ = std::make_unique<std::atomic<uint8_t>[]>(options_.bloom_counters);
+        if (options_.bloom_hashes <= 0) {
+            options_.bloom_hashes = 1;
+        }
+    }
+}
+
+CredentialCache::Shard& CredentialCache::shardOf(const std::string& username) {
+    return shards_[std::hash<std::string> {}(username) % kShards];
+}
+
+CredentialCache::Lookup CredentialCache::get(const std::string& username, std::string& passwd) {
+    if (!enabled_) {
+        return Lookup::Miss;
+    }
+    if (!mayExist(username)) {
+        bloom_rejects_.add();
+        return Lookup::Absent;
+    }
+
+    auto& shard = shardOf(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(username);
+    if (it == shard.entries.end() || it->second.expires <= std::chrono::steady_clock::now()) {
+        misses_.add();
+        return Lookup::Miss;
+    }
+    if (!it->second.exists) {
+        negative_hits_.add();
+        return Lookup::Absent;
+    }
+    hits_.add();
+    passwd = it->second.passwd;
+    return Lookup::Found;
+}
+
+void CredentialCache::store(const std::string& username, Entry entry) {
+    auto& shard = shardOf(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.size() >= options_.capacity / kShards + 1 && !shard.entries.count(username)) {
+        // 分片满：先清掉过期条目，仍满则整片清空（凭据查找可回源，不值得维护 LRU）
+        auto now = std::chrono::steady_clock::now();
+        std::erase_if(shard.entries, [now](const auto& kv) { return kv.second.expires <= now; });
+        if (shard.entries.size() >= options_.capacity / kShards + 1) {
+            shard.entries.clear();
+        }
+    }
+    shard.entries[username] = std::move(entry);
+}
+
+void CredentialCache::put(const std::string& username, const std::string& passwd) {
+    if (!enabled_) {
+        return;
+    }
+    store(username, Entry {true, passwd, std::chrono::steady_clock::now() + options_.ttl});
+}
+
+void CredentialCache::putAbsent(const std::string& username) {
+    if (!enabled_) {
+        return;
+    }
+    store(username, Entry {false, {}, std::chrono::steady_clock::now() + options_.negative_ttl});
+}
+
+void CredentialCache::invalidate(const std::string& username) {
+    if (!enabled_) {
+        return;
+    }
+    auto& shard = shardOf(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(username);
+}
+
+template<typename F>
+void CredentialCache::forEachSlot(std::string_view username, F&& fn) const {
+    // 双重散列：h1 + i * h2
+    uint64_t h1 = std::hash<std::string_view> {}(username);
+    uint64_t h2 = mixHash(h1) | 1;
+    for (int i = 0; i < options_.bloom_hashes; ++i) {
+        fn(bloom_[(h1 + static_cast<uint64_t>(i) * h2) % options_.bloom_counters]);
+    }
+}
+
+void CredentialCache::bloomAdd(std::string_view username) {
+    if (!bloom_) {
+        return;
+    }
+    forEachSlot(username, [](std::atomic<uint8_t>& counter) {
+        uint8_t value = counter.load(std::memory_order_relaxed);
+        while (value != UINT8_MAX && !counter.compare_exchange_weak(value, value + 1, std::memory_order_relaxed)) {
+        }
+    });
+}
+
+bool CredentialCache::mayExist(std::string_view username) const {
+    if (!bloom_ || !bloom_ready_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    bool present = true;
+    forEachSlot(username, [&present](std::atomic<uint8_t>& counter) {
+        if (counter.load(std::memory_order_relaxed) == 0) {
+            present = false;
+        }
+    });
+    return present;
+}
@@ -0,0 +1,118 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 静态资源包：构建期把 docroot 打包成单个文件，运行时 mmap 后直接从映射区发送
+ *
+ * 文件布局（小端，所有偏移相对文件起点）：
+ *   [Header]                       第 0 页
+ *   [seeds: uint32 * bucket_count] 完美哈希的桶位移种子
+ *   [entries: Entry * count]       槽位即条目下标（最小完美哈希，count 个槽）
+ *   [strings]                      URI 与预序列化的响应头
+ *   [bodies]                       原始内容与 gzip 变体，各自按页对齐
+ */
+namespace AssetPack {
+    inline constexpr char kMagic[8] = {'W', 'S', 'A', 'P', 'A', 'C', 'K', '1'};
+    inline constexpr uint32_t kVersion = 1;
+    inline constexpr size_t kPageSize = 4096;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        uint32_t bucket_count;
+        uint32_t reserved;
+        uint64_t seeds_offset;
+        uint64_t entries_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+        uint64_t total_size;
+    };
+
+    struct Entry {
+        uint64_t body_offset;
+        uint64_t body_len;
+        uint64_t gzip_offset;   // gzip_len == 0 表示没有压缩变体
+        uint64_t gzip_len;
+        int64_t mtime;          // 秒，用于 If-Modified-Since
+        uint32_t uri_offset;    // 以下偏移均相对 strings 区
+        uint32_t uri_len;
+        uint32_t etag_offset;
+        uint32_t etag_len;
+        uint32_t headers_offset;      // 原始内容的响应头块（每行以 \r\n 结尾，不含 Cache-Control，由服务端按 URL 决定）
+        uint32_t headers_len;
+        uint32_t gzip_headers_offset; // gzip 变体的响应头块
+        uint32_t gzip_headers_len;
+    };
+
+    // 种子化的 64 位哈希（FNV-1a + splitmix 混合），打包与查找共用
+    uint64_t hash(std::string_view key, uint64_t seed);
+
+    // 只读资源包，构造后不可变，可在多个 reactor 线程间共享
+    class Pack {
+    public:
+        struct Asset {
+            std::string_view body;
+            std::string_view gzip;          // 为空表示没有压缩变体
+            std::string_view etag;
+            std::string_view headers;
+            std::string_view gzip_headers;
+            int64_t mtime;
+        };
+
+        ~Pack();
+        Pack(const Pack&) = delete;
+        Pack& operator=(const Pack&) = delete;
+
+        // 打开并校验资源包，失败返回 nullptr 并填写 error
+        static std::shared_ptr<const Pack> open(const std::string& path, std::string& error);
+
+        // 无系统调用：哈希 -> 槽位 -> 比较 URI
+        bool find(std::string_view uri, Asset& asset) const;
+
+        size_t size() const { return header_->count; }
+
+        // 当前生效的资源包；部署新包后由服务器在 SIGHUP 时 open + install 整体替换，
+        // 正在发送的响应持有旧包引用直到发送完成
+        static std::shared_ptr<const Pack> current() { return current_.load(std::memory_order_acquire); }
+        static void install(std::shared_ptr<const Pack> pack) { current_.store(std::move(pack), std::memory_order_release); }
+
+    private:
+        Pack() = default;
+
+        const char* base_ = nullptr;
+        size_t size_ = 0;
+        const Header* header_ = nullptr;
+        const uint32_t* seeds_ = nullptr;
+        const Entry* entries_ = nullptr;
+        const char* strings_ = nullptr;
+
+        static inline std::atomic<std::shared_ptr<const Pack>> current_;
+    };
+
+    // 构建期使用：收集资源后一次性写出（先写临时文件再 rename，保证替换是原子的）
+    class Builder {
+    public:
+        void add(std::string uri, std::string content_type, std::string body, int64_t mtime, bool compress);
+        bool write(const std::string& path, std::string& error) const;
+
+    private:
+        struct Item {
+            std::string uri;
+            std::string content_type;
+            std::string body;
+            std::string gzip;
+            int64_t mtime;
+        };
+        std::vector<Item> items_;
+    };
+}
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,71 @@
+#ifndef COMPRESSED_CACHE_H
+#define COMPRESSED_CACHE_H
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "compression.h"
+#include "metrics.h"
+
+/**
+ * @brief 压缩变体缓存：按 (文件身份, 编码) 缓存压缩结果，按字节预算 LRU 淘汰
+ *        未命中时在线程池后台压缩，reactor 线程只做查找，不做 deflate
+ */
+class CompressedCache {
+public:
+    struct Key {
+        dev_t dev;
+        ino_t ino;
+        int64_t mtime_ns;
+        off_t size;
+        Compression::Encoding encoding;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    // 空串表示该文件不可压缩（压缩后不更小），避免反复尝试
+    using Blob = std::shared_ptr<const std::string>;
+
+    static CompressedCache& Instance();
+
+    void init(size_t budget_bytes, int gzip_level, int zstd_level);
+
+    // 命中返回压缩结果，未命中返回 nullptr
+    Blob lookup(const Key& key);
+
+    // 后台压缩文件并放入缓存，同一 key 正在压缩时不重复提交
+    void compressAsync(const Key& key, std::string path);
+
+private:
+    CompressedCache();
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    void insert(const Key& key, Blob blob);
+
+    using Entry = std::pair<Key, Blob>;
+
+    std::mutex mutex_;
+    std::list<Entry> lru_; // 头部最近使用
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    std::unordered_set<Key, KeyHash> inflight_;
+    size_t bytes_ = 0;
+    size_t budget_ = 64 * 1024 * 1024;
+    int gzip_level_ = 6;
+    int zstd_level_ = 3;
+
+    Metrics::Counter& hits_;
+    Metrics::Counter& misses_;
+    Metrics::Counter& bytes_gauge_;
+};
+
+#endif // COMPRESSED_CACHE_H
@@ -0,0 +1,31 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 内容编码：gzip（zlib）与 zstd（可选，编译时检测 WEBSERVER_HAVE_ZSTD）
+ */
+namespace Compression {
+    enum class Encoding { IDENTITY, GZIP, ZSTD };
+
+    // Content-Encoding 取值，IDENTITY 返回空串
+    std::string_view name(Encoding encoding);
+
+    // 预压缩旁路文件后缀（".gz" / ".zst"）
+    std::string_view sidecarSuffix(Encoding encoding);
+
+    bool available(Encoding encoding);
+
+    // 根据 Accept-Encoding 选择编码（q 值最高者，同分时 zstd > gzip），不可用或未声明时返回 IDENTITY
+    Encoding negotiate(std::string_view accept_encoding);
+
+    // 按偏好顺序列出客户端可接受且本进程支持的编码（最多 2 个），返回个数
+    size_t acceptable(std::string_view accept_encoding, Encoding (&out)[2]);
+
+    // 压缩 input 到 out，level <= 0 使用各算法默认级别
+    bool compress(Encoding encoding, std::string_view input, std::string& out, int level = 0);
+}
+
+#endif // COMPRESSION_H
@@ -0,0 +1,91 @@
+#ifndef CONCURRENCY_LIMITER_H
+#define CONCURRENCY_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "metrics.h"
+
+/**
+ * @brief 并发隔离舱（bulkhead）：限制一类请求同时在处理中的数量，超出时立即拒绝而不是排队
+ *        - 固定上限，或开启自适应：按窗口统计延迟，与空载延迟比较估算排队长度（Vegas），
+ *          排队少则放大上限、排队多则缩小；窗口内失败（5xx）达到一成时按比例收缩
+ *        - 在途数与当前上限为原子量，acquire / release 无锁；自适应的窗口统计只在 release 时短暂加锁
+ *        指标：bulkhead_<name>_inflight / _limit / _rejected_total / _latency_us
+ */
+class ConcurrencyLimiter {
+public:
+    struct Options {
+        int limit = 32;          // 固定上限，自适应时为初始值
+        bool adaptive = false;
+        int min_limit = 4;
+        int max_limit = 256;
+        std::chrono::milliseconds window {250}; // 自适应：每个窗口至少这么长、至少 min_samples 个样本
+        int min_samples = 10;
+    };
+
+    // 占用一个并发名额，析构或 release 时归还；release 时记录本次处理的延迟与成败
+    class Permit {
+    public:
+        Permit() = default;
+        Permit(Permit&& other) noexcept : owner_(other.owner_), start_(other.start_) { other.owner_ = nullptr; }
+        Permit& operator=(Permit&& other) noexcept;
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+        ~Permit() { release(false, false); }
+
+        explicit operator bool() const { return owner_ != nullptr; }
+        // failed 表示处理失败（计入自适应收缩）
+        void release(bool failed) { release(true, failed); }
+
+    private:
+        friend class ConcurrencyLimiter;
+        Permit(ConcurrencyLimiter* owner, std::chrono::steady_clock::time_point start)
+            : owner_(owner), start_(start) {}
+        void release(bool sample, bool failed);
+
+        ConcurrencyLimiter* owner_ = nullptr;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    ConcurrencyLimiter(std::string name, const Options& options);
+
+    // 名额已满时返回空的 Permit
+    Permit tryAcquire();
+
+    const std::string& name() const { return name_; }
+    int limit() const { return limit_.load(std::memory_order_relaxed); }
+    int inflight() const { return inflight_.load(std::memory_order_relaxed); }
+
+private:
+    friend class ConcurrencyLimiterTest; // 单元测试直接喂入合成延迟
+
+    void onRelease(std::chrono::steady_clock::duration latency, bool sample, bool failed);
+    void adjust(double avg_latency_us, int max_inflight, bool failing);
+
+    std::string name_;
+    Options options_;
+    std::atomic<int> limit_;
+    std::atomic<int> inflight_ {0};
+
+    // 自适应窗口
+    std::mutex window_mutex_;
+    std::chrono::steady_clock::time_point window_start_;
+    double window_sum_us_ = 0;
+    int window_count_ = 0;
+    int window_max_inflight_ = 0;
+    int window_failures_ = 0;
+    double no_load_us_ = 0;  // 观测到的最小窗口平均延迟，定期重置以跟上环境变化
+    int windows_since_reset_ = 0;
+
+    // metrics
+    Metrics::Counter& inflight_gauge_;
+    Metrics::Counter& limit_gauge_;
+    Metrics::Counter& rejected_;
+    Metrics::Histogram& latency_us_;
+};
+
+#endif // CONCURRENCY_LIMITER_H
@@ -0,0 +1,91 @@
+#ifndef CREDENTIAL_CACHE_H
+#define CREDENTIAL_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.h"
+
+/**
+ * @brief 用户凭据查找缓存：按用户名分片的 TTL 缓存（含“用户不存在”的否定缓存）+ 计数 Bloom 过滤器
+ *        Bloom 过滤器在启动时从数据库装入全部用户名，判定“一定不存在”时不再查询数据库；
+ *        本进程注册新用户时显式失效缓存并加入过滤器（多实例共用一个库时应关闭过滤器）
+ */
+class CredentialCache {
+public:
+    enum class Lookup {
+        Miss,   // 未缓存或已过期
+        Found,  // 用户存在，passwd 为库中保存的凭据
+        Absent, // 用户不存在（否定缓存或 Bloom 过滤器）
+    };
+
+    struct Options {
+        size_t capacity = 100000;                         // 全部分片合计的条目上限
+        std::chrono::milliseconds ttl {60000};
+        std::chrono::milliseconds negative_ttl {5000};
+        size_t bloom_counters = 0;                        // 0 表示不使用 Bloom 过滤器
+        int bloom_hashes = 4;
+    };
+
+    static CredentialCache& Instance();
+
+    void init(const Options& options);
+
+    bool enabled() const { return enabled_; }
+
+    Lookup get(const std::string& username, std::string& passwd);
+
+    void put(const std::string& username, const std::string& passwd);
+    void putAbsent(const std::string& username);
+    void invalidate(const std::string& username);
+
+    // Bloom 过滤器：装载完成前 mayExist 一律返回 true
+    void bloomAdd(std::string_view username);
+    void bloomReady() { bloom_ready_.store(true, std::memory_order_release); }
+    bool mayExist(std::string_view username) const;
+
+private:
+    CredentialCache();
+
+    static constexpr size_t kShards = 16;
+
+    struct Entry {
+        bool exists;
+        std::string passwd;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    Shard& shardOf(const std::string& username);
+    void store(const std::string& username, Entry entry);
+
+    template<typename F>
+    void forEachSlot(std::string_view username, F&& fn) const;
+
+    bool enabled_ = false;
+    Options options_;
+    std::array<Shard, kShards> shards_;
+
+    // 8 位计数器，饱和后不再增加
+    std::unique_ptr<std::atomic<uint8_t>[]> bloom_;
+    std::atomic<bool> bloom_ready_ {false};
+
+    Metrics::Counter& hits_;
+    Metrics::Counter& negative_hits_;
+    Metrics::Counter& misses_;
+    Metrics::Counter& bloom_rejects_;
+};
+
+#endif // CREDENTIAL_CACHE_H
@@ -0,0 +1,71 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 请求截止时间与取消标记
+ *        线程池执行带截止时间的任务时设置当前线程的截止时间，下游（MySQL 等）据此限制等待时长，
+ *        不需要修改处理函数签名逐层传递
+ */
+namespace Deadline {
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    constexpr TimePoint kNone = TimePoint::max();
+
+    // 取消标记：由请求所属的连接持有，连接关闭 / 超时 / 槽位复用时置位
+    class CancelToken {
+    public:
+        static CancelToken create() {
+            CancelToken token;
+            token.flag_ = std::make_shared<std::atomic<bool>>(false);
+            return token;
+        }
+
+        void cancel() const {
+            if (flag_) {
+                flag_->store(true, std::memory_order_release);
+            }
+        }
+
+        bool cancelled() const { return flag_ && flag_->load(std::memory_order_acquire); }
+
+        explicit operator bool() const { return flag_ != nullptr; }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> flag_;
+    };
+
+    inline thread_local TimePoint tls_current = kNone;
+
+    // 当前线程正在处理的请求的截止时间，没有则为 kNone
+    inline TimePoint current() { return tls_current; }
+
+    // 剩余毫秒数：没有截止时间返回 -1，已过期返回 0
+    inline int64_t remainingMs() {
+        if (tls_current == kNone) {
+            return -1;
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(tls_current - Clock::now()).count();
+        return left > 0 ? left : 0;
+    }
+
+    // 作用域内设置当前线程的截止时间，退出时恢复
+    class Scope {
+    public:
+        explicit Scope(TimePoint deadline) : saved_(tls_current) { tls_current = deadline; }
+        ~Scope() { tls_current = saved_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TimePoint saved_;
+    };
+}
+
+#endif // DEADLINE_H
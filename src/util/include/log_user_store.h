@@ -0,0 +1,108 @@
+#ifndef LOG_USER_STORE_H
+#define LOG_USER_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.h"
+#include "user_store.h"
+
+/**
+ * @brief 进程内嵌的用户存储：分片哈希索引常驻内存，写入追加到日志文件，定期生成快照截断日志
+ *        - 写入先在索引中占住用户名（判重）再追加日志，后台刷写线程把攒下的记录一次 write + fdatasync（组提交），
+ *          注册请求等到自己的记录落盘后才对查找可见并返回；刷写失败后存储进入只读，之后的写入抛出 DatabaseUnavailable
+ *        - 日志超过 snapshot_bytes 时轮转：当前日志改名为 users.log.old，写新日志的同时把整个索引写成快照
+ *          （临时文件 + rename，只含已落盘的记录），完成后删除旧日志
+ *        - 启动时依次回放 users.snap、users.log.old、users.log；记录带 CRC，日志尾部写了一半的记录被截掉
+ */
+class LogUserStore : public UserStore {
+public:
+    struct Options {
+        std::string dir = "data";
+        size_t shards = 64;
+        bool fsync = true;                 // false 时注册不等落盘，只保证进程崩溃不丢（交给页缓存）
+        size_t snapshot_bytes = 64 << 20;  // 0 表示不自动快照
+    };
+
+    explicit LogUserStore(Options options);
+    ~LogUserStore() override;
+
+    bool init() override;
+
+    InsertResult insert(const std::string& username, const std::string& password) override;
+    FindResult find(const std::string& username, std::string& passwd) override;
+    bool forEachUsername(const std::function<void(std::string_view)>& fn) override;
+
+    bool remote() const override { return false; }
+    const char* name() const override { return "embedded"; }
+
+    // 立即轮转日志并生成快照
+    bool snapshot();
+
+    size_t size() const;
+
+private:
+    // 已追加日志、等待落盘的注册：参与判重，对查找不可见
+    struct PendingUser {
+        std::string passwd;
+        uint64_t seq = 0; // 日志序号，durable_seq_ 达到后即已落盘
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::string> users;
+        std::unordered_map<std::string, PendingUser> pending;
+    };
+
+    Shard& shardOf(std::string_view username);
+    const Shard& shardOf(std::string_view username) const;
+    bool indexInsert(std::string_view username, std::string_view password);
+    // 落盘后把等待中的注册移入索引；失败时丢弃
+    void publish(std::string_view username);
+    void discardPending(std::string_view username);
+
+    // 回放一个文件；truncate_tail 时把损坏 / 不完整的尾部截掉（只用于当前日志）
+    bool replay(const std::string& file, bool truncate_tail);
+    void flushLoop();
+    void snapshotLoop();
+    // 写入索引与 seq 不超过 durable_seq 的等待中注册（它们已在被轮转的日志里）
+    bool writeSnapshot(uint64_t durable_seq);
+
+    std::string path(const char* name) const { return options_.dir + "/" + name; }
+
+    Options options_;
+    std::vector<Shard> shards_;
+
+    std::mutex log_mutex_;
+    std::condition_variable pending_cond_; // 刷写线程等待新记录
+    std::condition_variable durable_cond_; // 写入方等待落盘 / 轮转等待当前写入结束
+    std::string pending_;                  // 已编码未写出的记录
+    uint64_t appended_seq_ = 0;
+    uint64_t durable_seq_ = 0;
+    bool writing_ = false;
+    bool broken_ = false;
+    bool stopping_ = false;
+    int log_fd_ = -1;
+    size_t log_bytes_ = 0;
+    std::thread flusher_;
+
+    // 快照在单独的线程里写，不阻塞组提交
+    std::mutex snapshot_mutex_;
+    std::condition_variable snapshot_cond_;
+    bool snapshot_requested_ = false;
+    std::thread snapshotter_;
+
+    // metrics
+    Metrics::Histogram& flush_bytes_;
+    Metrics::Histogram& fsync_us_;
+    Metrics::Counter& snapshots_;
+};
+
+#endif // LOG_USER_STORE_H
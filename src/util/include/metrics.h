@@ -0,0 +1,70 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief 进程内指标：无锁计数器 / 直方图，注册表只在初始化时加锁
+ *        热路径持有 Counter& / Histogram& 引用，只做原子加
+ */
+namespace Metrics {
+    class Counter {
+    public:
+        void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+        void set(uint64_t n) { value_.store(n, std::memory_order_relaxed); }
+        uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_ {0};
+    };
+
+    // log2 分桶直方图，单位由调用方决定（一般为微秒）
+    class Histogram {
+    public:
+        static constexpr size_t kBuckets = 40;
+
+        void record(uint64_t value);
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+        uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+        // 近似分位数（返回所在桶的上界）
+        uint64_t percentile(double p) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> buckets_ {};
+        std::atomic<uint64_t> count_ {0};
+        std::atomic<uint64_t> sum_ {0};
+        std::atomic<uint64_t> max_ {0};
+    };
+
+    class Registry {
+    public:
+        static Registry& Instance();
+
+        // 同名返回同一实例，引用在进程生命周期内有效
+        Counter& counter(const std::string& name);
+        Histogram& histogram(const std::string& name);
+
+        // 文本格式导出（供 /metrics 与日志使用）
+        std::string dump() const;
+
+    private:
+        Registry() = default;
+
+        mutable std::mutex mutex_;
+        std::map<std::string, std::unique_ptr<Counter>> counters_;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+    };
+
+    inline Counter& counter(const std::string& name) { return Registry::Instance().counter(name); }
+    inline Histogram& histogram(const std::string& name) { return Registry::Instance().histogram(name); }
+}
+
+#endif // METRICS_H
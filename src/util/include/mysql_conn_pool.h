@@ -2,56 +2,123 @@
 #define MYSQL_CONN_POOL_H
 
 #include "mysql_connection.h"
-#include <string>
-#include <queue>
-#include <deque>
-#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "logger.h"
+#include "metrics.h"
 
 // RAII方式使用连接
 class MySQLConnectionGuard {
 public:
-    explicit MySQLConnectionGuard(MySQLConnection* conn) : conn_(conn) {}
+    MySQLConnectionGuard(MySQLConnection* conn, size_t shard) : conn_(conn), shard_(shard) {}
     ~MySQLConnectionGuard();
-    
+
     MySQLConnection* get() { return conn_; }
-    
+
 private:
     MySQLConnection* conn_;
+    size_t shard_;
 };
 
+/**
+ * @brief MySQL 连接池
+ *        空闲连接按分片存放（可配置为每个线程固定一个分片，消除跨核争用），连接总数全局计数；
+ *        获取有超时，熔断打开时立即失败；后台线程校验空闲连接、回收长时间空闲的连接并预热到最小连接数
+ */
 class MySQLConnectionPool {
 public:
     static MySQLConnectionPool& Instance();
-    
+
     // 从ConfigManager获取配置并初始化连接池
     bool init();
-              
-    // 获取连接（返回RAII管理对象）
+
+    // 获取连接（返回RAII管理对象）：本线程的分片优先，再从其他分片取，都没有且未达上限时新建；
+    // 最多等待 acquire_timeout（有请求截止时间时取较早者），超时或熔断打开返回 nullptr
     std::shared_ptr<MySQLConnectionGuard> getConnection();
-    void releaseConnection(MySQLConnection* conn);
-    
+    void releaseConnection(MySQLConnection* conn, size_t shard);
+
+    // 按池的配置创建一个新的连接（阻塞握手，失败返回 nullptr）；不计入本池，由调用方持有。结果计入熔断器
+    MySQLConnection* createConnection();
+
+    // 熔断器未打开（或冷却结束可以试探），即数据库被认为可用
+    bool available() const;
+
 private:
-    MySQLConnectionPool() = default;
+    MySQLConnectionPool();
     ~MySQLConnectionPool();
-    
-    // 创建一个新的连接
-    MySQLConnection* createConnection();
-    
+
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConn {
+        MySQLConnection* conn;
+        Clock::time_point last_used;
+        Clock::time_point last_checked;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<IdleConn> idle; // 尾部最近归还
+        std::atomic<int> waiters {0}; // 归还方跨分片无锁查看
+    };
+
+    size_t localShard();
+    MySQLConnection* takeIdle(size_t index, bool blocking);
+    void discard(MySQLConnection* conn);
+
+    // 熔断器：连续失败达到阈值后打开 cooldown 时长，之后只放行一个试探请求
+    bool allowRequest();
+    void reportSuccess();
+    void reportFailure();
+
+    void maintain();
+    void maintainOnce();
+
     std::string host_;
     std::string user_;
     std::string pwd_;
     std::string db_name_;
     unsigned int port_;
-    
-    int max_conn_;
-    int curr_conn_;
-    
-    std::queue<MySQLConnection*, std::deque<MySQLConnection*>> conn_queue_;
-    std::mutex mutex_;
-    std::condition_variable cond_;
+    unsigned int connect_timeout_;
+    unsigned int read_timeout_;
+    unsigned int write_timeout_;
+
+    int max_conn_ = 8;
+    int min_idle_ = 2;
+    std::chrono::milliseconds acquire_timeout_ {1000};
+    std::chrono::milliseconds idle_timeout_ {60000};
+    std::chrono::milliseconds check_interval_ {5000};
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<int> total_ {0}; // 已建立（含借出、握手中）的连接数
+    std::atomic<size_t> next_shard_ {0};
+
+    int breaker_threshold_ = 5;
+    std::chrono::milliseconds breaker_cooldown_ {5000};
+    std::atomic<int> failures_ {0};
+    std::atomic<int64_t> open_until_ns_ {0};
+    std::atomic<bool> probing_ {false};
+
+    std::thread maintainer_;
+    std::mutex maintain_mutex_;
+    std::condition_variable maintain_cond_;
+    bool running_ = false;
+
+    // metrics
+    Metrics::Histogram& acquire_wait_us_;
+    Metrics::Counter& acquire_timeouts_;
+    Metrics::Counter& breaker_rejects_;
+    Metrics::Counter& breaker_opened_;
+    Metrics::Counter& broken_;
+    Metrics::Counter& reaped_;
+    Metrics::Counter& connections_;
 };
 
-#endif // MYSQL_CONN_POOL_H
\ No newline at end of file
+#endif // MYSQL_CONN_POOL_H
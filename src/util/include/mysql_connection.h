@@ -2,7 +2,13 @@
 #define MYSQL_CONNECTION_H
 
 #include <mysql/mysql.h>
+#include <functional>
+#include <initializer_list>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "logger.h"
 
 class MySQLConnection {
@@ -10,6 +16,9 @@ public:
     MySQLConnection();
     ~MySQLConnection();
     
+    // 连接前设置超时（秒），read/write 同时作为无截止时间查询的默认超时
+    void setTimeouts(unsigned int connect_timeout, unsigned int read_timeout, unsigned int write_timeout);
+
     bool connect(const std::string& host, 
                 const std::string& user,
                 const std::string& pwd, 
@@ -23,9 +32,53 @@ public:
     MYSQL_ROW fetchRow();
     MYSQL* getRawConn() { return conn_; }
 
+    // 服务端预处理语句：按 SQL 文本在本连接上缓存，首次使用时 prepare，之后每次只发送参数（二进制协议，无需转义）
+    // 参数均按字符串绑定；失败时 stmtErrorCode() 给出错误码（如 1062 唯一索引冲突）
+    bool execPrepared(const std::string& sql, std::initializer_list<std::string_view> params) {
+        return execPrepared(sql, std::span<const std::string_view>(params.begin(), params.size()));
+    }
+    bool execPrepared(const std::string& sql, std::span<const std::string_view> params);
+    // 执行预处理查询，取第一行第一列；没有结果行返回 false，此时 stmtErrorCode() 为 0
+    bool queryPrepared(const std::string& sql, std::initializer_list<std::string_view> params, std::string& value);
+    // 执行预处理查询，取所有行的第一列追加到 values；查询失败返回 false
+    bool queryPreparedColumn(const std::string& sql, std::span<const std::string_view> params,
+                             std::vector<std::string>& values);
+    unsigned int stmtErrorCode() const { return stmt_errno_; }
+
+    // 往返一次确认连接可用（空闲校验）
+    bool ping() { return mysql_ping(conn_) == 0; }
+    // 最近一次调用遇到客户端 / 网络错误，连接不可再用
+    bool broken() const { return isClientError(errorCode()) || isClientError(stmt_errno_); }
+    // 2000~2999 为客户端库错误（断连、超时、协议错乱），服务端错误码不在此范围
+    static bool isClientError(unsigned int code) { return code >= 2000 && code < 3000; }
+
+    // 非阻塞接口（libmysqlclient 8.0.16+）：返回 NET_ASYNC_NOT_READY 时等 socketFd() 可读后用相同参数再次调用，
+    // 直到 NET_ASYNC_COMPLETE / NET_ASYNC_ERROR；调用方负责等待与超时，这里不做阻塞等待
+    net_async_status queryNonBlocking(const std::string& sql);
+    // 查询完成后取结果集，结果经 getResult / fetchRow 读取
+    net_async_status storeResultNonBlocking();
+    int socketFd() const { return conn_->net.fd; }
+    // 最近一次调用的错误码，客户端 / 网络错误见 isClientError（连接状态不可再用）
+    unsigned int errorCode() const { return mysql_errno(conn_); }
+    unsigned int readTimeout() const { return read_timeout_; }
+
 private:
+    // 当前线程有截止时间（线程池中的在线请求）时把剩余时间设为本次查询的读写超时，已超时返回 false
+    bool applyDeadline();
+
+    MYSQL_STMT* prepare(const std::string& sql);
+    bool executeStmt(const std::string& sql, MYSQL_STMT* stmt, std::span<const std::string_view> params);
+    // 逐行取第一列交给 row，row 返回 false 时停止
+    bool fetchColumn(MYSQL_STMT* stmt, const std::function<bool(std::string_view)>& row);
+
     MYSQL* conn_;
     MYSQL_RES* result_;
+    unsigned int read_timeout_ = 0;  // 0 表示使用客户端库默认值
+    unsigned int write_timeout_ = 0;
+    unsigned int applied_timeout_ = 0; // 当前生效的按截止时间收紧的超时，0 表示默认
+
+    std::unordered_map<std::string, MYSQL_STMT*> stmts_;
+    unsigned int stmt_errno_ = 0;
 };
 
 #endif // MYSQL_CONNECTION_H
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef MYSQL_USER_STORE_H
+#define MYSQL_USER_STORE_H
+
+#include <string>
+
+#include "mysql_connection.h"
+#include "user_store.h"
+
+// MySQL 后端：阻塞连接池 + 预处理语句，insertAsync 的注册写入合并为批量事务（见 RegisterBatcher）
+class MySQLUserStore : public UserStore {
+public:
+    bool init() override;
+
+    InsertResult insert(const std::string& username, const std::string& password) override;
+    void insertAsync(const std::string& username, const std::string& password, InsertDone done) override;
+    bool batchesInserts() const override;
+    FindResult find(const std::string& username, std::string& passwd) override;
+    bool forEachUsername(const std::function<void(std::string_view)>& fn) override;
+
+    bool remote() const override { return true; }
+    const char* name() const override { return "mysql"; }
+
+    // 非阻塞客户端没有预处理语句接口，reactor 上的异步路径使用转义后的文本 SQL；字符串按 conn 的字符集转义
+    static std::string verifySql(MySQLConnection& conn, const std::string& username);
+    static std::string insertSql(MySQLConnection& conn, const std::string& username, const std::string& password);
+
+    // username 唯一索引冲突（ER_DUP_ENTRY）
+    static constexpr unsigned int kDuplicateEntry = 1062;
+
+private:
+    static std::string escapeString(MySQLConnection& conn, const std::string& str);
+};
+
+#endif // MYSQL_USER_STORE_H
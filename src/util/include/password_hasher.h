@@ -0,0 +1,72 @@
+#ifndef PASSWORD_HASHER_H
+#define PASSWORD_HASHER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "metrics.h"
+#include "threadpool.h"
+
+// 哈希线程池排队已满，请求被丢弃，HTTP 层返回 503
+class HasherOverloaded : public std::runtime_error {
+public:
+    HasherOverloaded() : std::runtime_error("password hash pool is full") {}
+};
+
+/**
+ * @brief 加盐口令哈希（scrypt），在独立的有界线程池上计算，不占用 reactor 与通用计算线程
+ *        存储格式 $scrypt$ln=<log2 N>,r=<r>,p=<p>$<salt base64>$<hash base64>，参数随哈希保存，调整开销不影响已有用户；
+ *        不以 $scrypt$ 开头的旧数据按明文比较
+ */
+class PasswordHasher {
+public:
+    struct Options {
+        size_t threads = 2;
+        size_t max_pending = 64; // 排队 + 执行中的上限，超出直接拒绝
+        int log_n = 14;          // N = 2^log_n，内存约 128 * r * N 字节
+        int r = 8;
+        int p = 1;
+    };
+
+    // 占用一个排队名额，析构时归还
+    class Ticket {
+    public:
+        explicit Ticket(PasswordHasher& owner) : owner_(&owner) {}
+        Ticket(Ticket&& other) noexcept : owner_(other.owner_) { other.owner_ = nullptr; }
+        Ticket& operator=(Ticket&&) = delete;
+        ~Ticket();
+
+    private:
+        PasswordHasher* owner_;
+    };
+
+    static PasswordHasher& Instance();
+
+    void init(const Options& options);
+
+    // 取排队名额，已满时抛出 HasherOverloaded
+    Ticket admit();
+
+    // 在当前线程计算，只在哈希线程池上调用：reactor 经 Coro::offload(pool(), ...) 挂起等待，不阻塞在 future 上
+    std::string hashNow(std::string_view password);
+    bool verifyNow(std::string_view password, std::string_view stored);
+
+    FThreadPool& pool();
+
+private:
+    PasswordHasher();
+
+    Options options_;
+    std::unique_ptr<FThreadPool> pool_;
+    std::atomic<size_t> pending_ {0};
+
+    // metrics
+    Metrics::Histogram& hash_us_;
+    Metrics::Counter& shed_;
+};
+
+#endif // PASSWORD_HASHER_H
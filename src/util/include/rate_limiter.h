@@ -0,0 +1,89 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.h"
+
+/**
+ * @brief 按客户端 IPv4 地址限流
+ *        - 请求速率：令牌桶，每个 reactor 线程一张固定大小的表（thread_local，无锁、无分配），
+ *          表按 64 字节缓存行分组，每组 4 路组相联，满时淘汰组内最久未访问的地址；
+ *          同一客户端的连接分布在几个 reactor 上时，每个 reactor 各自按完整额度放行
+ *        - 登录 / 注册另有一个更严格的桶，与普通请求互不消耗
+ *        - 并发连接数：accept 时计数，超过上限直接关闭，连接销毁时归还（分片互斥表，跨线程）
+ *        地址为网络字节序（sockaddr_in::sin_addr.s_addr）
+ */
+class RateLimiter {
+public:
+    enum class Bucket { Default, Credential };
+
+    struct Options {
+        bool enabled = false;
+        uint32_t rate = 500;           // 每秒补充的令牌数，0 表示不限速
+        uint32_t burst = 1000;         // 桶容量
+        uint32_t credential_rate = 5;
+        uint32_t credential_burst = 10;
+        uint32_t max_connections = 0;  // 每个地址的并发连接上限，0 表示不限
+        size_t table_sets = 4096;      // 每个 reactor 的组数（向上取 2 的幂），可跟踪 4 倍于此的地址
+        std::vector<uint32_t> exempt;  // 不受限制的地址（本机探活、反向代理）
+    };
+
+    static RateLimiter& Instance();
+
+    // 必须在 reactor 线程开始处理请求前调用
+    void init(const Options& options);
+
+    bool enabled() const { return options_.enabled; }
+
+    // 从调用线程的令牌桶取一个令牌，不足时返回 false
+    bool allow(uint32_t addr, Bucket bucket);
+
+    // accept 时占用一个连接名额，超过上限返回 false；成功占用的连接关闭时调用 releaseConnection
+    bool acquireConnection(uint32_t addr);
+    void releaseConnection(uint32_t addr);
+
+private:
+    RateLimiter();
+
+    struct Entry {
+        uint32_t addr;     // 0 表示空位
+        uint32_t stamp_ms; // 上次补充的时刻（相对 epoch_，回绕安全）
+        float tokens;
+        float credential_tokens;
+    };
+
+    struct alignas(64) Set {
+        std::array<Entry, 4> entries;
+    };
+
+    struct alignas(64) ConnShard {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, uint32_t> counts;
+    };
+
+    static constexpr size_t kConnShards = 16;
+
+    bool exempt(uint32_t addr) const;
+    Set& setOf(uint32_t addr);
+    ConnShard& connShardOf(uint32_t addr) { return conn_shards_[(addr * 0x9E3779B1u) >> 28]; }
+
+    Options options_;
+    uint32_t set_bits_ = 0;
+    float rate_per_ms_ = 0;
+    float credential_rate_per_ms_ = 0;
+    std::chrono::steady_clock::time_point epoch_;
+    std::array<ConnShard, kConnShards> conn_shards_;
+
+    // metrics
+    Metrics::Counter& limited_;
+    Metrics::Counter& credential_limited_;
+    Metrics::Counter& connection_limited_;
+};
+
+#endif // RATE_LIMITER_H
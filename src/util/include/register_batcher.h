@@ -0,0 +1,72 @@
+#ifndef REGISTER_BATCHER_H
+#define REGISTER_BATCHER_H
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+
+/**
+ * @brief 注册写入合并（group commit）
+ *        提交不阻塞：行进入队列后立即返回，结果经完成回调交还（协程调用方挂起等待，不占用线程）。
+ *        同一时刻只有一批在写：空闲时第一行立即在线程池上开始刷写，刷写期间到达的行排队，
+ *        上一批写完后由同一个任务取走下一批（每批不超过 max_rows，一个事务、一条多行 INSERT），
+ *        批大小随并发自然增长，低负载时不为等待时间窗口增加延迟
+ */
+class RegisterBatcher {
+public:
+    enum class Result {
+        Created,
+        Duplicate, // 用户已存在（库中已有，或同一批中更早的一行）
+        Failed,
+    };
+
+    struct Row {
+        std::string_view username;
+        std::string_view password;
+        Result result = Result::Failed;
+    };
+
+    // 写入一批并填好每行的 result；抛出的异常交给这一批的每个请求
+    using Flush = std::function<void(std::span<Row* const> rows)>;
+    // 在刷写线程上调用；error 非空时 result 无意义
+    using Done = std::function<void(Result result, std::exception_ptr error)>;
+
+    static RegisterBatcher& Instance();
+
+    // max_rows 为 0 表示不合并
+    void init(size_t max_rows, Flush flush);
+
+    bool enabled() const { return max_rows_ > 0 && flush_ != nullptr; }
+
+    // username / password 须保持有效直到 done 被调用
+    void submit(std::string_view username, std::string_view password, Done done);
+
+private:
+    RegisterBatcher();
+
+    struct Pending {
+        Row row;
+        Done done;
+    };
+
+    // 线程池任务：逐批刷写直到队列为空
+    void drain();
+
+    size_t max_rows_ = 0;
+    Flush flush_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Pending>> queue_;
+    bool flushing_ = false;
+
+    Metrics::Histogram& batch_rows_;
+};
+
+#endif // REGISTER_BATCHER_H
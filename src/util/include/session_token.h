@@ -0,0 +1,71 @@
+#ifndef SESSION_TOKEN_H
+#define SESSION_TOKEN_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+
+/**
+ * @brief 无状态会话令牌：<kid>.<过期时间>.<用户名 base64url>.<HMAC-SHA256 base64url>
+ *        - 签名覆盖前三段，校验只做一次 HMAC 与常量时间比较，不访问任何存储
+ *        - 密钥环按 kid 区分：用当前密钥签发，环内任一密钥都可校验；轮换时先加入新密钥并切换签发，
+ *          旧密钥保留到已签发令牌全部过期后再移除
+ *        - 每个密钥预先算好 ipad / opad 之后的 SHA-256 中间状态，单次校验只压缩 3~4 个分组
+ */
+class SessionToken {
+public:
+    enum class Result { Valid, Expired, Invalid };
+
+    struct Key {
+        std::string id;     // 只允许 [A-Za-z0-9_-]，出现在令牌里
+        std::string secret;
+    };
+
+    static SessionToken& Instance();
+
+    // 替换整个密钥环（可在运行中调用），active_id 必须在 keys 中；keys 为空时生成进程内随机密钥（重启后会话失效）
+    bool setKeys(const std::vector<Key>& keys, const std::string& active_id);
+    void setTtl(int seconds) { ttl_ = seconds; }
+    int ttl() const { return ttl_; }
+    // Cookie 名与 Secure 属性（仅 HTTPS 前置时开启）
+    void setCookie(std::string name, bool secure) {
+        cookie_name_ = std::move(name);
+        cookie_secure_ = secure;
+    }
+
+    // 为用户签发令牌，有效期 ttl 秒
+    std::string issue(std::string_view username) const;
+    Result verify(std::string_view token, std::string* username = nullptr) const;
+
+    // 登录成功时的 Set-Cookie 值（HttpOnly、SameSite=Lax，Max-Age 与令牌有效期一致）
+    std::string setCookieValue(std::string_view username) const;
+    // 登出：立即过期的 Set-Cookie 值
+    std::string clearCookieValue() const;
+    // 从请求的 Cookie 头中取出令牌，没有时返回空
+    std::string_view findCookie(std::string_view cookie_header) const;
+
+    // 解析 "kid:secret,kid:secret" 形式的密钥配置
+    static std::vector<Key> parseKeys(std::string_view spec);
+
+private:
+    struct KeyState;
+    struct KeyRing;
+
+    SessionToken();
+
+    std::atomic<std::shared_ptr<const KeyRing>> ring_;
+    int ttl_ = 86400;
+    std::string cookie_name_ = "sid";
+    bool cookie_secure_ = false;
+
+    // metrics
+    Metrics::Counter& issued_;
+    Metrics::Counter& rejected_;
+};
+
+#endif // SESSION_TOKEN_H
@@ -6,14 +6,22 @@
 #define THREADPOOL_H
 
 #pragma once
-#include <complex>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "deadline.h"
+#include "metrics.h"
+
 class NoCopy {
 public:
     ~NoCopy() = default;
@@ -26,6 +34,97 @@ protected:
 private:
 };
 
+/**
+ * @brief 只可移动的任务，签名 void(size_t threadId)
+ *        不超过 kInlineSize 且 noexcept 可移动的可调用对象直接存放在内部缓冲区，不分配堆内存
+ */
+class PoolTask {
+public:
+    static constexpr size_t kInlineSize = 96;
+
+    PoolTask() = default;
+
+    template<typename F>
+        requires(!std::same_as<std::decay_t<F>, PoolTask> && std::invocable<std::decay_t<F> &, size_t>)
+    PoolTask(F &&fn) { // NOLINT(google-explicit-constructor)
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            ::new (static_cast<void *>(buf_)) Fn(std::forward<F>(fn));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn **>(buf_) = new Fn(std::forward<F>(fn));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    PoolTask(PoolTask &&other) noexcept { take(other); }
+
+    PoolTask &operator=(PoolTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    PoolTask(const PoolTask &) = delete;
+    PoolTask &operator=(const PoolTask &) = delete;
+
+    ~PoolTask() { reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()(size_t threadId) { ops_->invoke(buf_, threadId); }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(buf_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void *, size_t);
+        void (*relocate)(void *from, void *to) noexcept;
+        void (*destroy)(void *) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr Ops kInlineOps {
+        [](void *p, size_t id) { (*static_cast<Fn *>(p))(id); },
+        [](void *from, void *to) noexcept {
+            ::new (to) Fn(std::move(*static_cast<Fn *>(from)));
+            static_cast<Fn *>(from)->~Fn();
+        },
+        [](void *p) noexcept { static_cast<Fn *>(p)->~Fn(); },
+    };
+
+    template<typename Fn>
+    static constexpr Ops kHeapOps {
+        [](void *p, size_t id) { (**static_cast<Fn **>(p))(id); },
+        [](void *from, void *to) noexcept { *static_cast<Fn **>(to) = *static_cast<Fn **>(from); },
+        [](void *p) noexcept { delete *static_cast<Fn **>(p); },
+    };
+
+    void take(PoolTask &other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.buf_, buf_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char buf_[kInlineSize];
+    const Ops *ops_ = nullptr;
+};
+
+/**
+ * @brief 工作窃取线程池
+ *        每个工作线程一个 Chase–Lev 双端队列（本线程从底部压入/弹出，其他线程从顶部窃取），
+ *        外部线程提交的任务进入无锁 MPMC 注入队列；空闲线程先自旋若干轮再休眠
+ */
 class FThreadPool : private NoCopy {
 public:
     explicit FThreadPool(size_t threadCount = std::thread::hardware_concurrency());
@@ -34,61 +133,101 @@ public:
 
     static FThreadPool &getInst();
 
+    // 独立的磁盘 I/O 线程池（预读等可能阻塞在磁盘上的任务），不占用计算线程
+    static FThreadPool &getIoInst();
+
     size_t getThreadCnt() const { return threadCnt_; }
 
+    // 任务签名 void(size_t threadId)；在本池的工作线程内提交时进入该线程自己的队列
     template<typename F>
-    void pushTask(const F &task) {
-        {
-            const std::lock_guard<std::mutex> lock(mutex_);
-            tasks_.push(std::function<void(size_t)>(task));
-            ++tasksCnt_;
-        }
-        condition_.notify_one(); // 补全通知
+        requires std::invocable<std::decay_t<F> &, size_t>
+    void pushTask(F &&task) {
+        submit(PoolTask(std::forward<F>(task)));
     }
 
-    // 只有当 task 是 可移动或一次性 lambda 时，缺少 std::forward 会 无法调用移动构造/移动 operator()
+    // 带参数 / 返回值的任务，通过 future 取结果
     template<typename F, typename... Args>
-    auto pushTask(F &&task,
-                  Args &&...args) -> std::future<decltype(std::forward<F>(task)(std::forward<Args>(args)...))> {
-        using RetType = decltype(std::forward<F>(task)(std::forward<Args>(args)...));
-        // std::packaged_task<>的模板参数是函数签名
-        using Task = std::packaged_task<RetType()>;
+    auto pushTask(F &&task, Args &&...args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using RetType = std::invoke_result_t<F, Args...>;
         if (!running_)
             return {};
 
-        auto pkg_task = std::make_shared<Task>(std::bind(std::forward<F>(task), std::forward<Args>(args)...));
-        auto&& ret = pkg_task->get_future();
+        std::packaged_task<RetType()> pkg_task(
+            [fn = std::forward<F>(task), ... args = std::forward<Args>(args)]() mutable {
+                return std::invoke(std::move(fn), std::move(args)...);
+            });
+        auto ret = pkg_task.get_future();
+        submit(PoolTask([pkg_task = std::move(pkg_task)](size_t) mutable { pkg_task(); }));
+        return ret;
+    }
 
-        pushTask([pkg_task](const size_t threadId) {
-            // printf("Task %llu working\n", threadId);
-            (*pkg_task)();
-        });
-        condition_.notify_one();
-        return std::move(ret);
+    // 带截止时间的任务：优先于普通任务、按截止时间最早优先调度；开始执行前已取消或已过期则丢弃，
+    // 改为执行 onDrop（由调用方给出降级响应）；执行期间 Deadline::current() 返回该截止时间
+    template<typename F, typename D>
+        requires std::invocable<std::decay_t<F> &, size_t> && std::invocable<std::decay_t<D> &, size_t>
+    void pushDeadlineTask(Deadline::TimePoint deadline, Deadline::CancelToken token, F &&task, D &&onDrop) {
+        submitDeadline(deadline, std::move(token), PoolTask(std::forward<F>(task)), PoolTask(std::forward<D>(onDrop)));
     }
 
+    // 等待所有已提交的任务执行完毕
     void waitTasksFinish() const;
 
 private:
-    size_t tasksQueuedCnt() const;
-    size_t tasksRunningCnt() const { return tasksCnt_ - tasksQueuedCnt(); }
-
+    class WorkDeque;
+    class InjectQueue;
+
+    struct DeadlineTask {
+        Deadline::TimePoint deadline;
+        uint64_t seq = 0;
+        Deadline::CancelToken token;
+        Deadline::TimePoint enqueued;
+        PoolTask task;
+        PoolTask on_drop;
+    };
+
+    void submit(PoolTask &&task);
+    void submitDeadline(Deadline::TimePoint deadline, Deadline::CancelToken token, PoolTask &&task, PoolTask &&onDrop);
+    bool takeDeadlineTask(DeadlineTask &out);
+    void runDeadlineTask(size_t threadId, DeadlineTask &timed);
+    bool findTask(size_t threadId, uint64_t &rng, PoolTask &task);
+    bool hasWork() const;
+    void park();
+    void wakeOne();
 
     void worker(size_t threadId);
-    // void manager()
 
 private:
-    mutable std::mutex mutex_;
-    mutable std::condition_variable condition_;
     std::atomic<bool> running_{true};
-    std::atomic<bool> paused_{false};
 
     std::vector<std::thread> threads_;
-    std::atomic<size_t> threadCnt_{0};
-    std::atomic<size_t> runningThreadCount_{0};
-
-    std::queue<std::function<void(size_t)>> tasks_ = {};
-    std::atomic<size_t> tasksCnt_{0};
+    size_t threadCnt_{0};
+
+    std::vector<std::unique_ptr<WorkDeque>> deques_;
+    std::unique_ptr<InjectQueue> injected_;
+
+    // 注入队列满时的兜底队列（极少使用）
+    std::mutex overflow_mutex_;
+    std::vector<PoolTask> overflow_;
+    std::atomic<size_t> overflow_size_{0};
+
+    // 休眠 / 唤醒：没有线程在自旋且 sleepers_ 为正时，提交方推进 epoch_ 并唤醒一个线程
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<uint32_t> spinning_{0};
+
+    // 截止时间任务：最小堆（截止时间早者在堆顶），数量很少，一把锁足够
+    std::mutex deadline_mutex_;
+    std::vector<DeadlineTask> deadline_heap_;
+    std::atomic<size_t> deadline_size_{0};
+    uint64_t deadline_seq_{0};
+
+    // 已提交但尚未执行完的任务数
+    std::atomic<size_t> pending_{0};
+
+    // metrics（截止时间任务）
+    Metrics::Histogram &deadline_wait_us_;
+    Metrics::Counter &deadline_expired_;
+    Metrics::Counter &deadline_cancelled_;
 };
 
 #endif // THREADPOOL_H
@@ -3,28 +3,45 @@
 
 #include <string>
 #include <memory>
-#include "mysql_conn_pool.h"
+#include "credential_cache.h"
+#include "user_store.h"
 
 class UserService {
 public:
     static UserService& Instance();
     
-    // 初始化服务（连接池已经在mysql_conn_pool中初始化）
+    // 按 user_store.backend 选择存储后端（mysql / embedded）并初始化，同时初始化口令哈希线程池
     bool init();
     
-    // 用户注册
-    bool registerUser(const std::string& username, const std::string& password);
-    
-    // 用户登录
-    bool verifyUser(const std::string& username, const std::string& password);
-    
-    // 检查用户是否存在
-    bool userExists(const std::string& username);
+    // 以下操作只做存储 I/O（不计算口令哈希），存储不可用（熔断打开 / 取连接超时 / 本地日志写入失败）时抛出 DatabaseUnavailable；
+    // 会阻塞在取连接 / 查询 / 等待落盘上，须在通用线程池上带请求截止时间调用，哈希另在哈希线程池上计算
+
+    // 用户注册：保存已计算好的加盐哈希，依赖存储的用户名唯一约束判重；成功后更新缓存与 Bloom 过滤器
+    UserStore::InsertResult insertUser(const std::string& username, const std::string& hashed);
+    // 后端合并注册写入时（见 RegisterBatcher）改用 insertUserAsync：不阻塞，结果在写入线程上经 done 交还
+    bool batchesInserts() const { return store_ && store_->batchesInserts(); }
+    void insertUserAsync(const std::string& username, const std::string& hashed, UserStore::InsertDone done);
+
+    // 用户登录：查存储取保存的口令哈希并回填缓存（调用方先查 cachedCredential，未命中时再调用）
+    UserStore::FindResult findCredential(const std::string& username, std::string& stored);
+
+    // 当前存储后端名称
+    const char* backend() const { return store_ ? store_->name() : "none"; }
+
+    // 凭据缓存（异步路径与同步路径共用，只在远程存储前启用）：Found 时 stored 为保存的口令哈希
+    CredentialCache::Lookup cachedCredential(const std::string& username, std::string& stored);
+    // 查库结果回填缓存，stored 为空表示用户不存在
+    void rememberCredential(const std::string& username, const std::string* stored);
+    // 注册成功：失效缓存（可能有否定缓存）并加入 Bloom 过滤器
+    void onRegistered(const std::string& username);
     
 private:
     UserService() = default;
-    
-    std::string escapeString(const std::string& str);
+
+    void initCredentialCache();
+    // 启动时装入全部用户名到 Bloom 过滤器
+    bool loadBloomFilter();
+    std::unique_ptr<UserStore> store_;
 };
 
 #endif // USER_SERVICE_H
\ No newline at end of file
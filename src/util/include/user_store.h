@@ -0,0 +1,62 @@
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// 用户存储不可用（数据库熔断打开 / 取连接超时 / 本地日志写入失败），HTTP 层返回 503
+class DatabaseUnavailable : public std::runtime_error {
+public:
+    explicit DatabaseUnavailable(const std::string& what) : std::runtime_error(what) {}
+};
+
+/**
+ * @brief UserService 背后的用户存储后端
+ *        MySQLUserStore 为远程数据库；LogUserStore 为进程内嵌引擎（内存索引 + 追加日志），不依赖外部服务
+ */
+class UserStore {
+public:
+    enum class InsertResult {
+        Created,
+        Duplicate, // 用户名已存在
+        Failed,
+    };
+
+    enum class FindResult {
+        Found,
+        Absent,
+        Error, // 查询失败，结果未知（不应缓存为“不存在”）
+    };
+
+    virtual ~UserStore() = default;
+
+    virtual bool init() = 0;
+
+    // 以下操作后端不可用时抛出 DatabaseUnavailable
+    virtual InsertResult insert(const std::string& username, const std::string& password) = 0;
+    // 非阻塞写入：batchesInserts() 为 true 的后端把这一行并入合并写入，立即返回，结果（或异常）经 done 在写入线程上交还；
+    // username / password 须保持有效直到 done 被调用。默认实现在当前线程上同步调用 insert
+    using InsertDone = std::function<void(InsertResult result, std::exception_ptr error)>;
+    virtual void insertAsync(const std::string& username, const std::string& password, InsertDone done) {
+        try {
+            auto result = insert(username, password);
+            done(result, nullptr);
+        } catch (...) {
+            done(InsertResult::Failed, std::current_exception());
+        }
+    }
+    virtual bool batchesInserts() const { return false; }
+    // 找到时 passwd 为保存的凭据
+    virtual FindResult find(const std::string& username, std::string& passwd) = 0;
+    // 遍历全部用户名（启动时装入 Bloom 过滤器），失败返回 false
+    virtual bool forEachUsername(const std::function<void(std::string_view)>& fn) = 0;
+
+    // 远程存储每次查找都有网络往返，值得在前面加凭据缓存
+    virtual bool remote() const = 0;
+    virtual const char* name() const = 0;
+};
+
+#endif // USER_STORE_H
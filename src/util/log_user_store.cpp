@@ -0,0 +1,396 @@
+#include "log_user_store.h"
+#include "logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+    // 记录格式：crc32(4) | 用户名长度(2) | 密码长度(2) | 用户名 | 密码，crc 覆盖长度与内容；主机字节序
+    constexpr size_t kHeaderBytes = 8;
+    constexpr size_t kSnapshotChunk = 1 << 20;
+
+    void encode(std::string& out, std::string_view username, std::string_view password) {
+        size_t offset = out.size();
+        out.resize(offset + kHeaderBytes);
+        auto ulen = static_cast<uint16_t>(username.size());
+        auto plen = static_cast<uint16_t>(password.size());
+        std::memcpy(out.data() + offset + 4, &ulen, 2);
+        std::memcpy(out.data() + offset + 6, &plen, 2);
+        out.append(username);
+        out.append(password);
+        uint32_t crc = static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(out.data() + offset + 4),
+                                                   static_cast<uInt>(4 + ulen + plen)));
+        std::memcpy(out.data() + offset, &crc, 4);
+    }
+
+    bool writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t n = ::write(fd, data.data(), data.size());
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+    // rename / unlink 之后同步目录项
+    void syncDir(const std::string& dir) {
+        int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+}
+
+LogUserStore::LogUserStore(Options options)
+    : options_(std::move(options)),
+      shards_(options_.shards > 0 ? options_.shards : 1),
+      flush_bytes_(Metrics::histogram("user_log_flush_bytes")),
+      fsync_us_(Metrics::histogram("user_log_fsync_us")),
+      snapshots_(Metrics::counter("user_log_snapshot_total")) {}
+
+LogUserStore::~LogUserStore() {
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        stopping_ = true;
+    }
+    pending_cond_.notify_all();
+    snapshot_cond_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    if (snapshotter_.joinable()) {
+        snapshotter_.join();
+    }
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
+    }
+}
+
+bool LogUserStore::init() {
+    std::error_code ec;
+    std::filesystem::create_directories(options_.dir, ec);
+    if (ec) {
+        LOG_ERROR("[LogUserStore] Cannot create {}: {}", options_.dir, ec.message());
+        return false;
+    }
+
+    if (!replay(path("users.snap"), false) || !replay(path("users.log.old"), false) ||
+        !replay(path("users.log"), true)) {
+        return false;
+    }
+
+    log_fd_ = ::open(path("users.log").c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd_ < 0) {
+        LOG_ERROR("[LogUserStore] Cannot open {}: {}", path("users.log"), strerror(errno));
+        return false;
+    }
+    log_bytes_ = static_cast<size_t>(::lseek(log_fd_, 0, SEEK_END));
+    // 上次快照没有完成，启动后立即补做
+    snapshot_requested_ = std::filesystem::exists(path("users.log.old"));
+
+    flusher_ = std::thread(&LogUserStore::flushLoop, this);
+    snapshotter_ = std::thread(&LogUserStore::snapshotLoop, this);
+    LOG_INFO("[LogUserStore] Loaded {} users from {}", size(), options_.dir);
+    return true;
+}
+
+LogUserStore::Shard& LogUserStore::shardOf(std::string_view username) {
+    return shards_[std::hash<std::string_view> {}(username) % shards_.size()];
+}
+
+const LogUserStore::Shard& LogUserStore::shardOf(std::string_view username) const {
+    return shards_[std::hash<std::string_view> {}(username) % shards_.size()];
+}
+
+bool LogUserStore::indexInsert(std::string_view username, std::string_view password) {
+    auto& shard = shardOf(username);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.try_emplace(std::string(username), password).second;
+}
+
+void LogUserStore::publish(std::string_view username) {
+    auto& shard = shardOf(username);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.pending.find(std::string(username));
+    shard.users.try_emplace(it->first, std::move(it->second.passwd));
+    shard.pending.erase(it);
+}
+
+void LogUserStore::discardPending(std::string_view username) {
+    auto& shard = shardOf(username);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.pending.erase(std::string(username));
+}
+
+UserStore::InsertResult LogUserStore::insert(const std::string& username, const std::string& password) {
+    if (username.size() > UINT16_MAX || password.size() > UINT16_MAX) {
+        return InsertResult::Failed;
+    }
+
+    // 判重与追加日志在分片锁内完成：同名的并发注册只有一个进入日志
+    uint64_t seq = 0;
+    {
+        auto& shard = shardOf(username);
+        std::unique_lock<std::shared_mutex> shard_lock(shard.mutex);
+        if (shard.users.contains(username) || shard.pending.contains(username)) {
+            return InsertResult::Duplicate;
+        }
+        {
+            std::lock_guard<std::mutex> lock(log_mutex_);
+            if (broken_) {
+                throw DatabaseUnavailable("user log is not writable");
+            }
+            encode(pending_, username, password);
+            seq = ++appended_seq_;
+        }
+        shard.pending.try_emplace(username, PendingUser {password, seq});
+    }
+    pending_cond_.notify_one();
+    if (!options_.fsync) {
+        publish(username); // 不等落盘，只保证进程崩溃不丢
+        return InsertResult::Created;
+    }
+
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    durable_cond_.wait(lock, [this, seq] { return durable_seq_ >= seq || broken_; });
+    bool durable = durable_seq_ >= seq;
+    lock.unlock();
+    if (durable) {
+        publish(username);
+        return InsertResult::Created;
+    }
+    discardPending(username);
+    throw DatabaseUnavailable("user log write failed");
+}
+
+UserStore::FindResult LogUserStore::find(const std::string& username, std::string& passwd) {
+    const auto& shard = shardOf(username);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(username);
+    if (it == shard.users.end()) {
+        return FindResult::Absent;
+    }
+    passwd = it->second;
+    return FindResult::Found;
+}
+
+bool LogUserStore::forEachUsername(const std::function<void(std::string_view)>& fn) {
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const auto& [username, passwd] : shard.users) {
+            fn(username);
+        }
+    }
+    return true;
+}
+
+size_t LogUserStore::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.users.size();
+    }
+    return total;
+}
+
+bool LogUserStore::replay(const std::string& file, bool truncate_tail) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        return true; // 文件不存在
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    size_t records = 0;
+    while (offset + kHeaderBytes <= data.size()) {
+        uint32_t crc;
+        uint16_t ulen, plen;
+        std::memcpy(&crc, data.data() + offset, 4);
+        std::memcpy(&ulen, data.data() + offset + 4, 2);
+        std::memcpy(&plen, data.data() + offset + 6, 2);
+        size_t end = offset + kHeaderBytes + ulen + plen;
+        if (end > data.size() ||
+            crc != static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(data.data() + offset + 4),
+                                               static_cast<uInt>(4 + ulen + plen)))) {
+            break;
+        }
+        std::string_view username(data.data() + offset + kHeaderBytes, ulen);
+        std::string_view password(data.data() + offset + kHeaderBytes + ulen, plen);
+        indexInsert(username, password); // 快照与日志可能有重叠，重复记录直接忽略
+        ++records;
+        offset = end;
+    }
+
+    if (offset < data.size()) {
+        if (!truncate_tail) {
+            LOG_ERROR("[LogUserStore] {} is corrupted at offset {}", file, offset);
+            return false;
+        }
+        // 崩溃时写了一半的记录，其注册请求没有得到成功响应
+        LOG_WARN("[LogUserStore] Truncating torn tail of {} at offset {}", file, offset);
+        if (::truncate(file.c_str(), static_cast<off_t>(offset)) != 0) {
+            LOG_ERROR("[LogUserStore] Truncate {} failed: {}", file, strerror(errno));
+            return false;
+        }
+    }
+    LOG_INFO("[LogUserStore] Replayed {} records from {}", records, file);
+    return true;
+}
+
+void LogUserStore::flushLoop() {
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    while (true) {
+        pending_cond_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break; // stopping_ 且已刷完
+        }
+
+        // 写出期间新到的记录继续攒在 pending_，下一轮一起落盘
+        std::string batch;
+        batch.swap(pending_);
+        uint64_t upto = appended_seq_;
+        int fd = log_fd_;
+        writing_ = true;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = writeAll(fd, batch) && (!options_.fsync || ::fdatasync(fd) == 0);
+        fsync_us_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+        flush_bytes_.record(batch.size());
+        if (!ok) {
+            LOG_ERROR("[LogUserStore] Log write failed, store is now read-only: {}", strerror(errno));
+        }
+
+        lock.lock();
+        writing_ = false;
+        if (ok) {
+            durable_seq_ = upto;
+            log_bytes_ += batch.size();
+            if (options_.snapshot_bytes > 0 && log_bytes_ >= options_.snapshot_bytes && !snapshot_requested_) {
+                snapshot_requested_ = true;
+                snapshot_cond_.notify_one();
+            }
+        } else {
+            // 写失败后文件尾部状态未知（fsync 失败后脏页可能已被丢弃），不再继续追加
+            broken_ = true;
+        }
+        durable_cond_.notify_all();
+    }
+}
+
+void LogUserStore::snapshotLoop() {
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    while (true) {
+        snapshot_cond_.wait(lock, [this] { return stopping_ || snapshot_requested_; });
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        snapshot();
+        lock.lock();
+        snapshot_requested_ = false;
+    }
+}
+
+bool LogUserStore::snapshot() {
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+    std::string log = path("users.log");
+    std::string old_log = path("users.log.old");
+
+    // 上次快照失败留下的旧日志尚未并入快照时不轮转，否则会覆盖它；直接写快照，完成后删除
+    uint64_t durable_seq = 0;
+    if (!std::filesystem::exists(old_log)) {
+        int old_fd = -1;
+        {
+            std::unique_lock<std::mutex> lock(log_mutex_);
+            durable_cond_.wait(lock, [this] { return !writing_; });
+            if (broken_) {
+                return false;
+            }
+            durable_seq = durable_seq_;
+            if (::rename(log.c_str(), old_log.c_str()) != 0) {
+                LOG_ERROR("[LogUserStore] Rotate {} failed: {}", log, strerror(errno));
+                return false;
+            }
+            int fd = ::open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                LOG_ERROR("[LogUserStore] Cannot open {}: {}", log, strerror(errno));
+                ::rename(old_log.c_str(), log.c_str());
+                return false;
+            }
+            old_fd = log_fd_;
+            log_fd_ = fd;
+            log_bytes_ = 0;
+        }
+        ::close(old_fd);
+        syncDir(options_.dir);
+    } else {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        durable_seq = durable_seq_;
+    }
+
+    // 旧日志中的记录都已落盘（seq 不超过 durable_seq）：或已移入索引，或仍在等待中注册里尚未移入；
+    // 尚未落盘的注册不写入快照，刷写失败时它们被丢弃，不会因快照在重启后复活
+    if (!writeSnapshot(durable_seq)) {
+        return false;
+    }
+    ::unlink(old_log.c_str());
+    syncDir(options_.dir);
+    snapshots_.add();
+    return true;
+}
+
+bool LogUserStore::writeSnapshot(uint64_t durable_seq) {
+    std::string tmp = path("users.snap.tmp");
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("[LogUserStore] Cannot open {}: {}", tmp, strerror(errno));
+        return false;
+    }
+
+    size_t users = 0;
+    bool ok = true;
+    std::string buffer;
+    for (const auto& shard : shards_) {
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            for (const auto& [username, passwd] : shard.users) {
+                encode(buffer, username, passwd);
+            }
+            users += shard.users.size();
+            for (const auto& [username, pending] : shard.pending) {
+                if (pending.seq <= durable_seq) {
+                    encode(buffer, username, pending.passwd);
+                    ++users;
+                }
+            }
+        }
+        if (buffer.size() >= kSnapshotChunk) {
+            ok = ok && writeAll(fd, buffer);
+            buffer.clear();
+        }
+    }
+    ok = ok && writeAll(fd, buffer) && ::fdatasync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || ::rename(tmp.c_str(), path("users.snap").c_str()) != 0) {
+        LOG_ERROR("[LogUserStore] Write snapshot failed: {}", strerror(errno));
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    LOG_INFO("[LogUserStore] Snapshot written with {} users", users);
+    return true;
+}
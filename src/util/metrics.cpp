@@ -0,0 +1,75 @@
+#include "metrics.h"
+
+#include <bit>
+
+namespace Metrics {
+    void Histogram::record(uint64_t value) {
+        size_t bucket = value == 0 ? 0 : static_cast<size_t>(std::bit_width(value));
+        if (bucket >= kBuckets) {
+            bucket = kBuckets - 1;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t prev = max_.load(std::memory_order_relaxed);
+        while (value > prev && !max_.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t Histogram::percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        auto target = static_cast<uint64_t>(p * static_cast<double>(total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return i == 0 ? 0 : (uint64_t {1} << i) - 1;
+            }
+        }
+        return max();
+    }
+
+    Registry& Registry::Instance() {
+        static Registry instance;
+        return instance;
+    }
+
+    Counter& Registry::counter(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = counters_[name];
+        if (!slot) {
+            slot = std::make_unique<Counter>();
+        }
+        return *slot;
+    }
+
+    Histogram& Registry::histogram(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = histograms_[name];
+        if (!slot) {
+            slot = std::make_unique<Histogram>();
+        }
+        return *slot;
+    }
+
+    std::string Registry::dump() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        for (const auto& [name, counter] : counters_) {
+            out += name + " " + std::to_string(counter->value()) + "\n";
+        }
+        for (const auto& [name, hist] : histograms_) {
+            uint64_t count = hist->count();
+            out += name + "_count " + std::to_string(count) + "\n";
+            out += name + "_avg " + std::to_string(count ? hist->sum() / count : 0) + "\n";
+            out += name + "_p50 " + std::to_string(hist->percentile(0.50)) + "\n";
+            out += name + "_p99 " + std::to_string(hist->percentile(0.99)) + "\n";
+            out += name + "_max " + std::to_string(hist->max()) + "\n";
+        }
+        return out;
+    }
+}
@@ -2,12 +2,18 @@
 #include "mysql_connection.h"
 #include "logger.h"
 #include "config_manager.h"
+#include "deadline.h"
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 
+namespace {
+    constexpr std::chrono::milliseconds kWaitSlice {50};
+}
+
 MySQLConnectionGuard::~MySQLConnectionGuard() {
     if (conn_) {
-        MySQLConnectionPool::Instance().releaseConnection(conn_);
+        MySQLConnectionPool::Instance().releaseConnection(conn_, shard_);
         conn_ = nullptr;
     }
 }
@@ -17,77 +23,347 @@ MySQLConnectionPool& MySQLConnectionPool::Instance() {
     return instance;
 }
 
+MySQLConnectionPool::MySQLConnectionPool()
+    : acquire_wait_us_(Metrics::histogram("mysql_pool_acquire_wait_us")),
+      acquire_timeouts_(Metrics::counter("mysql_pool_acquire_timeout_total")),
+      breaker_rejects_(Metrics::counter("mysql_pool_breaker_reject_total")),
+      breaker_opened_(Metrics::counter("mysql_pool_breaker_open_total")),
+      broken_(Metrics::counter("mysql_pool_broken_total")),
+      reaped_(Metrics::counter("mysql_pool_idle_reaped_total")),
+      connections_(Metrics::counter("mysql_pool_connections")) {}
+
 bool MySQLConnectionPool::init() {
     auto& config = ConfigManager::Instance();
-    
+
     host_ = config.get<std::string>("mysql.host", "localhost");
     user_ = config.get<std::string>("mysql.user", "root");
     pwd_ = config.get<std::string>("mysql.password", "123456");
     db_name_ = config.get<std::string>("mysql.database", "webserver_db");
     port_ = config.get<int>("mysql.port", 3306);
-    max_conn_ = config.get<int>("mysql.pool_size", 8);
-    curr_conn_ = 0;
-    
-    for (int i = 0; i < max_conn_; ++i) {
+    max_conn_ = std::max(1, config.get<int>("mysql.pool_size", 8));
+    min_idle_ = std::clamp(config.get<int>("mysql.min_pool_size", 2), 0, max_conn_);
+    connect_timeout_ = config.get<int>("mysql.connect_timeout", 10);
+    read_timeout_ = config.get<int>("mysql.read_timeout", 30);
+    write_timeout_ = config.get<int>("mysql.write_timeout", 30);
+    acquire_timeout_ = std::chrono::milliseconds(config.get<int>("mysql.acquire_timeout_ms", 1000));
+    idle_timeout_ = std::chrono::milliseconds(config.get<int>("mysql.idle_timeout_ms", 60000));
+    check_interval_ = std::chrono::milliseconds(config.get<int>("mysql.health_check_interval_ms", 5000));
+    breaker_threshold_ = std::max(1, config.get<int>("mysql.breaker_failures", 5));
+    breaker_cooldown_ = std::chrono::milliseconds(config.get<int>("mysql.breaker_cooldown_ms", 5000));
+
+    // 0 / 1 表示不分片
+    int shard_count = std::clamp(config.get<int>("mysql.pool_shards", 0), 1, max_conn_);
+    shards_.clear();
+    for (int i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+
+    // 预热到最小连接数，其余按需创建
+    for (int i = 0; i < min_idle_; ++i) {
         MySQLConnection* conn = createConnection();
-        if (conn) {
-            conn_queue_.push(conn);
-            ++curr_conn_;
-        } else {
+        if (!conn) {
             LOG_ERROR("MySQL connection pool init failed at conn #{:d}", i);
             return false;
         }
+        ++total_;
+        auto now = Clock::now();
+        shards_[i % shards_.size()]->idle.push_back({conn, now, now});
     }
-    
+    connections_.set(static_cast<uint64_t>(total_.load()));
+
+    {
+        std::lock_guard<std::mutex> lock(maintain_mutex_);
+        running_ = true;
+    }
+    maintainer_ = std::thread(&MySQLConnectionPool::maintain, this);
     return true;
 }
 
 MySQLConnectionPool::~MySQLConnectionPool() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    while (!conn_queue_.empty()) {
-        auto conn = conn_queue_.front();
-        conn_queue_.pop();
-        delete conn;
+    {
+        std::lock_guard<std::mutex> lock(maintain_mutex_);
+        running_ = false;
+    }
+    maintain_cond_.notify_all();
+    if (maintainer_.joinable()) {
+        maintainer_.join();
+    }
+
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto& idle : shard->idle) {
+            delete idle.conn;
+        }
+        shard->idle.clear();
     }
 }
 
 MySQLConnection* MySQLConnectionPool::createConnection() {
     try {
         auto conn = new MySQLConnection();
+        conn->setTimeouts(connect_timeout_, read_timeout_, write_timeout_);
         if (!conn->connect(host_, user_, pwd_, db_name_, port_)) {
+            LOG_ERROR("MySQL connect failed: {:s}", mysql_error(conn->getRawConn()));
             delete conn;
+            reportFailure();
             return nullptr;
         }
+        reportSuccess();
         return conn;
     } catch (const std::exception& e) {
         LOG_ERROR("Create MySQL connection failed: {:s}", e.what());
+        reportFailure();
+        return nullptr;
+    }
+}
+
+size_t MySQLConnectionPool::localShard() {
+    // 线程首次取连接时固定一个分片（reactor / 工作线程各自稳定落在一个分片上）
+    thread_local size_t shard = next_shard_.fetch_add(1, std::memory_order_relaxed);
+    return shard % shards_.size();
+}
+
+MySQLConnection* MySQLConnectionPool::takeIdle(size_t index, bool blocking) {
+    Shard& shard = *shards_[index];
+    std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+    if (blocking) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
         return nullptr;
     }
+
+    while (!shard.idle.empty()) {
+        IdleConn idle = shard.idle.back();
+        shard.idle.pop_back();
+        // 空闲超过校验间隔的连接先 ping 一次（锁外），坏连接丢弃后继续找
+        if (Clock::now() - idle.last_checked < check_interval_) {
+            return idle.conn;
+        }
+        lock.unlock();
+        if (idle.conn->ping()) {
+            return idle.conn;
+        }
+        broken_.add();
+        discard(idle.conn);
+        reportFailure();
+        lock.lock();
+    }
+    return nullptr;
+}
+
+void MySQLConnectionPool::discard(MySQLConnection* conn) {
+    delete conn;
+    connections_.set(static_cast<uint64_t>(--total_));
+    // 名额空出，唤醒一个等待者去新建
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (shard->waiters > 0) {
+            shard->cond.notify_one();
+            break;
+        }
+    }
 }
 
 std::shared_ptr<MySQLConnectionGuard> MySQLConnectionPool::getConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    while (conn_queue_.empty()) {
-        if (curr_conn_ < max_conn_) {
-            MySQLConnection* conn = createConnection();
-            if (conn) {
-                ++curr_conn_;
-                return std::make_shared<MySQLConnectionGuard>(conn);
+    if (!allowRequest()) {
+        breaker_rejects_.add();
+        return nullptr;
+    }
+
+    auto start = Clock::now();
+    auto record = [this, start] {
+        acquire_wait_us_.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count()));
+    };
+    // 在线请求不等过截止时间
+    auto wait_until = std::min<Clock::time_point>(Deadline::current(), start + acquire_timeout_);
+    size_t home = localShard();
+
+    while (true) {
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            size_t index = (home + i) % shards_.size();
+            if (MySQLConnection* conn = takeIdle(index, i == 0)) {
+                record();
+                return std::make_shared<MySQLConnectionGuard>(conn, home);
+            }
+        }
+
+        // 没有空闲连接：未达上限则先占名额再在锁外建连
+        int total = total_.load();
+        while (total < max_conn_ && !total_.compare_exchange_weak(total, total + 1)) {
+        }
+        if (total < max_conn_) {
+            if (MySQLConnection* conn = createConnection()) {
+                connections_.set(static_cast<uint64_t>(total_.load()));
+                record();
+                return std::make_shared<MySQLConnectionGuard>(conn, home);
             }
+            --total_;
+            if (!allowRequest() || Clock::now() >= wait_until) {
+                record();
+                return nullptr;
+            }
+            continue;
+        }
+
+        // 已达上限：在本分片上等待归还；归还可能落到别的分片，分段等待后重新扫描全部分片
+        Shard& shard = *shards_[home];
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        if (!shard.idle.empty()) {
+            continue;
+        }
+        ++shard.waiters;
+        shard.cond.wait_until(lock, std::min<Clock::time_point>(wait_until, Clock::now() + kWaitSlice));
+        --shard.waiters;
+        if (shard.idle.empty() && Clock::now() >= wait_until) {
+            LOG_WARN("MySQL connection acquire timed out after {}ms",
+                     std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+            acquire_timeouts_.add();
+            probing_.store(false, std::memory_order_relaxed);
+            record();
+            return nullptr;
         }
-        // 等待可用连接
-        cond_.wait(lock);
     }
-    
-    MySQLConnection* conn = conn_queue_.front();
-    conn_queue_.pop();
-    return std::make_shared<MySQLConnectionGuard>(conn);
 }
 
-void MySQLConnectionPool::releaseConnection(MySQLConnection* conn) {
+void MySQLConnectionPool::releaseConnection(MySQLConnection* conn, size_t shard_index) {
     if (!conn) return;
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    conn_queue_.push(conn);
-    cond_.notify_one();
-}
\ No newline at end of file
+
+    // 客户端 / 网络错误后连接状态未知，直接丢弃
+    if (conn->broken()) {
+        broken_.add();
+        reportFailure();
+        discard(conn);
+        return;
+    }
+    reportSuccess();
+
+    // 优先放回有等待者的分片（本分片没人等时），否则放回取出时的分片
+    Shard* target = shards_[shard_index].get();
+    if (shards_.size() > 1) {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        if (target->waiters == 0) {
+            for (auto& other : shards_) {
+                if (other.get() != target && other->waiters > 0) {
+                    target = other.get();
+                    break;
+                }
+            }
+        }
+    }
+
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(target->mutex);
+    target->idle.push_back({conn, now, now});
+    target->cond.notify_one();
+}
+
+bool MySQLConnectionPool::available() const {
+    if (failures_.load(std::memory_order_relaxed) < breaker_threshold_) {
+        return true;
+    }
+    return Clock::now().time_since_epoch().count() >= open_until_ns_.load(std::memory_order_relaxed);
+}
+
+bool MySQLConnectionPool::allowRequest() {
+    if (failures_.load(std::memory_order_relaxed) < breaker_threshold_) {
+        return true;
+    }
+    if (Clock::now().time_since_epoch().count() < open_until_ns_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // 冷却结束：半开，只放行一个试探请求，其结果决定关闭还是重新打开
+    bool expected = false;
+    return probing_.compare_exchange_strong(expected, true);
+}
+
+void MySQLConnectionPool::reportSuccess() {
+    failures_.store(0, std::memory_order_relaxed);
+    probing_.store(false, std::memory_order_relaxed);
+}
+
+void MySQLConnectionPool::reportFailure() {
+    int failures = failures_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (failures >= breaker_threshold_) {
+        auto until = Clock::now() + breaker_cooldown_;
+        open_until_ns_.store(until.time_since_epoch().count(), std::memory_order_relaxed);
+        if (failures == breaker_threshold_ || probing_.load(std::memory_order_relaxed)) {
+            LOG_ERROR("MySQL circuit breaker open for {}ms after {} consecutive failures",
+                      breaker_cooldown_.count(), failures);
+            breaker_opened_.add();
+        }
+    }
+    probing_.store(false, std::memory_order_relaxed);
+}
+
+void MySQLConnectionPool::maintain() {
+    std::unique_lock<std::mutex> lock(maintain_mutex_);
+    while (running_) {
+        maintain_cond_.wait_for(lock, check_interval_);
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+        maintainOnce();
+        lock.lock();
+    }
+}
+
+void MySQLConnectionPool::maintainOnce() {
+    auto now = Clock::now();
+    std::vector<MySQLConnection*> reap;
+    std::vector<std::pair<size_t, IdleConn>> check;
+
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard& shard = *shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.idle.begin(); it != shard.idle.end();) {
+            if (now - it->last_used >= idle_timeout_ && total_.load() - static_cast<int>(reap.size()) > min_idle_) {
+                reap.push_back(it->conn);
+                it = shard.idle.erase(it);
+            } else if (now - it->last_checked >= check_interval_) {
+                check.emplace_back(i, *it);
+                it = shard.idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // 回收长时间空闲的连接（保留最小连接数）
+    for (auto* conn : reap) {
+        reaped_.add();
+        discard(conn);
+    }
+
+    // 校验空闲连接：ping 失败的丢弃，稍后由预热补回
+    for (auto& [index, idle] : check) {
+        if (!idle.conn->ping()) {
+            LOG_WARN("MySQL idle connection failed health check, dropping it");
+            broken_.add();
+            reportFailure();
+            discard(idle.conn);
+            continue;
+        }
+        reportSuccess();
+        idle.last_checked = Clock::now();
+        Shard& shard = *shards_[index];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.idle.push_front(idle);
+    }
+
+    // 预热 / 重连到最小连接数；熔断打开期间不尝试
+    size_t next = 0;
+    while (total_.load() < min_idle_ && allowRequest()) {
+        MySQLConnection* conn = createConnection();
+        if (!conn) {
+            break;
+        }
+        connections_.set(static_cast<uint64_t>(++total_));
+        auto created = Clock::now();
+        Shard& shard = *shards_[next++ % shards_.size()];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.idle.push_back({conn, created, created});
+        shard.cond.notify_one();
+    }
+}
@@ -1,5 +1,14 @@
 #include "mysql_connection.h"
+#include "deadline.h"
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr unsigned int kUnknownStmtHandler = 1243; // ER_UNKNOWN_STMT_HANDLER
+    constexpr unsigned int kQueryTimeout = 3024;       // ER_QUERY_TIMEOUT，请求截止时间已过未发送
+    constexpr size_t kMaxColumnBytes = 256;            // queryPrepared 取回的单列长度上限
+}
 
 MySQLConnection::MySQLConnection() : conn_(nullptr), result_(nullptr) {
     conn_ = mysql_init(nullptr);
@@ -9,6 +18,10 @@ MySQLConnection::MySQLConnection() : conn_(nullptr), result_(nullptr) {
 }
 
 MySQLConnection::~MySQLConnection() {
+    for (auto& [sql, stmt] : stmts_) {
+        mysql_stmt_close(stmt);
+    }
+    stmts_.clear();
     if (result_) {
         mysql_free_result(result_);
         result_ = nullptr;
@@ -19,6 +32,44 @@ MySQLConnection::~MySQLConnection() {
     }
 }
 
+void MySQLConnection::setTimeouts(unsigned int connect_timeout, unsigned int read_timeout,
+                                  unsigned int write_timeout) {
+    read_timeout_ = read_timeout;
+    write_timeout_ = write_timeout;
+    if (connect_timeout > 0) {
+        mysql_options(conn_, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+    }
+    if (read_timeout > 0) {
+        mysql_options(conn_, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
+    }
+    if (write_timeout > 0) {
+        mysql_options(conn_, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
+    }
+}
+
+bool MySQLConnection::applyDeadline() {
+    int64_t left_ms = Deadline::remainingMs();
+    if (left_ms == 0) {
+        LOG_WARN("MySQL query skipped: request deadline exceeded");
+        return false;
+    }
+
+    // 客户端库的网络超时以秒为单位，向上取整；不超过配置的默认值
+    unsigned int timeout = 0;
+    if (left_ms > 0) {
+        timeout = static_cast<unsigned int>((left_ms + 999) / 1000);
+        if (read_timeout_ > 0) {
+            timeout = std::min(timeout, read_timeout_);
+        }
+    }
+    if (timeout != applied_timeout_) {
+        my_net_set_read_timeout(&conn_->net, timeout > 0 ? timeout : read_timeout_);
+        my_net_set_write_timeout(&conn_->net, timeout > 0 ? timeout : write_timeout_);
+        applied_timeout_ = timeout;
+    }
+    return true;
+}
+
 bool MySQLConnection::connect(const std::string& host, 
                             const std::string& user,
                             const std::string& pwd, 
@@ -31,6 +82,9 @@ bool MySQLConnection::connect(const std::string& host,
 }
 
 bool MySQLConnection::exec(const std::string& sql) {
+    if (!applyDeadline()) {
+        return false;
+    }
     if (mysql_query(conn_, sql.c_str()) != 0) {
         LOG_ERROR("MySQL exec failed: {:s}", mysql_error(conn_));
         return false;
@@ -43,7 +97,10 @@ bool MySQLConnection::query(const std::string& sql) {
         mysql_free_result(result_);
         result_ = nullptr;
     }
-    
+
+    if (!applyDeadline()) {
+        return false;
+    }
     if (mysql_query(conn_, sql.c_str()) != 0) {
         LOG_ERROR("MySQL query failed: {:s}", mysql_error(conn_));
         return false;
@@ -55,4 +112,150 @@ bool MySQLConnection::query(const std::string& sql) {
 
 MYSQL_ROW MySQLConnection::fetchRow() {
     return result_ ? mysql_fetch_row(result_) : nullptr;
+}
+
+net_async_status MySQLConnection::queryNonBlocking(const std::string& sql) {
+    if (result_) {
+        mysql_free_result(result_);
+        result_ = nullptr;
+    }
+    net_async_status status = mysql_real_query_nonblocking(conn_, sql.c_str(), sql.size());
+    if (status == NET_ASYNC_ERROR) {
+        LOG_ERROR("MySQL async query failed: {:s}", mysql_error(conn_));
+    }
+    return status;
+}
+
+net_async_status MySQLConnection::storeResultNonBlocking() {
+    net_async_status status = mysql_store_result_nonblocking(conn_, &result_);
+    if (status == NET_ASYNC_ERROR) {
+        LOG_ERROR("MySQL async store result failed: {:s}", mysql_error(conn_));
+    }
+    return status;
+}
+
+MYSQL_STMT* MySQLConnection::prepare(const std::string& sql) {
+    auto it = stmts_.find(sql);
+    if (it != stmts_.end()) {
+        return it->second;
+    }
+
+    MYSQL_STMT* stmt = mysql_stmt_init(conn_);
+    if (!stmt) {
+        stmt_errno_ = mysql_errno(conn_);
+        LOG_ERROR("MySQL stmt init failed: {:s}", mysql_error(conn_));
+        return nullptr;
+    }
+    if (mysql_stmt_prepare(stmt, sql.data(), sql.size()) != 0) {
+        stmt_errno_ = mysql_stmt_errno(stmt);
+        LOG_ERROR("MySQL prepare failed: {:s}, sql: {:s}", mysql_stmt_error(stmt), sql);
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    stmts_.emplace(sql, stmt);
+    return stmt;
+}
+
+bool MySQLConnection::executeStmt(const std::string& sql, MYSQL_STMT* stmt,
+                                  std::span<const std::string_view> params) {
+    std::vector<MYSQL_BIND> binds(params.size());
+    std::vector<unsigned long> lengths(params.size());
+    size_t i = 0;
+    for (auto param : params) {
+        lengths[i] = param.size();
+        binds[i] = MYSQL_BIND {};
+        binds[i].buffer_type = MYSQL_TYPE_STRING;
+        binds[i].buffer = const_cast<char*>(param.data());
+        binds[i].buffer_length = param.size();
+        binds[i].length = &lengths[i];
+        ++i;
+    }
+
+    if (mysql_stmt_bind_param(stmt, binds.data()) || mysql_stmt_execute(stmt) != 0) {
+        stmt_errno_ = mysql_stmt_errno(stmt);
+        // 语句句柄失效（服务端已释放 / 连接断开）时移出缓存，下次重新 prepare
+        if (stmt_errno_ == kUnknownStmtHandler || isClientError(stmt_errno_)) {
+            LOG_ERROR("MySQL execute failed: {:s}", mysql_stmt_error(stmt));
+            mysql_stmt_close(stmt);
+            stmts_.erase(sql);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool MySQLConnection::execPrepared(const std::string& sql, std::span<const std::string_view> params) {
+    stmt_errno_ = 0;
+    if (!applyDeadline()) {
+        stmt_errno_ = kQueryTimeout;
+        return false;
+    }
+    MYSQL_STMT* stmt = prepare(sql);
+    return stmt && executeStmt(sql, stmt, params);
+}
+
+bool MySQLConnection::queryPrepared(const std::string& sql, std::initializer_list<std::string_view> params,
+                                    std::string& value) {
+    stmt_errno_ = 0;
+    if (!applyDeadline()) {
+        stmt_errno_ = kQueryTimeout;
+        return false;
+    }
+    MYSQL_STMT* stmt = prepare(sql);
+    if (!stmt || !executeStmt(sql, stmt, std::span<const std::string_view>(params.begin(), params.size()))) {
+        return false;
+    }
+
+    bool found = false;
+    fetchColumn(stmt, [&](std::string_view column) {
+        value.assign(column);
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+bool MySQLConnection::queryPreparedColumn(const std::string& sql, std::span<const std::string_view> params,
+                                          std::vector<std::string>& values) {
+    stmt_errno_ = 0;
+    if (!applyDeadline()) {
+        stmt_errno_ = kQueryTimeout;
+        return false;
+    }
+    MYSQL_STMT* stmt = prepare(sql);
+    if (!stmt || !executeStmt(sql, stmt, params)) {
+        return false;
+    }
+    return fetchColumn(stmt, [&values](std::string_view column) {
+        values.emplace_back(column);
+        return true;
+    });
+}
+
+bool MySQLConnection::fetchColumn(MYSQL_STMT* stmt, const std::function<bool(std::string_view)>& row) {
+    char buffer[kMaxColumnBytes];
+    unsigned long length = 0;
+    bool is_null = false;
+    MYSQL_BIND column {};
+    column.buffer_type = MYSQL_TYPE_STRING;
+    column.buffer = buffer;
+    column.buffer_length = sizeof(buffer);
+    column.length = &length;
+    column.is_null = &is_null;
+
+    bool ok = true;
+    if (mysql_stmt_bind_result(stmt, &column) || mysql_stmt_store_result(stmt) != 0) {
+        stmt_errno_ = mysql_stmt_errno(stmt);
+        LOG_ERROR("MySQL fetch failed: {:s}", mysql_stmt_error(stmt));
+        ok = false;
+    } else {
+        int rc;
+        while ((rc = mysql_stmt_fetch(stmt)) == 0 || rc == MYSQL_DATA_TRUNCATED) {
+            if (!row(std::string_view(buffer, is_null ? 0 : std::min<size_t>(length, sizeof(buffer))))) {
+                break;
+            }
+        }
+    }
+    mysql_stmt_free_result(stmt);
+    return ok;
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "mysql_user_store.h"
+#include "config_manager.h"
+#include "logger.h"
+#include "metrics.h"
+#include "mysql_conn_pool.h"
+#include "register_batcher.h"
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    // 预处理语句在每个连接上按 SQL 文本缓存
+    const std::string kVerifyStmt = "SELECT passwd FROM user WHERE username = ?";
+    const std::string kInsertStmt = "INSERT INTO user(username, passwd) VALUES(?, ?)";
+
+    // 批量语句按行数生成，同一连接上每种行数各缓存一条
+    std::string placeholders(size_t rows, std::string_view row) {
+        std::string sql;
+        for (size_t i = 0; i < rows; ++i) {
+            if (i > 0) {
+                sql += ", ";
+            }
+            sql += row;
+        }
+        return sql;
+    }
+
+    RegisterBatcher::Result insertOne(MySQLConnection& conn, const RegisterBatcher::Row& row) {
+        if (conn.execPrepared(kInsertStmt, {row.username, row.password})) {
+            return RegisterBatcher::Result::Created;
+        }
+        return conn.stmtErrorCode() == MySQLUserStore::kDuplicateEntry ? RegisterBatcher::Result::Duplicate
+                                                                       : RegisterBatcher::Result::Failed;
+    }
+
+    // 一个事务：先锁定本批用户名中已存在的行（不存在的用户名由间隙锁挡住并发插入），再一条多行 INSERT 写入其余行。
+    // 任一步失败回滚并返回 false（如并发批次间隙锁死锁，或大小写不同但按排序规则相同的用户名触发唯一索引冲突），
+    // 由调用方逐行重试得到每行的确切结果
+    bool insertBatch(MySQLConnection& conn, const std::vector<RegisterBatcher::Row*>& rows) {
+        if (!conn.exec("START TRANSACTION")) {
+            return false;
+        }
+
+        std::vector<std::string_view> params;
+        params.reserve(rows.size() * 2);
+        for (auto* row : rows) {
+            params.push_back(row->username);
+        }
+        std::vector<std::string> existing;
+        std::string select = "SELECT username FROM user WHERE username IN (" + placeholders(rows.size(), "?") +
+                             ") FOR UPDATE";
+        if (!conn.queryPreparedColumn(select, params, existing)) {
+            conn.exec("ROLLBACK");
+            return false;
+        }
+
+        std::unordered_set<std::string_view> taken(existing.begin(), existing.end());
+        std::vector<RegisterBatcher::Row*> inserts;
+        params.clear();
+        for (auto* row : rows) {
+            if (taken.count(row->username)) {
+                row->result = RegisterBatcher::Result::Duplicate;
+                continue;
+            }
+            inserts.push_back(row);
+            params.push_back(row->username);
+            params.push_back(row->password);
+        }
+
+        if (!inserts.empty()) {
+            std::string insert = "INSERT INTO user(username, passwd) VALUES " + placeholders(inserts.size(), "(?, ?)");
+            if (!conn.execPrepared(insert, params)) {
+                conn.exec("ROLLBACK");
+                return false;
+            }
+        }
+        if (!conn.exec("COMMIT")) {
+            conn.exec("ROLLBACK");
+            return false;
+        }
+        for (auto* row : inserts) {
+            row->result = RegisterBatcher::Result::Created;
+        }
+        return true;
+    }
+
+    void flushRegistrations(std::span<RegisterBatcher::Row* const> rows) {
+        static Metrics::Counter& fallbacks = Metrics::counter("register_batch_fallback_total");
+
+        auto conn = MySQLConnectionPool::Instance().getConnection();
+        if (!conn) {
+            throw DatabaseUnavailable("no MySQL connection available");
+        }
+
+        // 同一批内重复的用户名只写第一行
+        std::unordered_set<std::string_view> seen;
+        std::vector<RegisterBatcher::Row*> unique;
+        for (auto* row : rows) {
+            if (seen.insert(row->username).second) {
+                unique.push_back(row);
+            } else {
+                row->result = RegisterBatcher::Result::Duplicate;
+            }
+        }
+
+        if (unique.size() > 1 && insertBatch(*conn->get(), unique)) {
+            return;
+        }
+        if (unique.size() > 1) {
+            LOG_WARN("[MySQLUserStore] Batched insert of {} users failed, retrying row by row", unique.size());
+            fallbacks.add();
+        }
+        for (auto* row : unique) {
+            row->result = insertOne(*conn->get(), *row);
+        }
+    }
+}
+
+bool MySQLUserStore::init() {
+    if (!MySQLConnectionPool::Instance().init()) {
+        return false;
+    }
+
+    auto& config = ConfigManager::Instance();
+    int batch_rows = config.get<int>("mysql.register_batch_max_rows", 64);
+    if (batch_rows > 1) {
+        RegisterBatcher::Instance().init(static_cast<size_t>(batch_rows), flushRegistrations);
+    }
+    return true;
+}
+
+bool MySQLUserStore::batchesInserts() const {
+    return RegisterBatcher::Instance().enabled();
+}
+
+void MySQLUserStore::insertAsync(const std::string& username, const std::string& password, InsertDone done) {
+    auto& batcher = RegisterBatcher::Instance();
+    if (!batcher.enabled()) {
+        UserStore::insertAsync(username, password, std::move(done));
+        return;
+    }
+    batcher.submit(username, password, [done = std::move(done)](RegisterBatcher::Result result, std::exception_ptr error) {
+        switch (result) {
+            case RegisterBatcher::Result::Created:
+                done(InsertResult::Created, error);
+                return;
+            case RegisterBatcher::Result::Duplicate:
+                done(InsertResult::Duplicate, error);
+                return;
+            case RegisterBatcher::Result::Failed:
+                break;
+        }
+        done(InsertResult::Failed, error);
+    });
+}
+
+UserStore::InsertResult MySQLUserStore::insert(const std::string& username, const std::string& password) {
+    auto conn = MySQLConnectionPool::Instance().getConnection();
+    if (!conn) {
+        throw DatabaseUnavailable("no MySQL connection available");
+    }
+    if (conn->get()->execPrepared(kInsertStmt, {username, password})) {
+        return InsertResult::Created;
+    }
+    return conn->get()->stmtErrorCode() == kDuplicateEntry ? InsertResult::Duplicate : InsertResult::Failed;
+}
+
+UserStore::FindResult MySQLUserStore::find(const std::string& username, std::string& passwd) {
+    auto conn = MySQLConnectionPool::Instance().getConnection();
+    if (!conn) {
+        throw DatabaseUnavailable("no MySQL connection available");
+    }
+    if (conn->get()->queryPrepared(kVerifyStmt, {username}, passwd)) {
+        return FindResult::Found;
+    }
+    // 查询成功但没有该用户时错误码为 0
+    return conn->get()->stmtErrorCode() == 0 ? FindResult::Absent : FindResult::Error;
+}
+
+bool MySQLUserStore::forEachUsername(const std::function<void(std::string_view)>& fn) {
+    auto conn = MySQLConnectionPool::Instance().getConnection();
+    if (!conn || !conn->get()->query("SELECT username FROM user")) {
+        return false;
+    }
+    while (MYSQL_ROW row = conn->get()->fetchRow()) {
+        if (row[0]) {
+            fn(row[0]);
+        }
+    }
+    return true;
+}
+
+std::string MySQLUserStore::verifySql(MySQLConnection& conn, const std::string& username) {
+    return "SELECT passwd FROM user WHERE username='" + escapeString(conn, username) + "'";
+}
+
+std::string MySQLUserStore::insertSql(MySQLConnection& conn, const std::string& username, const std::string& password) {
+    // Escape strings to prevent SQL injection
+    return "INSERT INTO user(username, passwd) VALUES('" + escapeString(conn, username) + "', '" +
+           escapeString(conn, password) + "')";
+}
+
+std::string MySQLUserStore::escapeString(MySQLConnection& conn, const std::string& str) {
+    std::vector<char> escaped(str.length() * 2 + 1);
+    mysql_real_escape_string(conn.getRawConn(), escaped.data(), str.c_str(), str.length());
+    return std::string(escaped.data());
+}
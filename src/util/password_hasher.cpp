@@ -0,0 +1,136 @@
+#include "password_hasher.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <vector>
+
+namespace {
+    constexpr std::string_view kPrefix = "$scrypt$";
+    constexpr size_t kSaltBytes = 16;
+    constexpr size_t kKeyBytes = 32;
+
+    std::string base64Encode(const unsigned char* data, size_t len) {
+        std::string out(4 * ((len + 2) / 3), '\0');
+        int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()), data, static_cast<int>(len));
+        out.resize(n > 0 ? static_cast<size_t>(n) : 0);
+        return out;
+    }
+
+    bool base64Decode(std::string_view in, std::vector<unsigned char>& out) {
+        if (in.empty() || in.size() % 4 != 0) {
+            return false;
+        }
+        out.resize(in.size() / 4 * 3);
+        int n = EVP_DecodeBlock(out.data(), reinterpret_cast<const unsigned char*>(in.data()), static_cast<int>(in.size()));
+        if (n < 0) {
+            return false;
+        }
+        // EVP_DecodeBlock 不去掉填充产生的零字节
+        size_t padding = (in.back() == '=') + (in.size() > 1 && in[in.size() - 2] == '=');
+        out.resize(static_cast<size_t>(n) - padding);
+        return true;
+    }
+
+    bool scrypt(std::string_view password, const unsigned char* salt, size_t salt_len, int log_n, int r, int p,
+                unsigned char* key, size_t key_len) {
+        uint64_t n = uint64_t {1} << log_n;
+        // scrypt 需要约 128 * r * (N + p) 字节，OpenSSL 默认上限 32MB，按参数放宽
+        uint64_t maxmem = 128 * static_cast<uint64_t>(r) * (n + static_cast<uint64_t>(p)) + (1 << 20);
+        return EVP_PBE_scrypt(password.data(), password.size(), salt, salt_len, n, static_cast<uint64_t>(r),
+                              static_cast<uint64_t>(p), maxmem, key, key_len) == 1;
+    }
+
+    bool constantTimeEquals(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+    }
+}
+
+PasswordHasher::Ticket::~Ticket() {
+    if (owner_) {
+        owner_->pending_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+PasswordHasher::PasswordHasher()
+    : hash_us_(Metrics::histogram("password_hash_us")),
+      shed_(Metrics::counter("password_hash_shed_total")) {}
+
+PasswordHasher& PasswordHasher::Instance() {
+    static PasswordHasher instance;
+    return instance;
+}
+
+void PasswordHasher::init(const Options& options) {
+    options_ = options;
+    options_.log_n = std::clamp(options_.log_n, 1, 30);
+    options_.r = std::max(1, options_.r);
+    options_.p = std::max(1, options_.p);
+    pool_ = std::make_unique<FThreadPool>(std::max<size_t>(1, options_.threads));
+}
+
+FThreadPool& PasswordHasher::pool() {
+    return *pool_;
+}
+
+PasswordHasher::Ticket PasswordHasher::admit() {
+    if (pending_.fetch_add(1, std::memory_order_relaxed) >= options_.max_pending) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        shed_.add();
+        throw HasherOverloaded();
+    }
+    return Ticket(*this);
+}
+
+std::string PasswordHasher::hashNow(std::string_view password) {
+    auto start = std::chrono::steady_clock::now();
+    unsigned char salt[kSaltBytes];
+    unsigned char key[kKeyBytes];
+    if (RAND_bytes(salt, sizeof(salt)) != 1 ||
+        !scrypt(password, salt, sizeof(salt), options_.log_n, options_.r, options_.p, key, sizeof(key))) {
+        throw std::runtime_error("scrypt failed");
+    }
+
+    char params[64];
+    std::snprintf(params, sizeof(params), "ln=%d,r=%d,p=%d$", options_.log_n, options_.r, options_.p);
+    std::string out = std::string(kPrefix) + params + base64Encode(salt, sizeof(salt)) + "$" +
+                      base64Encode(key, sizeof(key));
+    hash_us_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    return out;
+}
+
+bool PasswordHasher::verifyNow(std::string_view password, std::string_view stored) {
+    if (!stored.starts_with(kPrefix)) {
+        return constantTimeEquals(password, stored); // 未迁移的明文
+    }
+
+    // 参数取自存储的哈希本身
+    int log_n = 0, r = 0, p = 0, consumed = 0;
+    std::string header(stored.substr(kPrefix.size(), 48));
+    if (std::sscanf(header.c_str(), "ln=%d,r=%d,p=%d$%n", &log_n, &r, &p, &consumed) != 3 || consumed == 0 ||
+        log_n < 1 || log_n > 30 || r < 1 || p < 1) {
+        LOG_WARN("[PasswordHasher] Malformed stored hash");
+        return false;
+    }
+    std::string_view rest = stored.substr(kPrefix.size() + static_cast<size_t>(consumed));
+    size_t dollar = rest.find('$');
+    std::vector<unsigned char> salt, expected;
+    if (dollar == std::string_view::npos || !base64Decode(rest.substr(0, dollar), salt) ||
+        !base64Decode(rest.substr(dollar + 1), expected) || expected.empty()) {
+        LOG_WARN("[PasswordHasher] Malformed stored hash");
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> key(expected.size());
+    bool ok = scrypt(password, salt.data(), salt.size(), log_n, r, p, key.data(), key.size()) &&
+              CRYPTO_memcmp(key.data(), expected.data(), key.size()) == 0;
+    hash_us_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    return ok;
+}
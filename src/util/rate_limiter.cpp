@@ -0,0 +1,113 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+
+RateLimiter::RateLimiter()
+    : limited_(Metrics::counter("rate_limited_total")),
+      credential_limited_(Metrics::counter("rate_limited_credential_total")),
+      connection_limited_(Metrics::counter("connection_limited_total")) {}
+
+RateLimiter& RateLimiter::Instance() {
+    static RateLimiter instance;
+    return instance;
+}
+
+void RateLimiter::init(const Options& options) {
+    options_ = options;
+    options_.table_sets = std::bit_ceil(std::clamp<size_t>(options_.table_sets, 1, size_t {1} << 20));
+    set_bits_ = static_cast<uint32_t>(std::countr_zero(options_.table_sets));
+    rate_per_ms_ = static_cast<float>(options_.rate) / 1000.0f;
+    credential_rate_per_ms_ = static_cast<float>(options_.credential_rate) / 1000.0f;
+    epoch_ = std::chrono::steady_clock::now();
+}
+
+bool RateLimiter::exempt(uint32_t addr) const {
+    return std::find(options_.exempt.begin(), options_.exempt.end(), addr) != options_.exempt.end();
+}
+
+RateLimiter::Set& RateLimiter::setOf(uint32_t addr) {
+    thread_local std::unique_ptr<Set[]> table;
+    thread_local size_t table_sets = 0;
+    if (table_sets != options_.table_sets) {
+        table = std::make_unique<Set[]>(options_.table_sets); // 值初始化：全部为空位
+        table_sets = options_.table_sets;
+    }
+    // 乘法哈希取高位，set_bits_ 为 0 时只有一组
+    uint32_t index = set_bits_ == 0 ? 0 : (addr * 0x9E3779B1u) >> (32 - set_bits_);
+    return table[index];
+}
+
+bool RateLimiter::allow(uint32_t addr, Bucket bucket) {
+    if (!options_.enabled || addr == 0 || exempt(addr)) {
+        return true;
+    }
+    bool credential = bucket == Bucket::Credential;
+    if ((credential ? options_.credential_rate : options_.rate) == 0) {
+        return true;
+    }
+
+    auto now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - epoch_).count());
+    Set& set = setOf(addr);
+
+    Entry* entry = nullptr;
+    Entry* victim = &set.entries[0];
+    for (auto& candidate : set.entries) {
+        if (candidate.addr == addr) {
+            entry = &candidate;
+            break;
+        }
+        if (victim->addr != 0 && (candidate.addr == 0 || now - candidate.stamp_ms > now - victim->stamp_ms)) {
+            victim = &candidate;
+        }
+    }
+
+    if (!entry) {
+        // 新地址（或被淘汰后重新出现）从满桶开始
+        entry = victim;
+        *entry = {addr, now, static_cast<float>(options_.burst), static_cast<float>(options_.credential_burst)};
+    } else {
+        auto elapsed = static_cast<float>(now - entry->stamp_ms);
+        entry->stamp_ms = now;
+        entry->tokens = std::min(static_cast<float>(options_.burst), entry->tokens + elapsed * rate_per_ms_);
+        entry->credential_tokens = std::min(static_cast<float>(options_.credential_burst),
+                                            entry->credential_tokens + elapsed * credential_rate_per_ms_);
+    }
+
+    float& tokens = credential ? entry->credential_tokens : entry->tokens;
+    if (tokens < 1.0f) {
+        (credential ? credential_limited_ : limited_).add();
+        return false;
+    }
+    tokens -= 1.0f;
+    return true;
+}
+
+bool RateLimiter::acquireConnection(uint32_t addr) {
+    if (!options_.enabled || options_.max_connections == 0 || exempt(addr)) {
+        return true;
+    }
+    auto& shard = connShardOf(addr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint32_t& count = shard.counts[addr];
+    if (count >= options_.max_connections) {
+        connection_limited_.add();
+        return false;
+    }
+    ++count;
+    return true;
+}
+
+void RateLimiter::releaseConnection(uint32_t addr) {
+    if (!options_.enabled || options_.max_connections == 0 || exempt(addr)) {
+        return;
+    }
+    auto& shard = connShardOf(addr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.counts.find(addr);
+    if (it != shard.counts.end() && --it->second == 0) {
+        shard.counts.erase(it);
+    }
+}
@@ -0,0 +1,70 @@
+#include "register_batcher.h"
+#include "logger.h"
+#include "threadpool.h"
+
+#include <algorithm>
+
+RegisterBatcher::RegisterBatcher() : batch_rows_(Metrics::histogram("register_batch_rows")) {}
+
+RegisterBatcher& RegisterBatcher::Instance() {
+    static RegisterBatcher instance;
+    return instance;
+}
+
+void RegisterBatcher::init(size_t max_rows, Flush flush) {
+    max_rows_ = max_rows;
+    flush_ = std::move(flush);
+}
+
+void RegisterBatcher::submit(std::string_view username, std::string_view password, Done done) {
+    auto pending = std::make_unique<Pending>();
+    pending->row.username = username;
+    pending->row.password = password;
+    pending->done = std::move(done);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(pending));
+        // 已有一批在写：这一行由那个任务在写完后取走
+        if (flushing_) {
+            return;
+        }
+        flushing_ = true;
+    }
+    FThreadPool::getInst().pushTask([this](size_t) { drain(); });
+}
+
+void RegisterBatcher::drain() {
+    while (true) {
+        std::vector<std::unique_ptr<Pending>> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) {
+                flushing_ = false;
+                return;
+            }
+            size_t count = std::min(queue_.size(), max_rows_);
+            batch.assign(std::make_move_iterator(queue_.begin()),
+                         std::make_move_iterator(queue_.begin() + static_cast<std::ptrdiff_t>(count)));
+            queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+
+        batch_rows_.record(batch.size());
+        std::vector<Row*> rows;
+        rows.reserve(batch.size());
+        for (auto& pending : batch) {
+            rows.push_back(&pending->row);
+        }
+
+        std::exception_ptr error;
+        try {
+            flush_(rows);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (auto& pending : batch) {
+            pending->done(pending->row.result, error);
+        }
+    }
+}
@@ -0,0 +1,288 @@
+// 低层 SHA256_* 接口在 OpenSSL 3 中已标记弃用，但只有它能保存并复制 ipad / opad 中间状态（无堆分配）
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include "session_token.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+namespace {
+    constexpr size_t kMacBytes = SHA256_DIGEST_LENGTH;
+    constexpr size_t kMacChars = (kMacBytes * 8 + 5) / 6; // base64url 不带填充
+    constexpr size_t kMaxTokenLength = 512;
+
+    constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    int decodeChar(char c) {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '-') return 62;
+        if (c == '_') return 63;
+        return -1;
+    }
+
+    // base64url（无填充），返回写入的字符数
+    size_t encodeTo(const unsigned char* data, size_t len, char* out) {
+        size_t n = 0;
+        uint32_t acc = 0;
+        int bits = 0;
+        for (size_t i = 0; i < len; ++i) {
+            acc = (acc << 8) | data[i];
+            bits += 8;
+            while (bits >= 6) {
+                bits -= 6;
+                out[n++] = kAlphabet[(acc >> bits) & 0x3F];
+            }
+        }
+        if (bits > 0) {
+            out[n++] = kAlphabet[(acc << (6 - bits)) & 0x3F];
+        }
+        return n;
+    }
+
+    void encode(std::string_view in, std::string& out) {
+        size_t old = out.size();
+        out.resize(old + (in.size() * 8 + 5) / 6);
+        encodeTo(reinterpret_cast<const unsigned char*>(in.data()), in.size(), out.data() + old);
+    }
+
+    bool decode(std::string_view in, std::string& out) {
+        out.clear();
+        uint32_t acc = 0;
+        int bits = 0;
+        for (char c : in) {
+            int v = decodeChar(c);
+            if (v < 0) {
+                return false;
+            }
+            acc = (acc << 6) | static_cast<uint32_t>(v);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
+
+    bool validKeyId(std::string_view id) {
+        if (id.empty() || id.size() > 16) {
+            return false;
+        }
+        for (char c : id) {
+            if (decodeChar(c) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+struct SessionToken::KeyState {
+    std::string id;
+    SHA256_CTX inner; // 已吸收 key ^ ipad
+    SHA256_CTX outer; // 已吸收 key ^ opad
+
+    KeyState(std::string key_id, std::string_view secret) : id(std::move(key_id)) {
+        unsigned char block[SHA256_CBLOCK] = {};
+        if (secret.size() > sizeof(block)) {
+            SHA256(reinterpret_cast<const unsigned char*>(secret.data()), secret.size(), block);
+        } else {
+            std::copy(secret.begin(), secret.end(), block);
+        }
+        unsigned char pad[SHA256_CBLOCK];
+        for (size_t i = 0; i < sizeof(block); ++i) pad[i] = block[i] ^ 0x36;
+        SHA256_Init(&inner);
+        SHA256_Update(&inner, pad, sizeof(pad));
+        for (size_t i = 0; i < sizeof(block); ++i) pad[i] = block[i] ^ 0x5c;
+        SHA256_Init(&outer);
+        SHA256_Update(&outer, pad, sizeof(pad));
+        OPENSSL_cleanse(block, sizeof(block));
+        OPENSSL_cleanse(pad, sizeof(pad));
+    }
+
+    ~KeyState() {
+        OPENSSL_cleanse(&inner, sizeof(inner));
+        OPENSSL_cleanse(&outer, sizeof(outer));
+    }
+
+    void mac(std::string_view message, unsigned char out[kMacBytes]) const {
+        unsigned char digest[kMacBytes];
+        SHA256_CTX ctx = inner;
+        SHA256_Update(&ctx, message.data(), message.size());
+        SHA256_Final(digest, &ctx);
+        ctx = outer;
+        SHA256_Update(&ctx, digest, sizeof(digest));
+        SHA256_Final(out, &ctx);
+    }
+};
+
+struct SessionToken::KeyRing {
+    std::vector<KeyState> keys;
+    size_t active = 0;
+
+    const KeyState* find(std::string_view id) const {
+        for (const auto& key : keys) {
+            if (key.id == id) {
+                return &key;
+            }
+        }
+        return nullptr;
+    }
+};
+
+SessionToken::SessionToken()
+    : issued_(Metrics::counter("session_issued_total")),
+      rejected_(Metrics::counter("session_rejected_total")) {
+    setKeys({}, "");
+}
+
+SessionToken& SessionToken::Instance() {
+    static SessionToken instance;
+    return instance;
+}
+
+bool SessionToken::setKeys(const std::vector<Key>& keys, const std::string& active_id) {
+    auto ring = std::make_shared<KeyRing>();
+    if (keys.empty()) {
+        unsigned char secret[32];
+        if (RAND_bytes(secret, sizeof(secret)) != 1) {
+            LOG_ERROR("[SessionToken] Failed to generate session key");
+            return false;
+        }
+        ring->keys.emplace_back("local", std::string_view(reinterpret_cast<const char*>(secret), sizeof(secret)));
+        OPENSSL_cleanse(secret, sizeof(secret));
+    } else {
+        ring->keys.reserve(keys.size());
+        for (const auto& key : keys) {
+            if (!validKeyId(key.id) || key.secret.empty() || ring->find(key.id)) {
+                LOG_ERROR("[SessionToken] Invalid session key id:{}", key.id);
+                return false;
+            }
+            if (key.secret.size() < 32) {
+                LOG_WARN("[SessionToken] Session key {} is shorter than 32 bytes", key.id);
+            }
+            if (key.id == active_id) {
+                ring->active = ring->keys.size();
+            }
+            ring->keys.emplace_back(key.id, key.secret);
+        }
+        if (!ring->find(active_id)) {
+            LOG_ERROR("[SessionToken] Active session key {} not found", active_id);
+            return false;
+        }
+    }
+    ring_.store(std::move(ring));
+    return true;
+}
+
+std::string SessionToken::issue(std::string_view username) const {
+    auto ring = ring_.load();
+    const KeyState& key = ring->keys[ring->active];
+
+    std::string token;
+    token.reserve(key.id.size() + 24 + username.size() * 4 / 3 + kMacChars);
+    token.append(key.id).push_back('.');
+    token.append(std::to_string(std::time(nullptr) + ttl_)).push_back('.');
+    encode(username, token);
+
+    unsigned char mac[kMacBytes];
+    key.mac(token, mac);
+    token.push_back('.');
+    encode(std::string_view(reinterpret_cast<const char*>(mac), sizeof(mac)), token);
+    issued_.add();
+    return token;
+}
+
+SessionToken::Result SessionToken::verify(std::string_view token, std::string* username) const {
+    // kid . expires . user . mac
+    size_t mac_dot = token.rfind('.');
+    size_t kid_dot = token.find('.');
+    size_t exp_dot = kid_dot == std::string_view::npos ? kid_dot : token.find('.', kid_dot + 1);
+    if (token.size() > kMaxTokenLength || mac_dot == std::string_view::npos || exp_dot == std::string_view::npos ||
+        exp_dot >= mac_dot || token.size() - mac_dot - 1 != kMacChars) {
+        rejected_.add();
+        return Result::Invalid;
+    }
+
+    auto ring = ring_.load();
+    const KeyState* key = ring->find(token.substr(0, kid_dot));
+    if (!key) {
+        rejected_.add();
+        return Result::Invalid;
+    }
+
+    unsigned char mac[kMacBytes];
+    char expected[kMacChars];
+    key->mac(token.substr(0, mac_dot), mac);
+    encodeTo(mac, sizeof(mac), expected);
+    if (CRYPTO_memcmp(expected, token.data() + mac_dot + 1, kMacChars) != 0) {
+        rejected_.add();
+        return Result::Invalid;
+    }
+
+    // 签名通过后才解析内容
+    std::string_view exp_field = token.substr(kid_dot + 1, exp_dot - kid_dot - 1);
+    int64_t expires = 0;
+    auto [end, ec] = std::from_chars(exp_field.data(), exp_field.data() + exp_field.size(), expires);
+    if (ec != std::errc() || end != exp_field.data() + exp_field.size()) {
+        rejected_.add();
+        return Result::Invalid;
+    }
+    if (expires <= static_cast<int64_t>(std::time(nullptr))) {
+        rejected_.add();
+        return Result::Expired;
+    }
+    if (username && !decode(token.substr(exp_dot + 1, mac_dot - exp_dot - 1), *username)) {
+        rejected_.add();
+        return Result::Invalid;
+    }
+    return Result::Valid;
+}
+
+std::string SessionToken::setCookieValue(std::string_view username) const {
+    return cookie_name_ + "=" + issue(username) + "; Path=/; Max-Age=" + std::to_string(ttl_) +
+           "; HttpOnly; SameSite=Lax" + (cookie_secure_ ? "; Secure" : "");
+}
+
+std::string SessionToken::clearCookieValue() const {
+    return cookie_name_ + "=; Path=/; Max-Age=0; HttpOnly; SameSite=Lax" + (cookie_secure_ ? "; Secure" : "");
+}
+
+std::string_view SessionToken::findCookie(std::string_view cookie_header) const {
+    // name1=value1; name2=value2
+    while (!cookie_header.empty()) {
+        size_t semi = cookie_header.find(';');
+        std::string_view item = cookie_header.substr(0, semi);
+        cookie_header = semi == std::string_view::npos ? std::string_view {} : cookie_header.substr(semi + 1);
+        while (!item.empty() && item.front() == ' ') {
+            item.remove_prefix(1);
+        }
+        if (item.size() > cookie_name_.size() && item[cookie_name_.size()] == '=' && item.starts_with(cookie_name_)) {
+            return item.substr(cookie_name_.size() + 1);
+        }
+    }
+    return {};
+}
+
+std::vector<SessionToken::Key> SessionToken::parseKeys(std::string_view spec) {
+    std::vector<Key> keys;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view {} : spec.substr(comma + 1);
+        size_t colon = item.find(':');
+        if (colon == std::string_view::npos) {
+            LOG_WARN("[SessionToken] Ignoring malformed session key entry");
+            continue;
+        }
+        keys.push_back({std::string(item.substr(0, colon)), std::string(item.substr(colon + 1))});
+    }
+    return keys;
+}
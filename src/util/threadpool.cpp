@@ -7,9 +7,205 @@
 #include "config_manager.h"
 #include "logger.h"
 
-FThreadPool::FThreadPool(const size_t threadCount) : threadCnt_(threadCount) {
-    LOG_INFO("Compute ThreadPool init with {} workers", threadCount);
-    for (int i = 0; i < threadCnt_; i++) {
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    constexpr size_t kDequeCapacity = 256;   // 每个工作线程本地队列容量，满了转入注入队列
+    constexpr size_t kInjectCapacity = 4096; // 注入队列容量（2 的幂）
+    constexpr int kSpinRounds = 64;          // 找不到任务时休眠前的自旋轮数
+
+    // 当前线程所属的线程池与编号，外部线程为 nullptr
+    thread_local FThreadPool *tls_pool = nullptr;
+    thread_local size_t tls_index = 0;
+
+    void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    uint64_t nextRandom(uint64_t &state) {
+        // xorshift64
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+}
+
+/**
+ * Chase–Lev 双端队列（Lê et al. 2013 的 C11 内存序版本），容量固定
+ * 槽位直接存放 PoolTask：窃取方在 CAS 取得下标后才移出任务，完成后清除 full 标记，
+ * 队列绕回同一槽位时所有者等待该标记，保证不会覆盖尚未移出的任务
+ */
+class FThreadPool::WorkDeque {
+public:
+    WorkDeque() : slots_(std::make_unique<Slot[]>(kDequeCapacity)) {}
+
+    // 仅所有者调用
+    bool push(PoolTask &task) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(kDequeCapacity)) {
+            return false;
+        }
+        Slot &slot = slots_[b & kMask];
+        while (slot.full.load(std::memory_order_acquire)) {
+            cpuRelax(); // 上一轮窃取该槽位的线程尚未移出任务
+        }
+        slot.task = std::move(task);
+        slot.full.store(true, std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 仅所有者调用，LIFO
+    bool pop(PoolTask &out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_release);
+            return false;
+        }
+        if (t == b) {
+            // 最后一个任务，与窃取方竞争
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_release);
+            if (!won) {
+                return false;
+            }
+        }
+        take(slots_[b & kMask], out);
+        return true;
+    }
+
+    // 任意线程调用，FIFO
+    bool steal(PoolTask &out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        take(slots_[t & kMask], out);
+        return true;
+    }
+
+    bool empty() const {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr int64_t kMask = kDequeCapacity - 1;
+    static_assert((kDequeCapacity & (kDequeCapacity - 1)) == 0);
+
+    struct Slot {
+        PoolTask task;
+        std::atomic<bool> full{false};
+    };
+
+    static void take(Slot &slot, PoolTask &out) {
+        out = std::move(slot.task);
+        slot.full.store(false, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::unique_ptr<Slot[]> slots_;
+};
+
+/**
+ * 有界 MPMC 队列（Vyukov），每个槽位的序号决定它当前属于生产者还是消费者，任务原地存放
+ */
+class FThreadPool::InjectQueue {
+public:
+    InjectQueue() : cells_(std::make_unique<Cell[]>(kInjectCapacity)) {
+        for (size_t i = 0; i < kInjectCapacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(PoolTask &task) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & kMask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.task = std::move(task);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 满
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(PoolTask &out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & kMask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.task);
+                    cell.sequence.store(pos + kInjectCapacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 空
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) >= tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kMask = kInjectCapacity - 1;
+    static_assert((kInjectCapacity & (kInjectCapacity - 1)) == 0);
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        PoolTask task;
+    };
+
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::unique_ptr<Cell[]> cells_;
+};
+
+FThreadPool::FThreadPool(const size_t threadCount) :
+    threadCnt_(threadCount > 0 ? threadCount : 1),
+    injected_(std::make_unique<InjectQueue>()),
+    deadline_wait_us_(Metrics::histogram("pool_deadline_queue_wait_us")),
+    deadline_expired_(Metrics::counter("pool_deadline_dropped_expired_total")),
+    deadline_cancelled_(Metrics::counter("pool_deadline_dropped_cancelled_total")) {
+    LOG_INFO("Compute ThreadPool init with {} workers", threadCnt_);
+    deques_.reserve(threadCnt_);
+    for (size_t i = 0; i < threadCnt_; i++) {
+        deques_.push_back(std::make_unique<WorkDeque>());
+    }
+    for (size_t i = 0; i < threadCnt_; i++) {
         threads_.emplace_back(&FThreadPool::worker, this, i);
     }
 }
@@ -17,7 +213,8 @@ FThreadPool::FThreadPool(const size_t threadCount) : threadCnt_(threadCount) {
 FThreadPool::~FThreadPool() {
     waitTasksFinish();
     running_ = false; // break while
-    condition_.notify_all();
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
     for (auto &&t: threads_) {
         if (t.joinable()) {
             t.join();
@@ -30,52 +227,196 @@ FThreadPool &FThreadPool::getInst() {
     return inst;
 }
 
+FThreadPool &FThreadPool::getIoInst() {
+    static FThreadPool inst { static_cast<size_t>(ConfigManager::Instance().get<int>("server.aio_threads", 4)) };
+    return inst;
+}
+
 void FThreadPool::waitTasksFinish() const {
-    while (true) {
-        if (paused_) {
-            // atomic value
-            if (tasksCnt_ == 0)
-                break;
-        } else {
-            if (tasksRunningCnt() == 0)
-                break;
-        }
-        // sleep
+    while (pending_.load(std::memory_order_acquire) != 0) {
         std::this_thread::yield();
     }
 }
 
-size_t FThreadPool::tasksQueuedCnt() const {
-    const std::lock_guard<std::mutex> lock(mutex_);
-    return tasks_.size();
+void FThreadPool::submit(PoolTask &&task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // 本池工作线程提交的后续任务留在自己的队列里，缓存局部性最好
+    bool queued = tls_pool == this && deques_[tls_index]->push(task);
+    if (!queued && !injected_->push(task)) {
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_.push_back(std::move(task));
+        overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+    wakeOne();
 }
 
-void FThreadPool::worker(const size_t threadId) {
-    // TODO Maybe SpinLock can be used here.
-    while (running_) {
-        std::function<void(size_t)> task;
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            condition_.wait(lock, [this] { return !running_ || !tasks_.empty() && !paused_ && running_; });
-
-            if (tasks_.empty() && !running_) {
-                return;
-            }
+namespace {
+    // 堆顶为截止时间最早（同一截止时间先提交者优先）
+    struct LaterDeadline {
+        template<typename T>
+        bool operator()(const T &a, const T &b) const {
+            return a.deadline != b.deadline ? a.deadline > b.deadline : a.seq > b.seq;
+        }
+    };
+}
 
-            // 虚假唤醒？
-            if (tasks_.empty()) {
-                continue;
-            }
+void FThreadPool::submitDeadline(Deadline::TimePoint deadline, Deadline::CancelToken token, PoolTask &&task,
+                                 PoolTask &&onDrop) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(deadline_mutex_);
+        deadline_heap_.push_back({deadline, deadline_seq_++, std::move(token), Deadline::Clock::now(),
+                                  std::move(task), std::move(onDrop)});
+        std::push_heap(deadline_heap_.begin(), deadline_heap_.end(), LaterDeadline{});
+        deadline_size_.fetch_add(1, std::memory_order_release);
+    }
+    wakeOne();
+}
+
+bool FThreadPool::takeDeadlineTask(DeadlineTask &out) {
+    if (deadline_size_.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(deadline_mutex_);
+    if (deadline_heap_.empty()) {
+        return false;
+    }
+    std::pop_heap(deadline_heap_.begin(), deadline_heap_.end(), LaterDeadline{});
+    out = std::move(deadline_heap_.back());
+    deadline_heap_.pop_back();
+    deadline_size_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void FThreadPool::runDeadlineTask(const size_t threadId, DeadlineTask &timed) {
+    auto now = Deadline::Clock::now();
+    deadline_wait_us_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - timed.enqueued).count()));
+
+    // 已无人等待（连接已关闭）或已超时的任务不再执行，避免拥塞时做无用功
+    if (timed.token.cancelled() || now >= timed.deadline) {
+        (timed.token.cancelled() ? deadline_cancelled_ : deadline_expired_).add();
+        if (timed.on_drop) {
+            timed.on_drop(threadId);
+        }
+    } else {
+        Deadline::Scope scope(timed.deadline);
+        timed.task(threadId);
+    }
+    timed.task.reset();
+    timed.on_drop.reset();
+    timed.token = {};
+}
+
+void FThreadPool::wakeOne() {
+    // 与 park() 中的 fence 配对：要么这里看到休眠者，要么休眠前的检查看到新任务
+    // 已有线程在自旋找任务时无需唤醒，避免每次提交都进入 futex；该线程取到任务后负责唤醒下一个（见 worker）
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (spinning_.load(std::memory_order_relaxed) == 0 && sleepers_.load(std::memory_order_relaxed) > 0) {
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_one();
+    }
+}
 
-            // pop a task
-            task = std::move(tasks_.front());
-            tasks_.pop();
+bool FThreadPool::hasWork() const {
+    if (!injected_->empty() || overflow_size_.load(std::memory_order_acquire) > 0 ||
+        deadline_size_.load(std::memory_order_acquire) > 0) {
+        return true;
+    }
+    for (const auto &deque: deques_) {
+        if (!deque->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FThreadPool::park() {
+    uint32_t epoch = epoch_.load(std::memory_order_acquire);
+    sleepers_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (running_ && !hasWork()) {
+        epoch_.wait(epoch, std::memory_order_acquire);
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool FThreadPool::findTask(const size_t threadId, uint64_t &rng, PoolTask &task) {
+    if (deques_[threadId]->pop(task) || injected_->pop(task)) {
+        return true;
+    }
+    if (overflow_size_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (!overflow_.empty()) {
+            task = std::move(overflow_.back());
+            overflow_.pop_back();
+            overflow_size_.fetch_sub(1, std::memory_order_release);
+            return true;
         }
+    }
+    // 从随机位置开始依次尝试窃取其他线程
+    size_t start = nextRandom(rng) % threadCnt_;
+    for (size_t i = 0; i < threadCnt_; ++i) {
+        size_t victim = (start + i) % threadCnt_;
+        if (victim != threadId && deques_[victim]->steal(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FThreadPool::worker(const size_t threadId) {
+    tls_pool = this;
+    tls_index = threadId;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL * (threadId + 1);
 
-        ++runningThreadCount_;
-        // handle word
-        task(threadId);
-        --runningThreadCount_;
-        --tasksCnt_;
+    int idle = 0;
+    PoolTask task;
+    DeadlineTask timed;
+    while (true) {
+        // 截止时间任务（在线请求）优先于普通后台任务
+        bool isTimed = takeDeadlineTask(timed);
+        if (isTimed || findTask(threadId, rng, task)) {
+            if (idle > 0) {
+                idle = 0;
+                // 最后一个自旋者取到任务后若仍有积压，唤醒一个休眠者接着找：自旋期间提交方不会唤醒任何线程，
+                // 否则一次突发提交只会由这一个线程串行执行
+                if (spinning_.fetch_sub(1, std::memory_order_seq_cst) == 1 && hasWork()) {
+                    wakeOne();
+                }
+            }
+            if (isTimed) {
+                runDeadlineTask(threadId, timed);
+            } else {
+                task(threadId);
+                task.reset();
+            }
+            pending_.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+        if (!running_) {
+            if (idle > 0) {
+                spinning_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (idle++ == 0) {
+            spinning_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (idle < kSpinRounds) {
+            // 先短暂 pause，之后让出 CPU（线程数超过核数时不与持有任务的线程争抢）
+            if (idle < kSpinRounds / 4) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        spinning_.fetch_sub(1, std::memory_order_relaxed);
+        park();
+        // 被唤醒后按自旋者计数：取到任务时若仍有积压会接着唤醒下一个，突发提交由此逐个扩散到各线程
+        idle = 1;
+        spinning_.fetch_add(1, std::memory_order_relaxed);
     }
 }
@@ -1,8 +1,10 @@
 #include "user_service.h"
 #include "logger.h"
 #include "config_manager.h"
-#include "mysql_conn_pool.h"
-#include <vector>
+#include "credential_cache.h"
+#include "log_user_store.h"
+#include "mysql_user_store.h"
+#include "password_hasher.h"
 #include <string>
 
 UserService& UserService::Instance() {
@@ -11,95 +13,120 @@ UserService& UserService::Instance() {
 }
 
 bool UserService::init() {
-    // Initialize MySQL connection pool
-    return MySQLConnectionPool::Instance().init();
-}
+    auto& config = ConfigManager::Instance();
 
-bool UserService::registerUser(const std::string& username, const std::string& password) {
-    if (userExists(username)) {
-        return false;
+    PasswordHasher::Options hash_options;
+    hash_options.threads = static_cast<size_t>(config.get<int>("password.hash_threads", 2));
+    hash_options.max_pending = static_cast<size_t>(config.get<int>("password.max_pending", 64));
+    hash_options.log_n = config.get<int>("password.scrypt_log_n", 14);
+    hash_options.r = config.get<int>("password.scrypt_r", 8);
+    hash_options.p = config.get<int>("password.scrypt_p", 1);
+    PasswordHasher::Instance().init(hash_options);
+
+    std::string backend = config.get<std::string>("user_store.backend", "mysql");
+    if (backend == "embedded") {
+        LogUserStore::Options options;
+        options.dir = config.get<std::string>("user_store.dir", "data");
+        options.shards = static_cast<size_t>(config.get<int>("user_store.shards", 64));
+        options.fsync = config.get<bool>("user_store.fsync", true);
+        options.snapshot_bytes = static_cast<size_t>(config.get<int>("user_store.snapshot_bytes", 64 << 20));
+        store_ = std::make_unique<LogUserStore>(options);
+    } else {
+        store_ = std::make_unique<MySQLUserStore>();
     }
-    
-    auto conn = MySQLConnectionPool::Instance().getConnection();
-    if (!conn) {
-        LOG_ERROR("[UserService] Failed to get MySQL connection");
+
+    if (!store_->init()) {
+        LOG_ERROR("[UserService] Failed to initialize {} user store", store_->name());
         return false;
     }
-    
-    // Escape strings to prevent SQL injection
-    std::string safe_username = escapeString(username);
-    std::string safe_password = escapeString(password);
-    
-    std::string sql = "INSERT INTO user(username, passwd) VALUES('" + 
-                      safe_username + "', '" + safe_password + "')";
-                      
-    return conn->get()->exec(sql);
-}
+    LOG_INFO("[UserService] Using {} user store", store_->name());
 
-bool UserService::verifyUser(const std::string& username, const std::string& password) {
-    auto conn = MySQLConnectionPool::Instance().getConnection();
-    if (!conn) {
-        LOG_ERROR("[UserService] Failed to get MySQL connection");
-        return false;
+    // 本地内存索引本身就是内存速度，缓存只加在远程存储前
+    if (store_->remote()) {
+        initCredentialCache();
     }
-    
-    std::string safe_username = escapeString(username);
-    std::string safe_password = escapeString(password);
-    
-    std::string sql = "SELECT passwd FROM user WHERE username='" + safe_username + "'";
-    
-    if (!conn->get()->query(sql)) {
-        return false;
+    return true;
+}
+
+void UserService::initCredentialCache() {
+    auto& config = ConfigManager::Instance();
+    if (!config.get<bool>("auth_cache.enabled", true)) {
+        return;
     }
-    
-    MYSQL_RES* result = conn->get()->getResult();
-    if (!result) {
-        return false;
+
+    CredentialCache::Options options;
+    options.capacity = static_cast<size_t>(config.get<int>("auth_cache.capacity", 100000));
+    options.ttl = std::chrono::milliseconds(config.get<int>("auth_cache.ttl_ms", 60000));
+    options.negative_ttl = std::chrono::milliseconds(config.get<int>("auth_cache.negative_ttl_ms", 5000));
+    if (config.get<bool>("auth_cache.bloom", true)) {
+        options.bloom_counters = static_cast<size_t>(config.get<int>("auth_cache.bloom_counters", 1 << 22));
+        options.bloom_hashes = config.get<int>("auth_cache.bloom_hashes", 4);
     }
-    
-    MYSQL_ROW row = conn->get()->fetchRow();
-    if (!row) {
-        return false;
+    CredentialCache::Instance().init(options);
+
+    if (options.bloom_counters > 0 && !loadBloomFilter()) {
+        LOG_WARN("[UserService] Bloom filter not loaded, every lookup goes to MySQL");
     }
-    
-    return password == row[0];  // Compare with stored password
 }
 
-bool UserService::userExists(const std::string& username) {
-    auto conn = MySQLConnectionPool::Instance().getConnection();
-    if (!conn) {
-        LOG_ERROR("[UserService] Failed to get MySQL connection");
-        return false;
-    }
-    
-    std::string safe_username = escapeString(username);
-    std::string sql = "SELECT COUNT(*) FROM user WHERE username='" + safe_username + "'";
-    
-    if (!conn->get()->query(sql)) {
+bool UserService::loadBloomFilter() {
+    auto& cache = CredentialCache::Instance();
+    size_t count = 0;
+    if (!store_->forEachUsername([&cache, &count](std::string_view username) {
+            cache.bloomAdd(username);
+            ++count;
+        })) {
         return false;
     }
-    
-    MYSQL_RES* result = conn->get()->getResult();
-    if (!result) {
-        return false;
+    cache.bloomReady();
+    LOG_INFO("[UserService] Bloom filter loaded with {} users", count);
+    return true;
+}
+
+CredentialCache::Lookup UserService::cachedCredential(const std::string& username, std::string& stored) {
+    return CredentialCache::Instance().get(username, stored);
+}
+
+void UserService::rememberCredential(const std::string& username, const std::string* stored) {
+    if (stored) {
+        CredentialCache::Instance().put(username, *stored);
+    } else {
+        CredentialCache::Instance().putAbsent(username);
     }
-    
-    MYSQL_ROW row = conn->get()->fetchRow();
-    if (!row) {
-        return false;
+}
+
+void UserService::onRegistered(const std::string& username) {
+    auto& cache = CredentialCache::Instance();
+    cache.invalidate(username);
+    cache.bloomAdd(username);
+}
+
+UserStore::FindResult UserService::findCredential(const std::string& username, std::string& stored) {
+    auto result = store_->find(username, stored);
+    if (result == UserStore::FindResult::Found) {
+        rememberCredential(username, &stored);
+    } else if (result == UserStore::FindResult::Absent) {
+        rememberCredential(username, nullptr);
     }
-    
-    return std::stoi(row[0]) > 0;
+    return result;
 }
 
-std::string UserService::escapeString(const std::string& str) {
-    auto conn = MySQLConnectionPool::Instance().getConnection();
-    if (!conn) {
-        LOG_ERROR("[UserService] Failed to get MySQL connection for escaping string");
-        return str;
+UserStore::InsertResult UserService::insertUser(const std::string& username, const std::string& hashed) {
+    auto result = store_->insert(username, hashed);
+    if (result == UserStore::InsertResult::Created) {
+        onRegistered(username);
+    } else if (result == UserStore::InsertResult::Duplicate) {
+        LOG_DEBUG("[UserService] User already exists: {}", username);
     }
-    
-    std::vector<char> escaped(str.length() * 2 + 1);
-    mysql_real_escape_string(conn->get()->getRawConn(), escaped.data(), str.c_str(), str.length());
-    return std::string(escaped.data());
-}
\ No newline at end of file
+    return result;
+}
+
+void UserService::insertUserAsync(const std::string& username, const std::string& hashed, UserStore::InsertDone done) {
+    store_->insertAsync(username, hashed, [this, &username, done = std::move(done)](UserStore::InsertResult result,
+                                                                                  std::exception_ptr error) {
+        if (!error && result == UserStore::InsertResult::Created) {
+            onRegistered(username);
+        }
+        done(result, error);
+    });
+}
@@ -0,0 +1,222 @@
+#include "asset_fingerprint.h"
+#include "compression.h"
+#include "logger.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+    // 流式 FNV-1a 64，取前 12 位十六进制作为指纹
+    class Digest {
+    public:
+        void update(const char* data, size_t len) {
+            for (size_t i = 0; i < len; ++i) {
+                h_ ^= static_cast<unsigned char>(data[i]);
+                h_ *= 0x100000001b3ULL;
+            }
+        }
+
+        std::string hex() const {
+            char buf[17];
+            std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h_));
+            return std::string(buf, 12);
+        }
+
+    private:
+        uint64_t h_ = 0xcbf29ce484222325ULL;
+    };
+
+    bool hashFile(const std::filesystem::path& path, std::string& out) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        Digest digest;
+        char buf[64 * 1024];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+            digest.update(buf, static_cast<size_t>(n));
+        }
+        ::close(fd);
+        if (n < 0) {
+            return false;
+        }
+        out = digest.hex();
+        return true;
+    }
+
+    bool isPage(const std::filesystem::path& path) {
+        return path.extension() == ".html" || path.extension() == ".htm";
+    }
+
+    // 页面在启动时一次性按最高级别压缩，请求路径上只做内容协商
+    std::shared_ptr<const std::string> precompress(Compression::Encoding encoding, const std::string& body, int level) {
+        std::string out;
+        if (!Compression::available(encoding) || !Compression::compress(encoding, body, out, level) ||
+            out.size() >= body.size()) {
+            return nullptr;
+        }
+        return std::make_shared<const std::string>(std::move(out));
+    }
+}
+
+AssetFingerprint& AssetFingerprint::Instance() {
+    static AssetFingerprint instance;
+    return instance;
+}
+
+void AssetFingerprint::build(const std::string& doc_root) {
+    namespace fs = std::filesystem;
+    doc_root_ = doc_root;
+    hashes_.clear();
+    pages_.clear();
+
+    std::vector<fs::path> pages;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(doc_root, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        const auto& path = it->path();
+        if (path.extension() == ".gz" || path.extension() == ".zst") {
+            continue;
+        }
+        if (isPage(path)) {
+            pages.push_back(path);
+            continue;
+        }
+        std::string hash;
+        if (hashFile(path, hash)) {
+            hashes_["/" + fs::relative(path, doc_root).generic_string()] = std::move(hash);
+        }
+    }
+
+    for (const auto& path : pages) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream html;
+        html << in.rdbuf();
+
+        auto rel = fs::relative(path, doc_root);
+        std::string page_dir = (fs::path("/") / rel.parent_path()).generic_string();
+        std::string rewritten = rewrite(html.str(), page_dir);
+        if (rewritten == html.str()) {
+            continue;
+        }
+
+        Digest digest;
+        digest.update(rewritten.data(), rewritten.size());
+        std::string etag = "\"" + digest.hex() + "\"";
+        auto& page = pages_[doc_root + "/" + rel.generic_string()];
+        page.gzip = precompress(Compression::Encoding::GZIP, rewritten, 9);
+        page.zstd = precompress(Compression::Encoding::ZSTD, rewritten, 19);
+        page.body = std::make_shared<const std::string>(std::move(rewritten));
+        page.etag = std::move(etag);
+    }
+
+    enabled_ = true;
+    LOG_INFO("[AssetFingerprint] {} assets fingerprinted, {} pages rewritten", hashes_.size(), pages_.size());
+}
+
+bool AssetFingerprint::resolve(std::string_view uri, std::string& name, bool& current) const {
+    if (!enabled_ || !uri.starts_with(kPrefix)) {
+        return false;
+    }
+    uri.remove_prefix(kPrefix.size());
+    auto slash = uri.find('/');
+    if (slash == std::string_view::npos) {
+        return false;
+    }
+
+    auto it = hashes_.find(std::string(uri.substr(slash)));
+    if (it == hashes_.end()) {
+        return false;
+    }
+    name = it->first;
+    current = it->second == uri.substr(0, slash);
+    return true;
+}
+
+const AssetFingerprint::Page* AssetFingerprint::page(const std::string& filepath) const {
+    auto it = pages_.find(filepath);
+    return it == pages_.end() ? nullptr : &it->second;
+}
+
+std::string AssetFingerprint::alias(const std::string& name) const {
+    auto it = hashes_.find(name);
+    if (it == hashes_.end()) {
+        return {};
+    }
+    return std::string(kPrefix) + it->second + name;
+}
+
+std::string AssetFingerprint::rewrite(const std::string& html, const std::string& page_dir) const {
+    static constexpr std::string_view kAttrs[] = {"src", "href", "poster"};
+
+    std::string out;
+    size_t copied = 0;
+    size_t pos = 0;
+    while ((pos = html.find('=', pos)) != std::string::npos) {
+        size_t eq = pos++;
+        bool is_ref = false;
+        for (auto attr : kAttrs) {
+            if (eq < attr.size() + 1) {
+                continue;
+            }
+            size_t begin = eq - attr.size();
+            bool same = true;
+            for (size_t i = 0; i < attr.size(); ++i) {
+                if (std::tolower(static_cast<unsigned char>(html[begin + i])) != attr[i]) {
+                    same = false;
+                    break;
+                }
+            }
+            if (same && std::isspace(static_cast<unsigned char>(html[begin - 1]))) {
+                is_ref = true;
+                break;
+            }
+        }
+        if (!is_ref || eq + 1 >= html.size() || (html[eq + 1] != '"' && html[eq + 1] != '\'')) {
+            continue;
+        }
+
+        size_t value_begin = eq + 2;
+        size_t value_end = html.find(html[eq + 1], value_begin);
+        if (value_end == std::string::npos) {
+            break;
+        }
+        pos = value_end + 1;
+
+        // 只改写站内相对/绝对路径，保留 ?query 与 #fragment
+        std::string_view value(html.data() + value_begin, value_end - value_begin);
+        if (value.empty() || value.find("://") != std::string_view::npos || value.starts_with("//") ||
+            value.starts_with("data:") || value.starts_with("#")) {
+            continue;
+        }
+        auto suffix_pos = value.find_first_of("?#");
+        std::string_view suffix = suffix_pos == std::string_view::npos ? std::string_view {} : value.substr(suffix_pos);
+        std::filesystem::path target(std::string(value.substr(0, suffix_pos)));
+        if (target.is_relative()) {
+            target = std::filesystem::path(page_dir) / target;
+        }
+        std::string name = target.lexically_normal().generic_string();
+
+        std::string replacement = alias(name);
+        if (replacement.empty()) {
+            continue;
+        }
+        out.append(html, copied, value_begin - copied);
+        out += replacement;
+        out += suffix;
+        copied = value_end;
+    }
+    out.append(html, copied, std::string::npos);
+    return out;
+}
@@ -0,0 +1,143 @@
+#include "coro.h"
+#include "http_request.h"
+#include "sub_reactor.h"
+
+#include <algorithm>
+#include <array>
+#include <new>
+#include <sys/epoll.h>
+
+namespace Coro {
+    namespace {
+        constexpr size_t kGranularity = 64;
+        constexpr size_t kClasses = 32;             // 最大池化 2KB 的帧，更大的直接走堆
+        constexpr size_t kMaxFreePerClass = 256;
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct LocalPool {
+            std::array<FreeBlock*, kClasses> heads {};
+            std::array<size_t, kClasses> counts {};
+
+            ~LocalPool() {
+                for (auto* head : heads) {
+                    while (head) {
+                        auto* next = head->next;
+                        ::operator delete(head);
+                        head = next;
+                    }
+                }
+            }
+        };
+
+        thread_local LocalPool tls_pool;
+
+        size_t classOf(size_t size) { return (size + kGranularity - 1) / kGranularity - 1; }
+
+        // 顶层协程：立即开始，结束时自行销毁
+        struct Detached {
+            struct promise_type : PooledFrame {
+                Detached get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        Detached runDetached(Task<> task, std::function<void(std::exception_ptr)> done) {
+            std::exception_ptr error;
+            try {
+                co_await task;
+            } catch (...) {
+                error = std::current_exception();
+            }
+            done(error);
+        }
+    }
+
+    void* FramePool::allocate(size_t size) {
+        size_t cls = classOf(size);
+        if (cls >= kClasses) {
+            return ::operator new(size);
+        }
+        if (auto* block = tls_pool.heads[cls]) {
+            tls_pool.heads[cls] = block->next;
+            --tls_pool.counts[cls];
+            return block;
+        }
+        return ::operator new((cls + 1) * kGranularity);
+    }
+
+    void FramePool::deallocate(void* p, size_t size) noexcept {
+        size_t cls = classOf(size);
+        if (cls >= kClasses || tls_pool.counts[cls] >= kMaxFreePerClass) {
+            ::operator delete(p);
+            return;
+        }
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = tls_pool.heads[cls];
+        tls_pool.heads[cls] = block;
+        ++tls_pool.counts[cls];
+    }
+
+    namespace detail {
+        SubReactor& currentReactor() {
+            SubReactor* reactor = SubReactor::current();
+            if (!reactor) {
+                throw std::logic_error("coroutine awaited outside of a SubReactor thread");
+            }
+            return *reactor;
+        }
+
+        std::shared_ptr<ReactorLink> currentLink() {
+            return currentReactor().link();
+        }
+
+        void resumeOn(const std::shared_ptr<ReactorLink>& owner, std::coroutine_handle<> h) {
+            owner->queueInLoop([h]() { h.resume(); });
+        }
+    }
+
+    void spawn(Task<> task, std::function<void(std::exception_ptr)> done) {
+        runDetached(std::move(task), std::move(done));
+    }
+
+    void SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+        detail::currentReactor().runAfter(delay_, [h]() { h.resume(); });
+    }
+
+    void FdAwaiter::await_suspend(std::coroutine_handle<> h) {
+        SubReactor& reactor = detail::currentReactor();
+        uint64_t id = reactor.watchFd(fd_, events_, [this, h](uint32_t revents) {
+            revents_ = revents;
+            h.resume();
+        });
+        if (timeout_.count() > 0) {
+            // 定时器不随就绪撤销；触发时按编号确认仍是本次等待
+            reactor.runAfter(timeout_, [&reactor, fd = fd_, id, h]() {
+                if (reactor.unwatchFd(fd, id)) {
+                    h.resume();
+                }
+            });
+        }
+    }
+
+    FdAwaiter readable(int fd, std::chrono::milliseconds timeout) { return FdAwaiter(fd, EPOLLIN, timeout); }
+
+    FdAwaiter writable(int fd, std::chrono::milliseconds timeout) { return FdAwaiter(fd, EPOLLOUT, timeout); }
+
+    BodyReader::BodyReader(const HttpRequest& request, size_t chunk_size) :
+        body_(request.body()), chunk_size_(std::max<size_t>(chunk_size, 1)) {}
+
+    std::string_view BodyReader::take() noexcept {
+        if (done()) {
+            return {};
+        }
+        auto chunk = body_.substr(offset_, chunk_size_);
+        offset_ += chunk.size();
+        return chunk;
+    }
+}
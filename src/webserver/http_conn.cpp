@@ -21,6 +21,8 @@
 #include "http_response.h"
 #include "http_router.h"
 #include "logger.h"
+#include "mime_types.h"
+#include "rate_limiter.h"
 
 bool HttpConnection::use_sendfile_ = false;
 
@@ -31,6 +33,8 @@ void HttpConnection::Init(int fd, int epoll_fd, sockaddr_in client_addr) {
     client_addr_ = client_addr;
 
     use_edge_trig_ = true;
+    generation_ = ++generation_counter_;
+    pacing_rate_ = 0;
 
     // 设置客户端 socket 为非阻塞
     EpollUtil::setNonBlocking(conn_fd_);
@@ -47,6 +51,15 @@ void HttpConnection::Init() {
     parser_.reset();
     response_.reset(); // 确保HttpResponse也被正确初始化
     closing_ = false;
+    write_budget_exhausted_ = false;
+    awaiting_input_ = false;
+    readahead_pending_ = false;
+    readahead_dispatched_ = false;
+    offload_job_.reset();
+    offload_pending_ = false;
+    // 连接关闭或复用：尚在线程池中排队的请求不再执行
+    offload_cancel_.cancel();
+    offload_cancel_ = {};
 }
 
 void HttpConnection::Destroy() {
@@ -65,6 +78,8 @@ void HttpConnection::Destroy() {
         LOG_DEBUG("Close success, fd:{}", conn_fd_);
     }
     conn_fd_ = -1;
+    // 归还 accept 时占用的每地址连接名额
+    RateLimiter::Instance().releaseConnection(client_addr_.sin_addr.s_addr);
 
     // reset buffer resources
     // eg: mmap failed: Cannot allocate memory
@@ -85,46 +100,101 @@ HttpStatus to_http_status(ParseResult result) {
 
 bool HttpConnection::ReadOnce() {
     // 统一由 read_buffer 处理正常读取和优雅关闭
-    return read_buffer_.read_from(conn_fd_, use_edge_trig_, closing_);
+    return read_buffer_.read_from(conn_fd_, use_edge_trig_, closing_, io_budget_bytes_, io_budget_iterations_);
 }
 
 bool HttpConnection::WriteOnce() {
-    WriteResult result = write_buffer_.write_to(conn_fd_);
+    write_budget_exhausted_ = false;
+    if (awaiting_input_) {
+        return true; // 请求未读完，没有可写的响应（避免 Init 清掉已读的半个请求）
+    }
+    if (readahead_pending_ || offload_pending_) {
+        return true; // 预读或线程池处理尚未完成，等待 SubReactor 回调恢复
+    }
 
-    switch (result) {
-        case WriteResult::SUCCESS:
-            write_buffer_.reset();
-            // according to request parsing result
-            if (!write_buffer_.should_close()) {
-                Init();
-                EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLIN, use_edge_trig_);
+    size_t sent_before = write_buffer_.bytes_sent();
+    for (int iterations = 1;; ++iterations) {
+        // 冷文件：先把窗口交给 I/O 线程预读，避免 sendfile/缺页阻塞整个 SubReactor
+        if (write_buffer_.needs_readahead(readahead_window_, readahead_min_bytes_, readahead_hint_)) {
+            LOG_DEBUG("Conn fd:{} file window not resident, offset:{}, len:{}", conn_fd_,
+                      readahead_hint_.offset, readahead_hint_.length);
+            readahead_pending_ = true;
+            readahead_dispatched_ = false;
+            readahead_attempts_ = 0;
+            return true;
+        }
+
+        WriteResult result = write_buffer_.write_to(conn_fd_);
+
+        switch (result) {
+            case WriteResult::PROGRESS:
+                // socket 仍可写：预算内继续写，超出预算则让出本轮
+                if (iterations >= io_budget_iterations_ ||
+                    write_buffer_.bytes_sent() - sent_before >= io_budget_bytes_) {
+                    write_budget_exhausted_ = true;
+                    return true;
+                }
+                continue;
+
+            case WriteResult::SUCCESS:
+                write_buffer_.reset();
+                // according to request parsing result
+                if (!write_buffer_.should_close()) {
+                    Init();
+                    EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLIN, use_edge_trig_);
+                    return true; // 不销毁连接
+                } else {
+                    // 需要关闭连接：开始优雅关闭流程
+                    BeginGracefulClose();
+                    return true; // 暂时不销毁，等待对端关闭
+                    // if (fcntl(conn_fd_, F_GETFD) < 0) {
+                    //     LOG_ERROR("Fd:{} has been closed before you do!, err:{}", conn_fd_, strerror(errno));
+                    // }
+                    // LOG_DEBUG("Close for demand, fd:{}", conn_fd_);
+                    // return false;
+                }
+
+            case WriteResult::CONTINUE:
+                // 需要继续写，重新注册 EPOLLOUT（尤其 ONESHOT 必须这么做）
+                EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLOUT, use_edge_trig_);
                 return true; // 不销毁连接
-            } else {
-                // 需要关闭连接：开始优雅关闭流程
-                BeginGracefulClose();
-                return true; // 暂时不销毁，等待对端关闭
-                // if (fcntl(conn_fd_, F_GETFD) < 0) {
-                //     LOG_ERROR("Fd:{} has been closed before you do!, err:{}", conn_fd_, strerror(errno));
-                // }
-                // LOG_DEBUG("Close for demand, fd:{}", conn_fd_);
-                // return false;
-            }
 
-        case WriteResult::CONTINUE:
-            // 需要继续写，重新注册 EPOLLOUT（尤其 ONESHOT 必须这么做）
-            EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLOUT, use_edge_trig_);
-            return true; // 不销毁连接
+            case WriteResult::ERROR:
+                write_buffer_.reset();
+                // write error 可能是客户端主动断开（如视频播放器），这是正常的
+                LOG_DEBUG("Close connection due to write error, fd:{}", conn_fd_);
+                return false; // 销毁连接
+        }
 
-        case WriteResult::ERROR:
-            write_buffer_.reset();
-            // write error 可能是客户端主动断开（如视频播放器），这是正常的
-            LOG_DEBUG("Close connection due to write error, fd:{}", conn_fd_);
-            return false; // 销毁连接
+        // dummy
+        LOG_INFO("Close for write res no match, fd:{}", conn_fd_);
+        return false;
     }
+}
 
-    // dummy
-    LOG_INFO("Close for write res no match, fd:{}", conn_fd_);
-    return false;
+bool HttpConnection::TakeReadahead(int& file_fd, OutputBuffer::ReadaheadHint& hint) {
+    if (!readahead_pending_ || readahead_dispatched_) {
+        return false;
+    }
+    readahead_dispatched_ = true;
+    ++readahead_attempts_;
+    file_fd = write_buffer_.dup_file_fd();
+    hint = readahead_hint_;
+    return true;
+}
+
+bool HttpConnection::ResumeAfterReadahead() {
+    if (!readahead_pending_) {
+        return true;
+    }
+    readahead_dispatched_ = false;
+    // 内存压力下预读的页可能已被回收：再预读一次，仍不常驻就同步发送这一窗口，避免无限重试
+    if (!write_buffer_.window_resident(readahead_hint_) && readahead_attempts_ < kMaxReadaheadAttempts) {
+        return false;
+    }
+    write_buffer_.mark_resident(readahead_hint_);
+    readahead_pending_ = false;
+    return true;
 }
 
 void HttpConnection::BeginGracefulClose() {
@@ -138,50 +208,107 @@ void HttpConnection::BeginGracefulClose() {
     EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLIN, use_edge_trig_);
 }
 
-bool HttpConnection::PreHandlersCheck(const HttpRequest& request, HttpResponse& response_) {
+bool HttpConnection::PreHandlersCheck(const HttpRequest& request, HttpResponse& response_,
+                                      const RouteMiddleware* route) {
     // --- Pre-processing ---
-    for (const auto& handler : pre_handlers_) {
-        handler(request, response_);
-        if (response_.is_error()) {
-            return false;
-        }
+    // 先全局、再路由级；任一中间件短路或已生成错误响应即停止
+    if (!pre_handlers_.run(request, response_) || (route && !route->before.run(request, response_))) {
+        return false;
     }
-    return true;
+    return !response_.is_error();
 }
 
-bool HttpConnection::PostHandlersCheck(const HttpRequest& request, HttpResponse& response_) {
+void HttpConnection::PostHandlersCheck(const HttpRequest& request, HttpResponse& response_,
+                                       const RouteMiddleware* route) {
     // --- Post-processing ---
-    for (const auto& handler : post_handlers_) {
-        handler(request, response_);
+    if (route && !route->after.run(request, response_)) {
+        return;
     }
-    return true;
+    post_handlers_.run(request, response_);
 }
 
 void HttpConnection::ProcessHttp() {
 
     HttpRequest request;
+    ConcurrencyLimiter::Permit permit;
+    MicroCache::Ticket cache;
+    const RouteMiddleware* route = nullptr;
     ParseResult parse_result = parser_.parse({read_buffer_.data(), read_buffer_.readable_bytes()}, request);
     LOG_DEBUG("[HttpConnection] Processing request uri:{}, fd:{}, parse_res: {}", request.uri(), conn_fd_, static_cast<int>(parse_result));
     response_.reset();
+    awaiting_input_ = parse_result == ParseResult::INCOMPLETE;
 
     switch (parse_result) {
         case ParseResult::OK:
             read_buffer_.retrieve(parser_.consumed_bytes()); // 移动读指针
+            request.set_client_addr(client_addr_.sin_addr.s_addr);
+            route = HttpRouter::instance().middleware(request);
 
-            if (!PreHandlersCheck(request, response_)) {
+            if (!PreHandlersCheck(request, response_, route)) {
                 LOG_DEBUG("Conn fd:{} Pre-handle Check not Passed.", conn_fd_);
                 break;
             }
 
+            // 响应微缓存：命中直接应答；同一 key 正在计算时挂起，等那次计算的结果，不再重复执行处理函数
+            if (!response_.is_handled()) {
+                if (const auto* policy = HttpRouter::instance().micro_cache(request)) {
+                    std::shared_ptr<MicroCache::Flight> flight;
+                    auto lookup = MicroCache::Instance().lookup(request, *policy, response_, flight, cache);
+                    if (lookup == MicroCache::Lookup::Wait) {
+                        offload_cancel_ = Deadline::CancelToken::create();
+                        offload_job_ = std::make_unique<OffloadJob>(OffloadJob {
+                            std::move(request), std::move(response_), Deadline::kNone, offload_cancel_,
+                            nullptr, nullptr, {}, {}, std::move(flight)});
+                        response_.reset();
+                        offload_pending_ = true;
+                        LOG_DEBUG("Conn fd:{} waiting for an in-flight response.", conn_fd_);
+                        return;
+                    }
+                    if (lookup == MicroCache::Lookup::Served && cache) {
+                        ScheduleRevalidation(request, route, std::move(cache));
+                    }
+                }
+            }
+
+            // 路由隔离舱：慢路由（访问数据库）在途数已满时直接 503，不排队、不占用线程池与连接池
+            if (!response_.is_handled()) {
+                if (auto* bulkhead = HttpRouter::instance().bulkhead(request)) {
+                    permit = bulkhead->tryAcquire();
+                    if (!permit) {
+                        response_.set_error_page(HttpStatus::SERVICE_UNAVAILABLE);
+                        response_.add_header("Retry-After", "1");
+                        LOG_DEBUG("Conn fd:{} rejected by bulkhead {}.", conn_fd_, bulkhead->name());
+                        break;
+                    }
+                }
+            }
+
+            // 协程路由：请求与响应移交给处理协程，在本 reactor 上运行，挂起期间 fd 同样保持未武装
+            if (!response_.is_handled()) {
+                if (const auto* handler = HttpRouter::instance().coroutine(request)) {
+                    offload_cancel_ = Deadline::CancelToken::create();
+                    offload_job_ = std::make_unique<OffloadJob>(OffloadJob {
+                        std::move(request), std::move(response_),
+                        offload_timeout_.count() > 0 ? Deadline::Clock::now() + offload_timeout_ : Deadline::kNone,
+                        offload_cancel_, handler, route, std::move(permit), std::move(cache), nullptr});
+                    response_.reset();
+                    offload_pending_ = true;
+                    LOG_DEBUG("Conn fd:{} dispatched to coroutine handler.", conn_fd_);
+                    return;
+                }
+            }
+
             // handle
             if (!response_.is_handled()) { // 没被拦截
                 HttpRouter::instance().match(request, response_); // 处理业务逻辑
+                permit.release(static_cast<int>(response_.status()) >= 500);
                 LOG_DEBUG("Conn req fd:{} handled.", conn_fd_);
             } else {
                 LOG_DEBUG("Conn fd:{} Intercepted.", conn_fd_);
             }
 
-            PostHandlersCheck(request, response_);
+            PostHandlersCheck(request, response_, route);
+            cache.complete(response_); // 缓存经后置中间件（压缩）处理后的最终响应
             break;
         case ParseResult::INCOMPLETE:
             // 继续等待
@@ -195,6 +322,79 @@ void HttpConnection::ProcessHttp() {
             break;
     }
 
+    PrepareResponse(request.method() == HttpRequest::Method::HEAD);
+}
+
+void HttpConnection::ScheduleRevalidation(const HttpRequest& request, const RouteMiddleware* route,
+                                          MicroCache::Ticket ticket) {
+    // 与普通请求一样受隔离舱约束：名额已满时放弃这次刷新（ticket 析构即结束计算），条目在 stale_while_revalidate 内继续可用
+    ConcurrencyLimiter::Permit permit;
+    if (auto* bulkhead = HttpRouter::instance().bulkhead(request)) {
+        permit = bulkhead->tryAcquire();
+        if (!permit) {
+            LOG_DEBUG("Conn fd:{} revalidation skipped by bulkhead {}.", conn_fd_, bulkhead->name());
+            return;
+        }
+    }
+    // 刷新不属于任何连接：在本线程执行，不受连接关闭影响
+    revalidate_job_ = std::make_unique<OffloadJob>(OffloadJob {
+        request, HttpResponse {}, Deadline::kNone, Deadline::CancelToken {}, nullptr, route, std::move(permit),
+        std::move(ticket), nullptr});
+}
+
+void HttpConnection::RunOffload(OffloadJob& job) {
+    try {
+        HttpRouter::instance().match(job.request, job.response);
+    } catch (const std::exception& e) {
+        LOG_ERROR("[HttpConnection] Revalidation handler failed, uri:{}, err:{}", job.request.uri(), e.what());
+        job.response.reset();
+        job.response.set_error_page(HttpStatus::INTERNAL_ERROR);
+        job.cache.complete(job.response);
+        return;
+    }
+    PostHandlersCheck(job.request, job.response, job.middleware);
+    job.cache.complete(job.response);
+}
+
+Coro::Task<> HttpConnection::RunCoroutine(OffloadJob& job) {
+    job.request.set_deadline(job.deadline, job.cancel);
+    try {
+        co_await (*job.coroutine)(job.request, job.response);
+    } catch (const Coro::DeadlineExceeded&) {
+        DropOffload(job);
+        co_return;
+    } catch (const std::exception& e) {
+        LOG_ERROR("[HttpConnection] Coroutine handler failed, uri:{}, err:{}", job.request.uri(), e.what());
+        job.response.reset();
+        job.response.set_error_page(HttpStatus::INTERNAL_ERROR);
+        job.cache.complete(job.response);
+        co_return;
+    }
+    PostHandlersCheck(job.request, job.response, job.middleware);
+    job.cache.complete(job.response);
+}
+
+void HttpConnection::DropOffload(OffloadJob& job) {
+    LOG_WARN("[HttpConnection] Offloaded request expired in queue, uri:{}", job.request.uri());
+    job.response.reset();
+    job.response.set_error_page(HttpStatus::SERVICE_UNAVAILABLE);
+    job.response.add_header("Retry-After", "1");
+    job.cache.complete(job.response); // 有可用旧响应时改用旧响应
+}
+
+void HttpConnection::CompleteOffload(OffloadJob& job) {
+    if (!offload_pending_) {
+        return;
+    }
+    offload_pending_ = false;
+    offload_cancel_ = {};
+    job.permit.release(static_cast<int>(job.response.status()) >= 500);
+    response_ = std::move(job.response);
+    PrepareResponse(job.request.method() == HttpRequest::Method::HEAD);
+}
+
+void HttpConnection::PrepareResponse(bool header_only) {
+    response_.set_header_only(header_only);
     response_.finalize(); // 准备 header + file
 
     // 根据 use_sendfile_ 选择发送方式
@@ -203,6 +403,7 @@ void HttpConnection::ProcessHttp() {
     } else {
         make_response_mmap();
     }
+    apply_large_file_policy();
 
     if (!response_.keep_alive()) {
         write_buffer_.set_close_on_done(true);
@@ -211,22 +412,86 @@ void HttpConnection::ProcessHttp() {
     EpollUtil::modFd(epoll_fd_, conn_fd_, EPOLLOUT, use_edge_trig_);
 }
 
+void HttpConnection::apply_large_file_policy() {
+    const auto& policy = large_file_policy_;
+    uint32_t rate = 0;
+
+    if (policy.min_bytes > 0 && response_.has_file() && response_.file_size() >= policy.min_bytes) {
+        write_buffer_.enable_sequential(policy.prefetch_window);
+
+        auto mime = MimeTypes::getMimeType(response_.file_path());
+        if (mime.starts_with("video/")) {
+            rate = policy.video_rate;
+        } else if (mime.starts_with("audio/")) {
+            rate = policy.audio_rate;
+        } else if (mime.starts_with("image/")) {
+            rate = policy.image_rate;
+        } else {
+            rate = policy.default_rate;
+        }
+    }
+
+    // keep-alive 连接上的下一个小响应需要恢复不限速
+    if (rate != pacing_rate_) {
+        unsigned int value = rate > 0 ? rate : ~0U;
+        if (setsockopt(conn_fd_, SOL_SOCKET, SO_MAX_PACING_RATE, &value, sizeof(value)) < 0) {
+            LOG_DEBUG("Conn fd:{} set SO_MAX_PACING_RATE failed: {}", conn_fd_, strerror(errno));
+        } else {
+            pacing_rate_ = rate;
+        }
+    }
+}
+
 void HttpConnection::make_response_mmap() {
+    if (response_.has_external_body()) {
+        auto body = response_.external_body();
+        write_buffer_.set_response_with_body(
+            response_.response_data(),
+            response_.response_length(),
+            body.data(),
+            body.size()
+        );
+        return;
+    }
+    if (response_.is_multipart()) {
+        write_buffer_.set_response_with_mmap(
+            response_.response_data(),
+            response_.response_length(),
+            response_.file_path(),
+            response_.file_segments(),
+            response_.multipart_trailer(),
+            response_.release_file_fd()
+        );
+        return;
+    }
     write_buffer_.set_response_with_mmap(
         response_.response_data(), 
         response_.response_length(), 
         response_.file_path(),
         response_.file_start(),
-        response_.file_size()
+        response_.file_size(),
+        response_.release_file_fd()
     );
 }
 
 void HttpConnection::make_response_sendfile() {
+    if (response_.is_multipart()) {
+        write_buffer_.set_response_with_sendfile(
+            response_.response_data(),
+            response_.response_length(),
+            response_.file_path(),
+            response_.file_segments(),
+            response_.multipart_trailer(),
+            response_.release_file_fd()
+        );
+        return;
+    }
     write_buffer_.set_response_with_sendfile(
         response_.response_data(),
         response_.response_length(),
         response_.file_path(),
         response_.file_start(),
-        response_.file_size()
+        response_.file_size(),
+        response_.release_file_fd()
     );
 }
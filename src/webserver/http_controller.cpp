@@ -6,6 +6,12 @@
 #include "http_request.h"
 #include "http_response.h"
 #include "logger.h"
+#include "metrics.h"
+#include "mysql_async.h"
+#include "mysql_user_store.h"
+#include "password_hasher.h"
+#include "session_token.h"
+#include "static_file_controller.h"
 #include "user_service.h"
 #include <filesystem>
 #include <regex>
@@ -13,12 +19,33 @@
 #include <string_view>
 #include <unordered_map>
 
-#ifndef PROJECT_ROOT_DIR
-#define PROJECT_ROOT_DIR "."
-#endif
-
 namespace {
-    const char* const kDocRoot = PROJECT_ROOT_DIR "/root";
+    // 读取表单中的用户名与密码，缺少时设置 400 并返回 false
+    bool readCredentials(const HttpRequest& req, HttpResponse& resp, std::string& username, std::string& password) {
+        username = req.get_form_field("user");
+        password = req.get_form_field("password");
+        if (username.empty() || password.empty()) {
+            resp.set_status(HttpStatus::BAD_REQUEST);
+            resp.set_body("Username and password are required");
+            return false;
+        }
+        return true;
+    }
+
+    // 数据库不可用（熔断打开 / 取连接超时）或口令哈希线程池已满：快速返回 503，提示客户端稍后重试
+    void serviceUnavailable(HttpResponse& resp) {
+        resp.reset();
+        resp.set_error_page(HttpStatus::SERVICE_UNAVAILABLE);
+        resp.add_header("Retry-After", "1");
+    }
+
+    // 登录成功：签发会话 Cookie 并跳转欢迎页
+    void startSession(HttpResponse& resp, const std::string& username) {
+        resp.set_status(HttpStatus::FOUND);
+        resp.add_header("Location", "/welcome");
+        resp.add_header("Set-Cookie", SessionToken::Instance().setCookieValue(username));
+        resp.add_header("Cache-Control", "no-store");
+    }
 }
 
 namespace HttpController {
@@ -32,98 +59,264 @@ namespace HttpController {
     }
 
     void serveStaticFile(const HttpRequest& req, HttpResponse& resp) {
-        std::string filepath = std::string(kDocRoot) + req.uri();
-        LOG_INFO("[HttpController] Serving static file: {}", filepath);
-        resp.set_file(filepath);
+        // 统一走 StaticFileController：路径规范化 + openat2(RESOLVE_BENEATH)
+        StaticFileController::serveStaticFile(req, resp);
     }
 
-    // 处理注册请求
+    // 显示注册页面（GET/HEAD）
     void handleRegister(const HttpRequest& req, HttpResponse& resp) {
-        // 对于GET请求，显示注册页面
-        if (req.method() == HttpRequest::Method::GET) {
-            LOG_INFO("[HttpController] Showing Register page.");
-            resp.set_file(kDocRoot + std::string("/register.html"));
-            return;
-        }
-
-        auto username = req.get_form_field("user");
-        auto password = req.get_form_field("password");
+        LOG_INFO("[HttpController] Showing Register page.");
+        StaticFileController::serveFile(req, "/register.html", resp);
+    }
 
-        LOG_INFO("[HttpController] Handle register request, username: {}, password: {}", username, password);
+    // 显示登录页面（GET/HEAD）
+    void handleLogin(const HttpRequest& req, HttpResponse& resp) {
+        LOG_INFO("[HttpController] Showing login page.");
+        StaticFileController::serveFile(req, "/log.html", resp);
+    }
 
-        if (username.empty() || password.empty()) {
-            resp.set_status(HttpStatus::BAD_REQUEST);
-            resp.set_body("Username and password are required");
-            return;
+    Coro::Task<> handleRegisterCo(const HttpRequest& req, HttpResponse& resp) {
+        std::string username, password;
+        if (!readCredentials(req, resp, username, password)) {
+            co_return;
         }
 
-        if (UserService::Instance().userExists(username)) {
-            resp.set_file(kDocRoot + std::string("/registerError.html"));
-            return;
+        LOG_INFO("[HttpController] Handle register request, username: {}", username);
+
+        // 哈希在哈希线程池上计算；INSERT 不占用哈希线程（用户已存在时由唯一索引拒绝），reactor 只等待结果
+        auto& hasher = PasswordHasher::Instance();
+        std::string hashed;
+        try {
+            auto ticket = hasher.admit();
+            hashed = co_await Coro::offload(hasher.pool(), [&hasher, &password] { return hasher.hashNow(password); },
+                                            req.deadline(), req.cancel_token());
+        } catch (const HasherOverloaded& e) {
+            LOG_WARN("[HttpController] Register shed: {}", e.what());
+            serviceUnavailable(resp);
+            co_return;
         }
 
-        if (UserService::Instance().registerUser(username, password)) {
+        // 后端合并注册写入时挂起等待所在批次写完，不占用任何线程；否则在通用线程池上按请求截止时间写入（取连接 / 等待落盘）
+        auto& users = UserService::Instance();
+        UserStore::InsertResult inserted;
+        try {
+            if (users.batchesInserts()) {
+                inserted = co_await Coro::callback<UserStore::InsertResult>([&users, &username, &hashed](auto done) {
+                    users.insertUserAsync(username, hashed, std::move(done));
+                });
+            } else {
+                inserted = co_await Coro::offload([&users, &username, &hashed] {
+                    return users.insertUser(username, hashed);
+                }, req.deadline(), req.cancel_token());
+            }
+        } catch (const DatabaseUnavailable& e) {
+            LOG_WARN("[HttpController] Register rejected: {}", e.what());
+            serviceUnavailable(resp);
+            co_return;
+        }
+        if (inserted == UserStore::InsertResult::Failed) {
+            serviceUnavailable(resp);
+            co_return;
+        }
+        if (inserted == UserStore::InsertResult::Created) {
             // 注册成功后重定向到登录页面
             resp.set_status(HttpStatus::FOUND);
             resp.add_header("Location", "/login");
         } else {
-            resp.set_file(kDocRoot + std::string("/registerError.html"));
+            StaticFileController::serveFile(req, "/registerError.html", resp);
+        }
+    }
+
+    Coro::Task<> handleLoginCo(const HttpRequest& req, HttpResponse& resp) {
+        std::string username, password;
+        if (!readCredentials(req, resp, username, password)) {
+            co_return;
+        }
+
+        LOG_INFO("[HttpController] Handle login request, username: {}", username);
+
+        // 先查凭据缓存；未命中时在通用线程池上按请求截止时间查存储，校验哈希再交给哈希线程池
+        auto& users = UserService::Instance();
+        std::string stored;
+        auto cached = users.cachedCredential(username, stored);
+        bool found = cached == CredentialCache::Lookup::Found;
+        if (cached == CredentialCache::Lookup::Miss) {
+            UserStore::FindResult result;
+            try {
+                result = co_await Coro::offload([&users, &username, &stored] {
+                    return users.findCredential(username, stored);
+                }, req.deadline(), req.cancel_token());
+            } catch (const DatabaseUnavailable& e) {
+                LOG_WARN("[HttpController] Login rejected: {}", e.what());
+                serviceUnavailable(resp);
+                co_return;
+            }
+            if (result == UserStore::FindResult::Error) {
+                serviceUnavailable(resp);
+                co_return;
+            }
+            found = result == UserStore::FindResult::Found;
         }
 
+        bool verified = false;
+        if (found) {
+            auto& hasher = PasswordHasher::Instance();
+            try {
+                auto ticket = hasher.admit();
+                verified = co_await Coro::offload(hasher.pool(), [&hasher, &password, &stored] {
+                    return hasher.verifyNow(password, stored);
+                }, req.deadline(), req.cancel_token());
+            } catch (const HasherOverloaded& e) {
+                LOG_WARN("[HttpController] Login shed: {}", e.what());
+                serviceUnavailable(resp);
+                co_return;
+            }
+        }
+        if (verified) {
+            // 登录成功后重定向到欢迎页面
+            startSession(resp, username);
+        } else {
+            StaticFileController::serveFile(req, "/logError.html", resp);
+        }
     }
 
-    // 处理登录请求
-    void handleLogin(const HttpRequest& req, HttpResponse& resp) {
-        // 对于GET请求，显示登录页面
-        // noinspection
-        if (req.method() == HttpRequest::Method::GET) {
-            LOG_INFO("[HttpController] Showing login page.");
-            resp.set_file(kDocRoot + std::string("/log.html"));
-            return;
+    Coro::Task<> handleRegisterAsync(const HttpRequest& req, HttpResponse& resp) {
+        std::string username, password;
+        if (!readCredentials(req, resp, username, password)) {
+            co_return;
         }
 
-        auto username = req.get_form_field("user");
-        auto password = req.get_form_field("password");
+        LOG_INFO("[HttpController] Handle async register request, username: {}", username);
 
-        LOG_INFO("[HttpController] Handle login request, username: {}, password: {}", username, password);
+        // 先在哈希线程池上算好哈希，再取连接，不在哈希期间占用连接
+        auto& hasher = PasswordHasher::Instance();
+        std::string hashed;
+        try {
+            auto ticket = hasher.admit();
+            hashed = co_await Coro::offload(hasher.pool(), [&hasher, &password] { return hasher.hashNow(password); },
+                                            req.deadline(), req.cancel_token());
+        } catch (const HasherOverloaded& e) {
+            LOG_WARN("[HttpController] Register shed: {}", e.what());
+            serviceUnavailable(resp);
+            co_return;
+        }
 
-        if (username.empty() || password.empty()) {
-            resp.set_status(HttpStatus::BAD_REQUEST);
-            resp.set_body("Username and password are required");
-            return;
+        auto conn = co_await MySQLAsync::acquire();
+        if (!conn) {
+            serviceUnavailable(resp);
+            co_return;
+        }
+        bool registered = co_await MySQLAsync::exec(conn, MySQLUserStore::insertSql(*conn.get(), username, hashed));
+        // 只有唯一索引冲突说明用户已存在，其余失败（超时、断连、SQL 错误）按数据库不可用处理
+        if (!registered && conn.errorCode() != MySQLUserStore::kDuplicateEntry) {
+            LOG_WARN("[HttpController] Async register failed, mysql error: {}", conn.errorCode());
+            serviceUnavailable(resp);
+            co_return;
+        }
+        if (registered) {
+            UserService::Instance().onRegistered(username);
         }
 
-        if (UserService::Instance().verifyUser(username, password)) {
-            // 登录成功后重定向到欢迎页面
+        if (registered) {
             resp.set_status(HttpStatus::FOUND);
-            resp.add_header("Location", "/welcome");
+            resp.add_header("Location", "/login");
         } else {
-            resp.set_file(kDocRoot + std::string("/logError.html"));
+            StaticFileController::serveFile(req, "/registerError.html", resp);
         }
     }
 
+    Coro::Task<> handleLoginAsync(const HttpRequest& req, HttpResponse& resp) {
+        std::string username, password;
+        if (!readCredentials(req, resp, username, password)) {
+            co_return;
+        }
+
+        LOG_INFO("[HttpController] Handle async login request, username: {}", username);
+
+        auto& users = UserService::Instance();
+        std::string stored;
+        auto cached = users.cachedCredential(username, stored);
+        bool found = cached == CredentialCache::Lookup::Found;
+        if (cached == CredentialCache::Lookup::Miss) {
+            auto conn = co_await MySQLAsync::acquire();
+            if (!conn) {
+                serviceUnavailable(resp);
+                co_return;
+            }
+            // 查询失败时结果未知：返回 503，不当作用户不存在，也不写否定缓存
+            if (!co_await MySQLAsync::query(conn, MySQLUserStore::verifySql(*conn.get(), username))) {
+                LOG_WARN("[HttpController] Async login lookup failed, mysql error: {}", conn.errorCode());
+                serviceUnavailable(resp);
+                co_return;
+            }
+            if (MYSQL_ROW row = conn->fetchRow()) {
+                stored = row[0] ? row[0] : "";
+                users.rememberCredential(username, &stored);
+                found = true;
+            } else {
+                users.rememberCredential(username, nullptr);
+            }
+        }
+
+        // 校验哈希同样在哈希线程池上进行，连接已在此前归还
+        bool verified = false;
+        if (found) {
+            auto& hasher = PasswordHasher::Instance();
+            try {
+                auto ticket = hasher.admit();
+                verified = co_await Coro::offload(hasher.pool(), [&hasher, &password, &stored] {
+                    return hasher.verifyNow(password, stored);
+                }, req.deadline(), req.cancel_token());
+            } catch (const HasherOverloaded& e) {
+                LOG_WARN("[HttpController] Login shed: {}", e.what());
+                serviceUnavailable(resp);
+                co_return;
+            }
+        }
+
+        if (verified) {
+            startSession(resp, username);
+        } else {
+            StaticFileController::serveFile(req, "/logError.html", resp);
+        }
+    }
+
+    // 登出：令牌无状态，只能让浏览器删除 Cookie（已泄露的令牌在过期或轮换掉签发密钥前仍然有效）
+    void handleLogout(const HttpRequest& req, HttpResponse& resp) {
+        resp.set_status(HttpStatus::FOUND);
+        resp.add_header("Location", "/login");
+        resp.add_header("Set-Cookie", SessionToken::Instance().clearCookieValue());
+        resp.add_header("Cache-Control", "no-store");
+    }
+
     // 主页（判断页面）
     void showJudgePage(const HttpRequest& req, HttpResponse& resp) {
         LOG_DEBUG("[HttpController] Showing judge page.");
-        resp.set_file(kDocRoot + std::string("/judge.html"));
+        StaticFileController::serveFile(req, "/judge.html", resp);
     }
     
     // 首页欢迎页面
     void showWelcomePage(const HttpRequest& req, HttpResponse& resp) {
         LOG_INFO("[HttpController] Showing welcome page.");
-        resp.set_file(kDocRoot + std::string("/welcome.html"));
+        StaticFileController::serveFile(req, "/welcome.html", resp);
     }
     
     // 展示图片页面
     void showPicturePage(const HttpRequest& req, HttpResponse& resp) {
         LOG_INFO("[HttpController] Showing picture page.");
-        resp.set_file(kDocRoot + std::string("/picture.html"));
+        StaticFileController::serveFile(req, "/picture.html", resp);
     }
 
     // 展示视频页面
     void showVideoPage(const HttpRequest& req, HttpResponse& resp) {
         LOG_INFO("[HttpController] Showing video page.");
-        resp.set_file(kDocRoot + std::string("/video.html"));
+        StaticFileController::serveFile(req, "/video.html", resp);
     }
 
+    // 进程内指标
+    void showMetrics(const HttpRequest& req, HttpResponse& resp) {
+        resp.add_header("Content-Type", "text/plain");
+        resp.add_header("Cache-Control", "no-store");
+        resp.set_body(Metrics::Registry::Instance().dump());
+    }
 }
\ No newline at end of file
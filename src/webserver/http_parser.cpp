@@ -5,6 +5,7 @@
 // http_request_parser.cpp
 #include "http_parser.h"
 #include "http_request.h" // 假设已有 HttpRequest 定义
+#include "path_util.h"
 #include <sstream>
 #include <iomanip>
 
@@ -162,6 +163,9 @@ ParseResult HttpRequestParser::parse_request_line(std::string_view line, HttpReq
     } else if (iequals(method, "POST")) {
         req.set_method(HttpRequest::Method::POST);
         req.set_cgi(true); // 或者通过配置决定
+    } else if (iequals(method, "HEAD")) {
+        // HEAD 按 GET 路由，响应时只发送头部
+        req.set_method(HttpRequest::Method::HEAD);
     } else {
         return ParseResult::BAD_REQUEST;
     }
@@ -196,14 +200,19 @@ ParseResult HttpRequestParser::parse_request_line(std::string_view line, HttpReq
         return ParseResult::BAD_REQUEST;
     }
 
-    // 设置处理后的URI（不包含查询参数）
-    req.set_uri(std::string(path));
+    // 设置处理后的URI（不包含查询参数）：解码并规范化一次，路由、中间件与静态文件都使用同一路径，
+    // /static/../welcome.html 之类的写法不能绕开挂在 /welcome.html 上的中间件；.. 越过根目录直接拒绝
+    std::string normalized(path);
+    if (!PathUtil::normalize(normalized)) {
+        return ParseResult::FORBIDDEN;
+    }
+    req.set_uri(std::move(normalized));
 
     // 如果有查询参数，可以将其添加到请求中（可选）
     if (!query.empty()) {
         req.add_header("Query-String", std::string(query));
         // 对于GET请求，也可以解析查询参数为表单字段
-        if (req.method() == HttpRequest::Method::GET) {
+        if (req.method() != HttpRequest::Method::POST) {
             parse_form_data(std::string(query), req);
         }
     }
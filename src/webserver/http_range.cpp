@@ -0,0 +1,195 @@
+#include "http_range.h"
+
+#include <cstdint>
+
+namespace {
+    bool isOws(char c) { return c == ' ' || c == '\t'; }
+
+    void skipOws(std::string_view& s) {
+        size_t i = 0;
+        while (i < s.size() && isOws(s[i])) ++i;
+        s.remove_prefix(i);
+    }
+
+    std::string_view trimOws(std::string_view s) {
+        skipOws(s);
+        while (!s.empty() && isOws(s.back())) s.remove_suffix(1);
+        return s;
+    }
+
+    // 解析十进制数字并消费输入，超大值饱和到 SIZE_MAX（必然不可满足或被裁剪）
+    bool parseNumber(std::string_view& s, size_t& value) {
+        size_t i = 0;
+        value = 0;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+            size_t digit = static_cast<size_t>(s[i] - '0');
+            value = value > (SIZE_MAX - digit) / 10 ? SIZE_MAX : value * 10 + digit;
+            ++i;
+        }
+        s.remove_prefix(i);
+        return i > 0;
+    }
+
+    // 存在重叠/相邻区间时排序合并，防止 "bytes=0-,0-,0-..." 这类放大请求
+    void coalesce(HttpRange::RangeSet& set) {
+        bool overlapping = false;
+        for (size_t i = 0; i < set.count && !overlapping; ++i) {
+            for (size_t j = i + 1; j < set.count; ++j) {
+                const auto& a = set.ranges[i];
+                const auto& b = set.ranges[j];
+                if (a.start <= b.start + b.length && b.start <= a.start + a.length) {
+                    overlapping = true;
+                    break;
+                }
+            }
+        }
+        if (!overlapping) {
+            return; // 保持客户端请求的顺序
+        }
+
+        // 插入排序（最多 kMaxRanges 个元素）
+        for (size_t i = 1; i < set.count; ++i) {
+            auto cur = set.ranges[i];
+            size_t j = i;
+            while (j > 0 && set.ranges[j - 1].start > cur.start) {
+                set.ranges[j] = set.ranges[j - 1];
+                --j;
+            }
+            set.ranges[j] = cur;
+        }
+
+        size_t merged = 0;
+        for (size_t i = 1; i < set.count; ++i) {
+            auto& last = set.ranges[merged];
+            const auto& cur = set.ranges[i];
+            size_t last_end = last.start + last.length;
+            if (cur.start <= last_end) {
+                size_t cur_end = cur.start + cur.length;
+                if (cur_end > last_end) {
+                    last.length = cur_end - last.start;
+                }
+            } else {
+                set.ranges[++merged] = cur;
+            }
+        }
+        set.count = merged + 1;
+    }
+}
+
+namespace HttpRange {
+    auto parse(std::string_view header, size_t file_size, RangeSet& out) -> Result {
+        out.count = 0;
+
+        // bytes-unit 大小写不敏感
+        constexpr std::string_view kUnit = "bytes";
+        skipOws(header);
+        if (header.size() < kUnit.size()) {
+            return Result::IGNORE;
+        }
+        for (size_t i = 0; i < kUnit.size(); ++i) {
+            if ((header[i] | 0x20) != kUnit[i]) {
+                return Result::IGNORE;
+            }
+        }
+        header.remove_prefix(kUnit.size());
+        if (header.empty() || header.front() != '=') {
+            return Result::IGNORE;
+        }
+        header.remove_prefix(1);
+
+        // byte-range-set = 1#( byte-range-spec / suffix-byte-range-spec )
+        bool has_spec = false;
+        while (true) {
+            skipOws(header);
+            if (header.empty()) {
+                break;
+            }
+            if (header.front() == ',') { // 允许空列表元素
+                header.remove_prefix(1);
+                continue;
+            }
+
+            size_t first = 0;
+            size_t last = 0;
+            bool suffix = false;
+            bool has_last = false;
+
+            if (header.front() == '-') {
+                // suffix-byte-range-spec = "-" suffix-length
+                header.remove_prefix(1);
+                if (!parseNumber(header, last)) {
+                    return Result::IGNORE;
+                }
+                suffix = true;
+            } else {
+                // byte-range-spec = first-byte-pos "-" [ last-byte-pos ]
+                if (!parseNumber(header, first) || header.empty() || header.front() != '-') {
+                    return Result::IGNORE;
+                }
+                header.remove_prefix(1);
+                has_last = parseNumber(header, last);
+                if (has_last && last < first) {
+                    return Result::IGNORE;
+                }
+            }
+
+            skipOws(header);
+            if (!header.empty()) {
+                if (header.front() != ',') {
+                    return Result::IGNORE;
+                }
+                header.remove_prefix(1);
+            }
+            has_spec = true;
+
+            // 按文件大小裁剪；不可满足的区间直接丢弃
+            ByteRange range {};
+            if (suffix) {
+                if (last == 0 || file_size == 0) {
+                    continue;
+                }
+                range.length = last < file_size ? last : file_size;
+                range.start = file_size - range.length;
+            } else {
+                if (first >= file_size) {
+                    continue;
+                }
+                size_t end = (has_last && last < file_size - 1) ? last : file_size - 1;
+                range.start = first;
+                range.length = end - first + 1;
+            }
+
+            if (out.count == kMaxRanges) {
+                out.count = 0;
+                return Result::IGNORE;
+            }
+            out.ranges[out.count++] = range;
+        }
+
+        if (!has_spec) {
+            return Result::IGNORE;
+        }
+        if (out.count == 0) {
+            return Result::NOT_SATISFIABLE;
+        }
+
+        coalesce(out);
+        return Result::OK;
+    }
+
+    bool ifRangeMatches(std::string_view if_range, std::string_view etag, std::string_view last_modified) {
+        if_range = trimOws(if_range);
+        if (if_range.empty()) {
+            return false;
+        }
+
+        // 弱实体标签永远不满足 If-Range 的强比较
+        if (if_range.starts_with("W/")) {
+            return false;
+        }
+        if (if_range.front() == '"') {
+            return !etag.empty() && !etag.starts_with("W/") && if_range == etag;
+        }
+        return !last_modified.empty() && if_range == last_modified;
+    }
+}
@@ -7,8 +7,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cstdio>
 #include <cstring>
 #include <sys/mman.h>   // mmap, munmap, PROT_READ, MAP_PRIVATE
+#include <random>
 
 // MIME type 推断辅助函数
 static std::string guess_content_type(const std::string& path) {
@@ -37,7 +39,9 @@ void HttpResponse::set_status(HttpStatus code, std::string reason) {
         case HttpStatus::FORBIDDEN:                         reason_phrase_ = "Forbidden"; break;
         case HttpStatus::NOT_FOUND:                         reason_phrase_ = "Not Found"; break;
         case HttpStatus::REQUESTED_RANGE_NOT_SATISFIABLE:   reason_phrase_ = "Requested Range Not Satisfiable"; break;
+        case HttpStatus::TOO_MANY_REQUESTS:                 reason_phrase_ = "Too Many Requests"; break;
         case HttpStatus::INTERNAL_ERROR:                    reason_phrase_ = "Internal Server Error"; break;
+        case HttpStatus::SERVICE_UNAVAILABLE:               reason_phrase_ = "Service Unavailable"; break;
         default:                                            reason_phrase_ = "Unknown";
     }
 }
@@ -49,9 +53,30 @@ void HttpResponse::add_header(std::string key, std::string value) {
 
 void HttpResponse::set_body(std::string body) {
     body_ = std::move(body);
+    body_owner_.reset();
+    external_body_ = {};
+    raw_headers_ = {};
+    raw_headers_owner_.reset();
     set_content_length(body_.size());
 }
 
+void HttpResponse::set_shared_body(std::shared_ptr<const std::string> body) {
+    std::string_view view = body ? std::string_view(*body) : std::string_view {};
+    set_external_body(view, std::move(body));
+}
+
+void HttpResponse::set_external_body(std::string_view body, std::shared_ptr<const void> owner) {
+    body_.clear();
+    external_body_ = owner ? body : std::string_view {};
+    body_owner_ = std::move(owner);
+    set_content_length(external_body_.size());
+}
+
+void HttpResponse::set_raw_headers(std::string_view headers, std::shared_ptr<const void> owner) {
+    raw_headers_ = headers;
+    raw_headers_owner_ = std::move(owner);
+}
+
 void HttpResponse::set_content_length(size_t len) {
     headers_["Content-Length"] = std::to_string(len);
 }
@@ -59,6 +84,7 @@ void HttpResponse::set_content_length(size_t len) {
 void HttpResponse::set_file(std::string filepath) {
     file_path_ = std::move(filepath);
     file_start_ = 0;
+    file_fd_.reset();
     
     // 获取文件大小
     struct stat st{};
@@ -69,12 +95,78 @@ void HttpResponse::set_file(std::string filepath) {
     }
 }
 
+void HttpResponse::set_opened_file(std::string filepath, UniqueFd fd, size_t size) {
+    file_path_ = std::move(filepath);
+    file_start_ = 0;
+    file_size_ = size;
+    file_fd_ = std::move(fd);
+}
+
 void HttpResponse::set_file_with_range(std::string filepath, size_t start, size_t length) {
     file_path_ = std::move(filepath);
     file_start_ = start;
     file_size_ = length;
 }
 
+void HttpResponse::clear_file() {
+    file_fd_.reset();
+    file_path_.clear();
+    file_size_ = 0;
+    file_start_ = 0;
+    file_segments_.clear();
+}
+
+void HttpResponse::set_file_with_ranges(std::string filepath, std::string_view content_type, size_t file_total,
+                                        const HttpRange::RangeSet& ranges) {
+    // 每个线程独立的随机源生成分隔符，避免与文件内容冲突
+    thread_local std::mt19937_64 rng {std::random_device{}()};
+    char boundary[17];
+    std::snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(rng()));
+
+    file_path_ = std::move(filepath);
+    file_start_ = 0;
+    file_segments_.clear();
+    multipart_buf_.clear();
+
+    // 先写完整个缓冲区再生成 string_view，避免扩容导致悬垂
+    std::string total = std::to_string(file_total);
+    std::vector<size_t> header_ends;
+    header_ends.reserve(ranges.count);
+    for (const auto& range : ranges) {
+        multipart_buf_ += "\r\n--";
+        multipart_buf_ += boundary;
+        multipart_buf_ += "\r\nContent-Type: ";
+        multipart_buf_ += content_type;
+        multipart_buf_ += "\r\nContent-Range: bytes ";
+        multipart_buf_ += std::to_string(range.start);
+        multipart_buf_ += '-';
+        multipart_buf_ += std::to_string(range.start + range.length - 1);
+        multipart_buf_ += '/';
+        multipart_buf_ += total;
+        multipart_buf_ += "\r\n\r\n";
+        header_ends.push_back(multipart_buf_.size());
+    }
+    size_t trailer_begin = multipart_buf_.size();
+    multipart_buf_ += "\r\n--";
+    multipart_buf_ += boundary;
+    multipart_buf_ += "--\r\n";
+
+    // Content-Length = 所有分段头 + 文件段 + 结尾分隔符
+    std::string_view buf = multipart_buf_;
+    size_t body_length = buf.size();
+    size_t header_begin = 0;
+    for (size_t i = 0; i < ranges.count; ++i) {
+        const auto& range = ranges.ranges[i];
+        file_segments_.push_back({buf.substr(header_begin, header_ends[i] - header_begin), range.start, range.length});
+        body_length += range.length;
+        header_begin = header_ends[i];
+    }
+    multipart_trailer_ = buf.substr(trailer_begin);
+    file_size_ = body_length;
+
+    add_header("Content-Type", std::string("multipart/byteranges; boundary=") + boundary);
+}
+
 void HttpResponse::set_keep_alive(bool enable) { close_connection_ = !enable; }
 
 bool HttpResponse::keep_alive() const { return !close_connection_; }
@@ -96,14 +188,22 @@ bool HttpResponse::is_success() const {
 }
 
 bool HttpResponse::is_handled() const {
-    return handled_ || !body_.empty() || !file_path_.empty() || is_error();
+    return handled_ || !body_.empty() || body_owner_ || !file_path_.empty() || is_error();
 }
 
 bool HttpResponse::has_header(const std::string& key) const {
     return headers_.find(key) != headers_.end();
 }
 
+const std::string* HttpResponse::header(const std::string& key) const {
+    auto it = headers_.find(key);
+    return it == headers_.end() ? nullptr : &it->second;
+}
+
 void HttpResponse::build_response() {
+    if (reason_phrase_.empty()) {
+        set_status(status_code_);
+    }
     std::string status_line = "HTTP/1.1 " + std::to_string(static_cast<int>(status_code_)) +
                               " " + reason_phrase_ + "\r\n";
 
@@ -111,8 +211,8 @@ void HttpResponse::build_response() {
     resp_buf_.reserve(512);
     resp_buf_.assign(status_line.begin(), status_line.end());
 
-    // 默认 Content-Length
-    if (headers_.find("Content-Length") == headers_.end()) {
+    // 默认 Content-Length（304 不带响应体，也不声明长度）
+    if (status_code_ != HttpStatus::NOT_MODIFIED && headers_.find("Content-Length") == headers_.end()) {
         size_t len = has_file() ? file_size_ : body_.size();
         headers_["Content-Length"] = std::to_string(len);
     }
@@ -128,18 +228,8 @@ void HttpResponse::build_response() {
     }
 
     // 只有在没有设置 Content-Type 时才设置默认值
-    if (headers_.find("Content-Type") == headers_.end()) {
-        if (has_file()) {
-            headers_["Content-Type"] = guess_content_type(file_path_);
-        } else {
-            // 检查body是否包含HTML内容
-            if (!body_.empty() && (body_.find("<!DOCTYPE html") != std::string::npos ||
-                                   body_.find("<html") != std::string::npos)) {
-                headers_["Content-Type"] = "text/html";
-           } else {
-               headers_["Content-Type"] = "text/plain";
-           }
-        }
+    if (headers_.find("Content-Type") == headers_.end() && raw_headers_.empty()) {
+        headers_["Content-Type"] = default_content_type();
     }
 
     for (const auto& [k, v] : headers_) {
@@ -147,18 +237,50 @@ void HttpResponse::build_response() {
         resp_buf_.insert(resp_buf_.end(), line.begin(), line.end());
     }
 
+    resp_buf_.insert(resp_buf_.end(), raw_headers_.begin(), raw_headers_.end());
+
     // 分隔空行
     resp_buf_.insert(resp_buf_.end(), {'\r', '\n'}); // \r\n\r\n
 
     // 如果没有文件，则直接拼上 body
-    if (!has_file() && !body_.empty()) {
+    if (!has_file() && !body_.empty() && !header_only_) {
         resp_buf_.insert(resp_buf_.end(), body_.begin(), body_.end());
     }
 }
 
+std::string HttpResponse::default_content_type() const {
+    if (has_file()) {
+        return guess_content_type(file_path_);
+    }
+    // 检查body是否包含HTML内容
+    if (!body_.empty() && (body_.find("<!DOCTYPE html") != std::string::npos ||
+                           body_.find("<html") != std::string::npos)) {
+        return "text/html";
+    }
+    return "text/plain";
+}
+
+bool HttpResponse::export_headers(std::string& headers) const {
+    if (has_file() || is_multipart()) {
+        return false;
+    }
+    headers.clear();
+    for (const auto& [k, v] : headers_) {
+        if (k == "Content-Length" || k == "Connection" || k == "Server") {
+            continue;
+        }
+        headers.append(k).append(": ").append(v).append("\r\n");
+    }
+    headers.append(raw_headers_);
+    if (headers_.find("Content-Type") == headers_.end() && raw_headers_.empty()) {
+        headers.append("Content-Type: ").append(default_content_type()).append("\r\n");
+    }
+    return true;
+}
+
 void HttpResponse::finalize() {
-    // 验证文件是否存在（只验证，不打开）
-    if (!file_path_.empty()) {
+    // 验证文件是否存在（只验证，不打开）；已打开的文件无需再验证
+    if (!file_path_.empty() && !file_fd_) {
         struct stat st{};
         if (stat(file_path_.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
             // 文件不存在或不可访问 → 返回错误页
@@ -167,10 +289,18 @@ void HttpResponse::finalize() {
             add_header("Content-Type", "text/html");
             file_path_.clear();
             file_size_ = 0;
+            file_segments_.clear();
         }
     }
 
     build_response();
+
+    // HEAD：Content-Length 已按完整响应计算，丢弃文件与外部响应体
+    if (header_only_) {
+        clear_file();
+        body_owner_.reset();
+        external_body_ = {};
+    }
 }
 
 // 缓存构造好的 header
@@ -180,15 +310,24 @@ void HttpResponse::reset() {
     status_code_ = HttpStatus::OK;
     reason_phrase_.clear();
     body_.clear();
+    body_owner_.reset();
+    external_body_ = {};
+    raw_headers_ = {};
+    raw_headers_owner_.reset();
+    file_fd_.reset();
     file_path_.clear();
     file_size_ = 0;
     file_start_ = 0;
+    file_segments_.clear();
+    multipart_buf_.clear();
+    multipart_trailer_ = {};
     resp_buf_.clear();
 
     headers_.clear();
 
     handled_ = false;
     close_connection_ = false;
+    header_only_ = false;
 }
 
 void HttpResponse::set_error_page(HttpStatus code) {
@@ -228,6 +367,14 @@ void HttpResponse::set_error_page(HttpStatus code) {
                 </body></html>
             )";
             break;
+        case HttpStatus::SERVICE_UNAVAILABLE:
+            body = R"(
+                <html><body>
+                <h1>503 Service Unavailable</h1>
+                <p>The server is temporarily overloaded, please retry later.</p>
+                </body></html>
+            )";
+            break;
         default:
             body = "<html><body><h1>Error</h1></body></html>";
     }
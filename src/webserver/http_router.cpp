@@ -37,67 +37,136 @@ void HttpRouter::post(std::string path, HttpHandlerFunc handler) {
     }
 }
 
-bool HttpRouter::match(const HttpRequest &req, HttpResponse &resp) const {
-    const std::string &uri = req.uri();
+void HttpRouter::get_co(std::string path, HttpCoroHandler handler) {
+    routes_[std::move(path)].get_coro = std::move(handler);
+}
 
+void HttpRouter::post_co(std::string path, HttpCoroHandler handler) {
+    routes_[std::move(path)].post_coro = std::move(handler);
+}
+
+const std::pair<const std::string, HttpRouter::Route> *HttpRouter::find_route(std::string_view uri) const {
     // 首先尝试精确匹配
-    auto it = routes_.find(uri);
+    auto it = routes_.find(std::string(uri));
     if (it != routes_.end()) {
-        bool is_post = req.method() == HttpRequest::Method::POST;
-        if (is_post && it->second.post_handler) {
-            it->second.post_handler(req, resp);
-            return true;
-        } else if (!is_post && it->second.get_handler) {
-            it->second.get_handler(req, resp);
-            return true;
-        } else {
-            resp.set_status(HttpStatus::METHOD_NOT_ALLOWED);
-            resp.set_body("Method not allowed");
-            return true;
-        }
+        return &*it;
     }
 
     // 尝试通配符匹配
     for (const auto &route: routes_) {
         // 检查是否是通配符路由
         if (route.first.ends_with("*")) {
-            std::string prefix = route.first.substr(0, route.first.length() - 1);
+            std::string_view prefix(route.first.data(), route.first.length() - 1);
             if (uri.starts_with(prefix)) {
-                bool is_post = req.method() == HttpRequest::Method::POST;
-                if (is_post && route.second.post_handler) {
-                    route.second.post_handler(req, resp);
-                    return true;
-                } else if (!is_post && route.second.get_handler) {
-                    route.second.get_handler(req, resp);
-                    return true;
-                } else {
-                    resp.set_status(HttpStatus::METHOD_NOT_ALLOWED);
-                    resp.set_body("Method not allowed");
-                    return true;
-                }
+                return &route;
             }
         }
         // 检查是否是文件扩展名匹配（如 *.jpg）
         else if (route.first.starts_with("*.")) {
-            std::string extension = route.first.substr(1); // 包含点号
+            std::string_view extension = std::string_view(route.first).substr(1); // 包含点号
             if (uri.ends_with(extension)) {
-                bool is_post = req.method() == HttpRequest::Method::POST;
-                if (is_post && route.second.post_handler) {
-                    route.second.post_handler(req, resp);
-                    return true;
-                } else if (!is_post && route.second.get_handler) {
-                    route.second.get_handler(req, resp);
-                    return true;
-                } else {
-                    resp.set_status(HttpStatus::METHOD_NOT_ALLOWED);
-                    resp.set_body("Method not allowed");
-                    return true;
-                }
+                return &route;
             }
         }
     }
+    return nullptr;
+}
 
-    return false;
+bool HttpRouter::match(const HttpRequest &req, HttpResponse &resp) const {
+    const auto *route = find_route(req.uri());
+    if (!route) {
+        return false;
+    }
+
+    bool is_post = req.method() == HttpRequest::Method::POST;
+    if (is_post && route->second.post_handler) {
+        route->second.post_handler(req, resp);
+    } else if (!is_post && route->second.get_handler) {
+        route->second.get_handler(req, resp);
+    } else {
+        resp.set_status(HttpStatus::METHOD_NOT_ALLOWED);
+        resp.set_body("Method not allowed");
+    }
+    return true;
+}
+
+const HttpCoroHandler *HttpRouter::coroutine(const HttpRequest &req) const {
+    auto it = routes_.find(req.uri());
+    if (it == routes_.end()) {
+        return nullptr;
+    }
+    const auto &handler = req.method() == HttpRequest::Method::POST ? it->second.post_coro : it->second.get_coro;
+    return handler ? &handler : nullptr;
+}
+
+void HttpRouter::set_bulkhead(const std::string &path, std::shared_ptr<ConcurrencyLimiter> limiter) {
+    options_[path].bulkhead = std::move(limiter);
+}
+
+ConcurrencyLimiter *HttpRouter::bulkhead(const HttpRequest &req) const {
+    auto options = options_.find(req.uri());
+    if (options == options_.end() || !options->second.bulkhead) {
+        return nullptr;
+    }
+    auto it = routes_.find(req.uri());
+    if (it == routes_.end()) {
+        return nullptr;
+    }
+    bool is_post = req.method() == HttpRequest::Method::POST;
+    bool slow = is_post ? static_cast<bool>(it->second.post_coro) : static_cast<bool>(it->second.get_coro);
+    return slow ? options->second.bulkhead.get() : nullptr;
+}
+
+void HttpRouter::set_micro_cache(const std::string &path, const MicroCache::Policy &policy) {
+    options_[path].cache = std::make_shared<const MicroCache::Policy>(policy);
+}
+
+const MicroCache::Policy *HttpRouter::micro_cache(const HttpRequest &req) const {
+    if (req.method() == HttpRequest::Method::POST) {
+        return nullptr;
+    }
+    auto options = options_.find(req.uri());
+    if (options == options_.end() || !options->second.cache) {
+        return nullptr;
+    }
+    auto it = routes_.find(req.uri());
+    if (it == routes_.end() || !it->second.get_handler || it->second.get_coro) {
+        return nullptr;
+    }
+    return options->second.cache.get();
+}
+
+RouteMiddleware &HttpRouter::route_middleware(const std::string &path, HttpRequest::Method method) {
+    if (path.ends_with("*") || path.starts_with("*.")) {
+        pattern_middleware_ = true;
+    }
+    auto &options = options_[path];
+    return method == HttpRequest::Method::POST ? options.post_middleware : options.get_middleware;
+}
+
+const RouteMiddleware *HttpRouter::middleware(const HttpRequest &req) const {
+    bool is_post = req.method() == HttpRequest::Method::POST;
+    auto pick = [is_post](const RouteOptions &options) -> const RouteMiddleware * {
+        const auto &middleware = is_post ? options.post_middleware : options.get_middleware;
+        return middleware.empty() ? nullptr : &middleware;
+    };
+
+    // 先按请求路径精确查找（可以只保护通配符路由下的某个文件），再按实际命中的路由查找
+    auto it = options_.find(req.uri());
+    if (it != options_.end()) {
+        if (const auto *middleware = pick(it->second)) {
+            return middleware;
+        }
+    }
+    if (!pattern_middleware_) {
+        return nullptr; // 中间件都挂在精确路径上：命中的通配符路由不可能有中间件，省去遍历
+    }
+    const auto *route = find_route(req.uri());
+    if (!route || route->first == req.uri()) {
+        return nullptr;
+    }
+    it = options_.find(route->first);
+    return it != options_.end() ? pick(it->second) : nullptr;
 }
 
 void HttpRouter::RegisterRoutes() {
@@ -109,15 +178,16 @@ void HttpRouter::RegisterRoutes() {
     router.get("/index.html", HttpController::showJudgePage);
 
     // 静态文件服务
-    router.get("/static/*", HttpController::serveStaticFile);
+    router.get("/static/*", StaticFileController::serveStaticFile);
 
     // 注册相关 - 同一路径处理GET和POST
-    router.get("/register", HttpController::handleRegister);  // 显示注册页面或处理注册请求
-    router.post("/register", HttpController::handleRegister);   // 处理注册请求
+    router.get("/register", HttpController::handleRegister);  // 显示注册页面
+    router.post_co("/register", HttpController::handleRegisterCo);   // 处理注册请求（哈希 + 访问存储，在哈希线程池上执行）
 
     // 登录相关 - 同一路径处理GET和POST
-    router.get("/login", HttpController::handleLogin);    // 显示登录页面或处理登录请求
-    router.post("/login", HttpController::handleLogin);     // 处理登录请求
+    router.get("/login", HttpController::handleLogin);    // 显示登录页面
+    router.post_co("/login", HttpController::handleLoginCo);     // 处理登录请求（哈希 + 访问存储，在哈希线程池上执行）
+    router.get("/logout", HttpController::handleLogout);      // 清除会话 Cookie
 
     // 登录后的欢迎页面
     router.get("/welcome", HttpController::showWelcomePage);  // 欢迎页面
@@ -127,6 +197,9 @@ void HttpRouter::RegisterRoutes() {
     router.get("/picture", HttpController::showPicturePage);  // 图片页
     router.get("/video", HttpController::showVideoPage);    // 视频页
 
+    // 运行指标
+    router.get("/metrics", HttpController::showMetrics);
+
     // 对应的页面处理 - 直接文件访问路由
     router.get("/picture.html", StaticFileController::serveStaticFile);  // 图片页
     router.get("/video.html", StaticFileController::serveStaticFile);      // 视频页
@@ -0,0 +1,51 @@
+#ifndef WEBSERVER_ASSET_FINGERPRINT_H
+#define WEBSERVER_ASSET_FINGERPRINT_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief 静态资源指纹：启动时按内容哈希为 docroot 中的资源生成 /static/<hash>/<name> 别名，
+ *        并把 HTML 页面中对这些资源的引用改写为别名，别名可以永久缓存（immutable）
+ *        build() 在 reactor 启动前调用一次，之后只读，无需加锁
+ */
+class AssetFingerprint {
+public:
+    static constexpr std::string_view kPrefix = "/static/";
+
+    struct Page {
+        std::shared_ptr<const std::string> body; // 改写后的 HTML
+        std::string etag;
+        // 启动时压缩好的变体，压缩后不更小或编码不可用时为空
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> zstd;
+    };
+
+    static AssetFingerprint& Instance();
+
+    void build(const std::string& doc_root);
+    bool enabled() const { return enabled_; }
+
+    // 解析 "/static/<hash>/<name>"：name 为相对 docroot 的路径（以 / 开头），current 表示 hash 与当前内容一致
+    bool resolve(std::string_view uri, std::string& name, bool& current) const;
+
+    // 引用了指纹资源的页面（按绝对路径），没有改写的页面返回 nullptr
+    const Page* page(const std::string& filepath) const;
+
+    // 资源的指纹别名，未登记的资源返回空串
+    std::string alias(const std::string& name) const;
+
+private:
+    AssetFingerprint() = default;
+
+    std::string rewrite(const std::string& html, const std::string& page_dir) const;
+
+    bool enabled_ = false;
+    std::string doc_root_;
+    std::unordered_map<std::string, std::string> hashes_; // "/xxx.jpg" -> hash
+    std::unordered_map<std::string, Page> pages_;
+};
+
+#endif // WEBSERVER_ASSET_FINGERPRINT_H
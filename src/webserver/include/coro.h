@@ -0,0 +1,362 @@
+#ifndef CORO_H
+#define CORO_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "deadline.h"
+#include "threadpool.h"
+
+class SubReactor;
+class HttpRequest;
+struct ReactorLink;
+
+/**
+ * @brief 运行在 SubReactor 事件循环上的协程处理函数
+ *        协程只在所属 reactor 线程上恢复：定时器由该 reactor 的 TimerWheel 触发，fd 就绪由其 epoll 触发，
+ *        线程池结果经 queueInLoop 交还；协程帧从 reactor 线程本地的帧池分配
+ */
+namespace Coro {
+    // 帧池：按 64 字节分级的线程本地空闲链表，协程帧在所属 reactor 线程上分配与释放，无锁
+    class FramePool {
+    public:
+        static void* allocate(size_t size);
+        static void deallocate(void* p, size_t size) noexcept;
+    };
+
+    struct PooledFrame {
+        static void* operator new(size_t size) { return FramePool::allocate(size); }
+        static void operator delete(void* p, size_t size) noexcept { FramePool::deallocate(p, size); }
+    };
+
+    // 等待线程池任务时超过截止时间（任务尚未开始即被丢弃）
+    class DeadlineExceeded : public std::runtime_error {
+    public:
+        DeadlineExceeded() : std::runtime_error("deadline exceeded") {}
+    };
+
+    template<typename T = void>
+    class Task;
+
+    namespace detail {
+        struct PromiseBase : PooledFrame {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            // 结束时对称转移到等待方，嵌套调用不增长栈
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                template<typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+                    auto next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct Promise : PromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+            T take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Promise<void> : PromiseBase {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        // 当前线程所属的 SubReactor，不在 reactor 线程上时抛出 logic_error
+        SubReactor& currentReactor();
+
+        // 当前 reactor 的交还入口（见 ReactorLink），跨线程等待的协程经它恢复
+        std::shared_ptr<ReactorLink> currentLink();
+
+        // 在 owner 线程上恢复协程（线程安全）；reactor 已销毁时丢弃，协程不再恢复
+        void resumeOn(const std::shared_ptr<ReactorLink>& owner, std::coroutine_handle<> h);
+    }
+
+    /**
+     * @brief 惰性启动的协程任务：被 co_await 时才开始执行，结束后恢复等待方
+     */
+    template<typename T>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = detail::Promise<T>;
+
+        Task() = default;
+        explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle_) {
+                    handle_.destroy();
+                }
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            if (handle_) {
+                handle_.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle_.promise().continuation = awaiting;
+            return handle_;
+        }
+
+        T await_resume() { return handle_.promise().take(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    namespace detail {
+        template<typename T>
+        Task<T> Promise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> Promise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+        }
+    }
+
+    // 在当前 reactor 线程上启动顶层协程，结束后以异常（无异常为空）调用 done
+    void spawn(Task<> task, std::function<void(std::exception_ptr)> done);
+
+    // 定时器：由所属 reactor 的 TimerWheel 触发，精度为时间轮刻度（100ms）
+    class SleepAwaiter {
+    public:
+        explicit SleepAwaiter(std::chrono::milliseconds delay) : delay_(delay) {}
+
+        bool await_ready() const noexcept { return delay_.count() <= 0; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept {}
+
+    private:
+        std::chrono::milliseconds delay_;
+    };
+
+    inline SleepAwaiter sleep(std::chrono::milliseconds delay) { return SleepAwaiter(delay); }
+
+    // fd 就绪：在所属 reactor 的 epoll 上一次性注册，就绪后注销并恢复，返回 epoll 事件位；
+    // 给出 timeout 时超时返回 0。等待期间调用方不得关闭该 fd
+    class FdAwaiter {
+    public:
+        FdAwaiter(int fd, uint32_t events, std::chrono::milliseconds timeout) :
+            fd_(fd), events_(events), timeout_(timeout) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        uint32_t await_resume() const noexcept { return revents_; }
+
+    private:
+        int fd_;
+        uint32_t events_;
+        std::chrono::milliseconds timeout_;
+        uint32_t revents_ {0};
+    };
+
+    FdAwaiter readable(int fd, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    FdAwaiter writable(int fd, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * @brief 阻塞调用交给计算线程池（或指定的线程池）执行，结果经 queueInLoop 回到所属 reactor 后恢复
+     *        给出截止时间或取消标记时按截止时间优先调度，执行期间 Deadline::current() 返回该截止时间；
+     *        开始执行前已过期或已取消（连接已关闭）则不再执行，抛出 DeadlineExceeded
+     */
+    template<typename F>
+    class OffloadAwaiter {
+    public:
+        using Result = std::invoke_result_t<F&>;
+
+        OffloadAwaiter(FThreadPool& pool, F fn, Deadline::TimePoint deadline, Deadline::CancelToken cancel)
+            : pool_(pool), fn_(std::move(fn)), deadline_(deadline), cancel_(std::move(cancel)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            auto owner = detail::currentLink();
+            if (deadline_ == Deadline::kNone && !cancel_) {
+                pool_.pushTask([this, owner, h](size_t) {
+                    run();
+                    detail::resumeOn(owner, h);
+                });
+                return;
+            }
+            pool_.pushDeadlineTask(deadline_, cancel_,
+                [this, owner, h](size_t) {
+                    run();
+                    detail::resumeOn(owner, h);
+                },
+                [this, owner, h](size_t) {
+                    error_ = std::make_exception_ptr(DeadlineExceeded());
+                    detail::resumeOn(owner, h);
+                });
+        }
+
+        Result await_resume() {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            if constexpr (!std::is_void_v<Result>) {
+                return std::move(*result_);
+            }
+        }
+
+    private:
+        // 工作线程上执行；结果写入等待者（位于协程帧内），queueInLoop 的锁保证 reactor 线程可见
+        void run() {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    fn_();
+                } else {
+                    result_.emplace(fn_());
+                }
+            } catch (...) {
+                error_ = std::current_exception();
+            }
+        }
+
+        struct Empty {};
+        using Storage = std::conditional_t<std::is_void_v<Result>, Empty, std::optional<Result>>;
+
+        FThreadPool& pool_;
+        F fn_;
+        Deadline::TimePoint deadline_;
+        Deadline::CancelToken cancel_;
+        Storage result_ {};
+        std::exception_ptr error_;
+    };
+
+    // 请求处理协程传入 req.deadline() 与 req.cancel_token()
+    template<typename F>
+    OffloadAwaiter<std::decay_t<F>> offload(F&& fn, Deadline::TimePoint deadline = Deadline::kNone,
+                                            Deadline::CancelToken cancel = {}) {
+        return OffloadAwaiter<std::decay_t<F>>(FThreadPool::getInst(), std::forward<F>(fn), deadline, std::move(cancel));
+    }
+
+    // 交给指定线程池（如口令哈希专用池），不占用通用计算线程
+    template<typename F>
+    OffloadAwaiter<std::decay_t<F>> offload(FThreadPool& pool, F&& fn, Deadline::TimePoint deadline = Deadline::kNone,
+                                            Deadline::CancelToken cancel = {}) {
+        return OffloadAwaiter<std::decay_t<F>>(pool, std::forward<F>(fn), deadline, std::move(cancel));
+    }
+
+    /**
+     * @brief 回调式异步接口：start 收到完成函数，由接口在任意线程调用一次，结果经 queueInLoop 回到所属 reactor 后恢复；
+     *        完成函数收到非空 exception_ptr 时在 co_await 处重新抛出
+     */
+    template<typename T>
+    class CallbackAwaiter {
+    public:
+        using Complete = std::function<void(T, std::exception_ptr)>;
+
+        explicit CallbackAwaiter(std::function<void(Complete)> start) : start_(std::move(start)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            auto owner = detail::currentLink();
+            start_([this, owner, h](T value, std::exception_ptr error) {
+                result_.emplace(std::move(value));
+                error_ = std::move(error);
+                detail::resumeOn(owner, h);
+            });
+        }
+
+        T await_resume() {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return std::move(*result_);
+        }
+
+    private:
+        std::function<void(Complete)> start_;
+        std::optional<T> result_;
+        std::exception_ptr error_;
+    };
+
+    template<typename T>
+    CallbackAwaiter<T> callback(std::function<void(typename CallbackAwaiter<T>::Complete)> start) {
+        return CallbackAwaiter<T>(std::move(start));
+    }
+
+    /**
+     * @brief 请求体分块读取：co_await reader.next() 依次得到不超过 chunk_size 的片段，读完返回空
+     *        解析器目前在分发前已完整接收请求体（受 InputBuffer 上限约束），每块都立即就绪；
+     *        接口保持可挂起的形式，请求体改为增量接收后处理函数无需修改
+     */
+    class BodyReader {
+    public:
+        BodyReader(const HttpRequest& request, size_t chunk_size = 16 * 1024);
+
+        struct ChunkAwaiter {
+            BodyReader& reader;
+
+            bool await_ready() const noexcept { return true; }
+            void await_suspend(std::coroutine_handle<>) const noexcept {}
+            std::string_view await_resume() noexcept { return reader.take(); }
+        };
+
+        ChunkAwaiter next() noexcept { return ChunkAwaiter {*this}; }
+
+        bool done() const noexcept { return offset_ >= body_.size(); }
+
+    private:
+        std::string_view take() noexcept;
+
+        std::string_view body_;
+        size_t chunk_size_;
+        size_t offset_ {0};
+    };
+}
+
+#endif // CORO_H
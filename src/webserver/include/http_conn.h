@@ -6,15 +6,25 @@
 #define HTTP_CONN_H
 
 #include <netinet/in.h>
+#include <atomic>
+#include <climits>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <sys/uio.h>
 #include <vector>
 
+#include "concurrency_limiter.h"
+#include "deadline.h"
 #include "http_parser.h"
 #include "input_buffer.h"
+#include "micro_cache.h"
+#include "middleware.h"
 #include "output_buffer.h"
+#include "http_request.h"
 #include "http_response.h"
+#include "http_router.h"
 
 class HttpRequest;
 class HttpResponse;
@@ -23,18 +33,48 @@ constexpr const int FILENAME_LEN = 200;
 constexpr const int READ_BUFFER_SIZE = 2048;
 constexpr const int WRITE_BUFFER_SIZE = 1024;
 
+// 大文件（视频、大图等）发送策略：按 MIME 限速（SO_MAX_PACING_RATE）并提示内核顺序读
+struct LargeFilePolicy {
+    size_t min_bytes = 0;        // 文件数据达到该大小才按大文件处理，0 表示关闭
+    size_t prefetch_window = 0;  // 渐进式预读窗口
+    uint32_t video_rate = 0;     // 字节/秒，0 表示不限速
+    uint32_t audio_rate = 0;
+    uint32_t image_rate = 0;
+    uint32_t default_rate = 0;
+};
+
 class HttpConnection {
 public:
-    using Middleware = std::function<void(const HttpRequest&, HttpResponse&)>;
+    // 移交出连接的请求：请求与响应随任务转移，处理期间不接触连接对象
+    // coroutine 非空时为协程路由，在 reactor 线程上运行，挂起期间 fd 保持未武装；处理协程经 Coro::offload 交给线程池的调用
+    // 受 deadline 与 cancel 约束：cancel 与连接生命周期绑定（关闭 / 超时即置位），deadline 之后开始执行已无意义
+    // permit 为路由隔离舱的名额，结果交还 reactor 时归还（连接已关闭时随任务析构归还）
+    // middleware 为命中路由的路由级中间件，处理函数结束后执行其 after 阶段
+    // cache 非空时本请求负责微缓存这次计算，后置中间件执行完后交出结果；
+    // awaiting 非空时请求不执行处理函数，只等待同一 key 上进行中的计算
+    struct OffloadJob {
+        HttpRequest request;
+        HttpResponse response;
+        Deadline::TimePoint deadline = Deadline::kNone;
+        Deadline::CancelToken cancel;
+        const HttpCoroHandler* coroutine = nullptr;
+        const RouteMiddleware* middleware = nullptr;
+        ConcurrencyLimiter::Permit permit {};
+        MicroCache::Ticket cache {};
+        std::shared_ptr<MicroCache::Flight> awaiting {};
+    };
 
     HttpConnection() {}
 
-    static void add_pre_handler(const Middleware& handler) {
-        pre_handlers_.push_back(handler);
+    // 全局中间件（作用于所有请求）：返回 false 短路，见 MiddlewarePipeline；只在某些路由上生效的用 HttpRouter::before / after
+    template <typename M>
+    static void add_pre_handler(M handler) {
+        pre_handlers_.add(std::move(handler));
     }
 
-    static void add_post_handler(const Middleware& handler) {
-        pre_handlers_.push_back(handler);
+    template <typename M>
+    static void add_post_handler(M handler) {
+        post_handlers_.add(std::move(handler));
     }
 
     void Init(int fd, int epoll_fd, sockaddr_in client_addr);
@@ -47,13 +87,42 @@ public:
     bool WriteOnce();
     void ProcessHttp();
 
+    // 本轮 I/O 预算耗尽（仍可继续读/写），由 SubReactor 放入就绪队列在本轮其他事件之后恢复
+    bool WriteBudgetExhausted() const { return write_budget_exhausted_; }
+    bool ReadBudgetExhausted() const { return read_buffer_.budget_exhausted() && awaiting_input_; }
+
+    // 连接代数：每次 Init 新连接时递增，用于异步回调校验 fd 槽位是否已被复用
+    uint64_t Generation() const { return generation_; }
+
+    // 异步预读：WriteOnce 发现文件窗口不在 page cache 时挂起写入，由 SubReactor 取走任务投递到 I/O 线程池；
+    // file_fd 为正在发送的文件的副本（调用方负责关闭），不按路径重新打开
+    bool TakeReadahead(int& file_fd, OutputBuffer::ReadaheadHint& hint);
+    // 预读完成：重新探测窗口，仍未常驻时返回 false，由 SubReactor 再预读一次（之后退化为同步发送）
+    bool ResumeAfterReadahead();
+
+    // 协程路由 / 等待微缓存：ProcessHttp 只执行到前置中间件，由 SubReactor 取走任务继续处理
+    std::unique_ptr<OffloadJob> TakeOffload() { return std::move(offload_job_); }
+    // 微缓存后台刷新：本请求已用过期条目应答，刷新任务（请求副本 + ticket）由 SubReactor 按普通请求的路径调度
+    std::unique_ptr<OffloadJob> TakeRevalidation() { return std::move(revalidate_job_); }
+    // 执行路由与后置中间件（不访问任何连接状态），微缓存后台刷新使用
+    static void RunOffload(OffloadJob& job);
+    // 线程池调用排队超过截止时间被丢弃：返回 503，由 CompleteOffload 照常发送
+    static void DropOffload(OffloadJob& job);
+    // 协程路由：执行处理协程与后置中间件，异常与 DeadlineExceeded 分别转为 500 / 503
+    static Coro::Task<> RunCoroutine(OffloadJob& job);
+    // 回到 reactor 线程：接管响应并准备发送
+    void CompleteOffload(OffloadJob& job);
+
 private:
-    static bool PreHandlersCheck(const HttpRequest& request, HttpResponse& response);
-    static bool PostHandlersCheck(const HttpRequest& request, HttpResponse& response);
+    static bool PreHandlersCheck(const HttpRequest& request, HttpResponse& response, const RouteMiddleware* route);
+    static void PostHandlersCheck(const HttpRequest& request, HttpResponse& response, const RouteMiddleware* route);
+    void ScheduleRevalidation(const HttpRequest& request, const RouteMiddleware* route, MicroCache::Ticket ticket);
     
     void BeginGracefulClose(); // 开始优雅关闭
+    void PrepareResponse(bool header_only); // finalize 并装填发送缓冲区，注册 EPOLLOUT
     void make_response_mmap();    // 使用 mmap + writev
     void make_response_sendfile(); // 使用 sendfile
+    void apply_large_file_policy(); // 大文件：顺序读提示 + 按 MIME 限速
     
     int epoll_fd_ {-1};
     int conn_fd_ {-1};
@@ -67,17 +136,58 @@ private:
     // http
     HttpRequestParser parser_;
     HttpResponse response_;
-    static inline std::vector<Middleware> pre_handlers_;
-    static inline std::vector<Middleware> post_handlers_;
+    static inline MiddlewarePipeline pre_handlers_;
+    static inline MiddlewarePipeline post_handlers_;
 
     // options
     bool use_edge_trig_{};
     bool closing_ {false}; // 是否正在优雅关闭
     bool static use_sendfile_; // true=sendfile, false=mmap+writev
+
+    // fairness budget
+    bool write_budget_exhausted_ {false};
+    bool awaiting_input_ {false}; // 请求尚未完整，等待更多输入
+    static inline size_t io_budget_bytes_ {SIZE_MAX};
+    static inline int io_budget_iterations_ {INT_MAX};
+
+    // pacing
+    uint32_t pacing_rate_ {0}; // 当前 socket 上生效的限速，0 表示不限速
+    static inline LargeFilePolicy large_file_policy_ {};
+
+    // readahead
+    uint64_t generation_ {0};
+    static inline std::atomic<uint64_t> generation_counter_ {0};
+    bool readahead_pending_ {false};    // 等待预读完成，期间不写也不注册 EPOLLOUT
+    bool readahead_dispatched_ {false};
+    int readahead_attempts_ {0};        // 同一窗口已预读的次数
+    static constexpr int kMaxReadaheadAttempts = 2;
+    OutputBuffer::ReadaheadHint readahead_hint_ {};
+    static inline size_t readahead_window_ {0};
+    static inline size_t readahead_min_bytes_ {0};
+
+    // offload
+    std::unique_ptr<OffloadJob> offload_job_;
+    bool offload_pending_ {false}; // 响应由处理协程 / 进行中的微缓存计算生成，期间 fd 不在 epoll 中，也不写
+    Deadline::CancelToken offload_cancel_;
+    std::unique_ptr<OffloadJob> revalidate_job_;
+    static inline std::chrono::milliseconds offload_timeout_ {0};
     
 public:
     void static set_use_sendfile(bool enable) { use_sendfile_ = enable; }
     bool static use_sendfile() { return use_sendfile_; }
+    // 每个连接每轮事件循环的 I/O 预算（字节数 / 系统调用次数）
+    void static set_io_budget(size_t bytes, int iterations) {
+        io_budget_bytes_ = bytes;
+        io_budget_iterations_ = iterations;
+    }
+    void static set_large_file_policy(const LargeFilePolicy& policy) { large_file_policy_ = policy; }
+    // window 为 0 时关闭预读检查
+    void static set_readahead(size_t window, size_t min_bytes) {
+        readahead_window_ = window;
+        readahead_min_bytes_ = min_bytes;
+    }
+    // 协程路由每个请求的处理时限（交给线程池的调用在此之后开始执行即丢弃并返回 503），0 表示不限
+    void static set_offload_timeout(int timeout_ms) { offload_timeout_ = std::chrono::milliseconds(timeout_ms); }
 };
 
 #endif // HTTP_CONN_H
@@ -5,6 +5,8 @@
 #ifndef HTTP_CONTROLLER_H
 #define HTTP_CONTROLLER_H
 
+#include "coro.h"
+
 class HttpRequest;
 class HttpResponse;
 
@@ -13,11 +15,23 @@ namespace HttpController {
     void hello(const HttpRequest& req, HttpResponse& resp);
     void serveStaticFile(const HttpRequest& req, HttpResponse& resp);
 
-    // 处理注册请求（GET显示页面，POST处理表单）
+    // 显示注册页面（GET）
     void handleRegister(const HttpRequest& req, HttpResponse& resp);
     
-    // 处理登录请求（GET显示页面，POST处理表单）
+    // 显示登录页面（GET）
     void handleLogin(const HttpRequest& req, HttpResponse& resp);
+
+    // 注册 / 登录（POST）：口令哈希交给哈希线程池，存储访问交给通用线程池（受请求截止时间约束），
+    // reactor 线程只挂起等待，任何配置下都不阻塞
+    Coro::Task<> handleRegisterCo(const HttpRequest& req, HttpResponse& resp);
+    Coro::Task<> handleLoginCo(const HttpRequest& req, HttpResponse& resp);
+
+    // 注册 / 登录（POST）的协程版本：在 reactor 线程上经非阻塞 MySQL 客户端访问数据库
+    Coro::Task<> handleRegisterAsync(const HttpRequest& req, HttpResponse& resp);
+    Coro::Task<> handleLoginAsync(const HttpRequest& req, HttpResponse& resp);
+
+    // 登出：清除会话 Cookie 并跳转登录页
+    void handleLogout(const HttpRequest& req, HttpResponse& resp);
     
     // 主页（判断页面）
     void showJudgePage(const HttpRequest& req, HttpResponse& resp);
@@ -31,6 +45,9 @@ namespace HttpController {
     // 展示视频页面
     void showVideoPage(const HttpRequest& req, HttpResponse& resp);
 
+    // 进程内指标（文本格式）
+    void showMetrics(const HttpRequest& req, HttpResponse& resp);
+
     // 展示粉丝页面
     void showFansPage(const HttpRequest& req, HttpResponse& resp);
 }
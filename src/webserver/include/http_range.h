@@ -0,0 +1,41 @@
+#ifndef WEBSERVER_HTTP_RANGE_H
+#define WEBSERVER_HTTP_RANGE_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @brief RFC 7233 Range / If-Range 解析（手写，无 regex、无堆分配）
+ */
+namespace HttpRange {
+    // 单个请求允许的最大区间数，超过则忽略 Range（RFC 7233 允许）
+    constexpr size_t kMaxRanges = 16;
+
+    struct ByteRange {
+        size_t start;
+        size_t length;
+    };
+
+    struct RangeSet {
+        std::array<ByteRange, kMaxRanges> ranges {};
+        size_t count = 0;
+
+        const ByteRange* begin() const { return ranges.data(); }
+        const ByteRange* end() const { return ranges.data() + count; }
+    };
+
+    enum class Result {
+        OK,              // 至少一个可满足区间 -> 206
+        IGNORE,          // 语法错误/非 bytes 单位/区间过多 -> 忽略 Range，按 200 返回整个文件
+        NOT_SATISFIABLE  // 语法正确但没有可满足区间 -> 416
+    };
+
+    // 解析 Range 头，区间已按文件大小裁剪；重叠区间会被排序合并，避免重复发送
+    auto parse(std::string_view header, size_t file_size, RangeSet& out) -> Result;
+
+    // If-Range 校验：实体标签做强比较，日期与 Last-Modified 精确匹配
+    bool ifRangeMatches(std::string_view if_range, std::string_view etag, std::string_view last_modified);
+}
+
+#endif // WEBSERVER_HTTP_RANGE_H
@@ -5,12 +5,15 @@
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
+#include "deadline.h"
+
 class HttpRequest {
 public:
-    enum class Method { GET, POST };
+    enum class Method { GET, POST, HEAD };
 
     void set_method(Method m) { method_ = m; }
     Method method() const { return method_; }
@@ -36,6 +39,19 @@ public:
     void set_version(std::string version) { version_ = std::move(version); }
     const std::string &version() const { return version_; }
 
+    // 对端 IPv4 地址（网络字节序），由连接在解析完成后填入
+    void set_client_addr(uint32_t addr) { client_addr_ = addr; }
+    uint32_t client_addr() const { return client_addr_; }
+
+    // 截止时间与取消标记，由连接在交给处理协程前填入；处理协程把它们传给 Coro::offload，
+    // 排队超时 / 连接关闭的任务不再执行，执行期间 Deadline::current() 返回该截止时间
+    void set_deadline(Deadline::TimePoint deadline, Deadline::CancelToken cancel) {
+        deadline_ = deadline;
+        cancel_ = std::move(cancel);
+    }
+    Deadline::TimePoint deadline() const { return deadline_; }
+    const Deadline::CancelToken &cancel_token() const { return cancel_; }
+
     // 获取所有请求头
     const std::unordered_map<std::string, std::string> &headers() const { return headers_; }
     // 设置请求头
@@ -68,6 +84,9 @@ private:
     bool keep_alive_ = false;
     size_t content_length_ = 0;
     bool cgi_ = false;
+    uint32_t client_addr_ = 0;
+    Deadline::TimePoint deadline_ = Deadline::kNone;
+    Deadline::CancelToken cancel_;
     std::unordered_map<std::string, std::string> headers_;
     std::unordered_map<std::string, std::string> form_fields_; // 存储解析后的表单字段
 };
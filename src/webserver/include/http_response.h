@@ -11,9 +11,14 @@
 #include <vector>
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <memory>
 
+#include "http_range.h"
+#include "output_buffer.h"
+#include "path_util.h"
+
 enum class HttpStatus {
     OK = 200,
     FOUND = 302,
@@ -23,8 +28,10 @@ enum class HttpStatus {
     METHOD_NOT_ALLOWED = 405,
     FORBIDDEN = 403,
     NOT_FOUND = 404,
+    TOO_MANY_REQUESTS = 429,
     REQUESTED_RANGE_NOT_SATISFIABLE = 416,
-    INTERNAL_ERROR = 500
+    INTERNAL_ERROR = 500,
+    SERVICE_UNAVAILABLE = 503
 };
 
 class HttpResponse {
@@ -34,15 +41,30 @@ public:
     void set_body(std::string body);
     void set_content_length(size_t len);
     void set_file(std::string filepath); // 触发 mmap + writev
+    // 已打开的文件（openat2 得到的 fd），发送时直接使用，不再按路径 stat / open
+    void set_opened_file(std::string filepath, UniqueFd fd, size_t size);
     void set_file_with_range(std::string filepath, size_t start, size_t length); // 支持范围请求
+    void clear_file();
+    // 多段范围请求：multipart/byteranges，分段头在内存中，文件段仍走零拷贝
+    void set_file_with_ranges(std::string filepath, std::string_view content_type, size_t file_total,
+                              const HttpRange::RangeSet& ranges);
+    // 外部只读响应体（压缩缓存结果 / 资源包映射区），owner 保证发送完成前内存有效，不拷贝
+    void set_shared_body(std::shared_ptr<const std::string> body);
+    void set_external_body(std::string_view body, std::shared_ptr<const void> owner);
+    // 预序列化的响应头块（每行以 \r\n 结尾，含 Content-Type），owner 为空时内存须在 finalize 前保持有效
+    void set_raw_headers(std::string_view headers, std::shared_ptr<const void> owner = nullptr);
     void set_error_page(HttpStatus code);
     void set_keep_alive(bool enable);
     void set_handled();
+    // HEAD：头部（含 Content-Length）与 GET 相同，但不发送响应体
+    void set_header_only(bool enable) { header_only_ = enable; }
 
+    HttpStatus status() const { return status_code_; }
     bool is_error() const;        // 是否是错误响应（4xx/5xx）
     bool is_success() const;      // 是否成功（2xx）
     bool is_handled() const;      // 是否已被拦截处理（如鉴权失败）
     bool has_header(const std::string& key) const;
+    const std::string* header(const std::string& key) const;
     bool keep_alive() const;
     const std::string& body();
 
@@ -59,8 +81,20 @@ public:
     size_t file_size() const { return file_size_; }
 
     bool has_file() const { return !file_path_.empty(); }
+    // 交出已打开文件的所有权（无则返回 -1）
+    int release_file_fd() { return file_fd_.release(); }
+    bool has_external_body() const { return body_owner_ != nullptr; }
+    std::string_view external_body() const { return external_body_; }
+    bool is_multipart() const { return !file_segments_.empty(); }
+    const std::vector<FileSegment>& file_segments() const { return file_segments_; }
+    std::string_view multipart_trailer() const { return multipart_trailer_; }
     bool will_close() const { return close_connection_; }
 
+    // 导出可复用的响应：除 Content-Length / Connection / Server 外的响应头序列化为一块（含 Content-Type），
+    // 响应体为内存中的 body 或外部响应体；文件响应无法导出，返回 false
+    bool export_headers(std::string& headers) const;
+    std::string_view body_view() const { return body_owner_ ? external_body_ : std::string_view(body_); }
+
     void reset();
 
 private:
@@ -68,19 +102,31 @@ private:
     std::string reason_phrase_;
     std::map<std::string, std::string> headers_;
     std::string body_;
+    std::shared_ptr<const void> body_owner_;
+    std::string_view external_body_;
+    std::string_view raw_headers_;
+    std::shared_ptr<const void> raw_headers_owner_;
     bool handled_ {};
 
     // 文件相关（只存储参数，不做 I/O）
     std::string file_path_;
     size_t file_size_ = 0;
     size_t file_start_ = 0;  // 文件范围起始位置
+    UniqueFd file_fd_;
+
+    // multipart/byteranges：分段头与结尾分隔符集中存放，segments 中的 prefix 指向 multipart_buf_
+    std::string multipart_buf_;
+    std::string_view multipart_trailer_;
+    std::vector<FileSegment> file_segments_;
 
     // 缓存构造好的 header
     std::vector<char> resp_buf_;
 
     bool close_connection_ = false;
+    bool header_only_ = false;
 
     void build_response();
+    std::string default_content_type() const;
 
     friend class HttpResponseBuilder; // 可选：builder 模式
 };
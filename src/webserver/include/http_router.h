@@ -10,13 +10,22 @@
 #include <functional>
 
 #include <functional>
+#include <memory>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 
-class HttpRequest;
+#include "coro.h"
+#include "http_request.h"
+#include "micro_cache.h"
+#include "middleware.h"
+
+class ConcurrencyLimiter;
 class HttpResponse;
 
 using HttpHandlerFunc = std::function<void(const HttpRequest&, HttpResponse&)>;
+// 协程处理函数：在 reactor 线程上运行，可 co_await 定时器、fd 就绪、线程池调用与请求体分块
+using HttpCoroHandler = std::function<Coro::Task<>(const HttpRequest&, HttpResponse&)>;
 
 class HttpRouter {
 public:
@@ -25,11 +34,45 @@ public:
         return r;
     }
 
+    // 普通处理函数在 reactor 线程上内联执行，不能阻塞；需要阻塞调用（如访问数据库）的处理写成协程路由，
+    // 经 Coro::offload 把阻塞部分交给线程池
     void get(std::string path, HttpHandlerFunc handler);
     void post(std::string path, HttpHandlerFunc handler);
 
+    // 协程路由（只支持精确路径）
+    void get_co(std::string path, HttpCoroHandler handler);
+    void post_co(std::string path, HttpCoroHandler handler);
+
     bool match(const HttpRequest& req, HttpResponse& resp) const;
 
+    // 请求命中的协程处理函数，没有则返回 nullptr；返回的指针在路由表生命周期内有效
+    const HttpCoroHandler* coroutine(const HttpRequest& req) const;
+
+    // 并发隔离：path 上的协程处理函数共用 limiter 的名额（多个路径可共用一个 limiter 组成一类），
+    // 展示页面等非阻塞处理不计入；须在开始处理请求前设置
+    void set_bulkhead(const std::string& path, std::shared_ptr<ConcurrencyLimiter> limiter);
+    // 请求所属的隔离舱，没有则返回 nullptr（只检查精确匹配）
+    ConcurrencyLimiter* bulkhead(const HttpRequest& req) const;
+
+    // 响应微缓存：path 的 GET / HEAD 响应按 policy 缓存（协程处理函数不支持）；须在开始处理请求前设置
+    void set_micro_cache(const std::string& path, const MicroCache::Policy& policy);
+    // 请求适用的缓存策略，没有则返回 nullptr（只检查精确匹配）
+    const MicroCache::Policy* micro_cache(const HttpRequest& req) const;
+
+    // 路由级中间件：只作用于 path 上指定方法的请求（HEAD 与 GET 共用）。path 可以是精确路径，也可以是路由的
+    // 通配符 / 扩展名模式；请求先按自身路径查找，再按实际命中的路由查找。与隔离舱、微缓存一样单独保存，
+    // 不会为 path 创建路由，可以在注册路由之前设置；静态资源等未挂载的路由不付出任何开销；须在开始处理请求前设置
+    template <typename M>
+    void before(const std::string& path, HttpRequest::Method method, M middleware) {
+        route_middleware(path, method).before.add(std::move(middleware));
+    }
+    template <typename M>
+    void after(const std::string& path, HttpRequest::Method method, M middleware) {
+        route_middleware(path, method).after.add(std::move(middleware));
+    }
+    // 请求命中的路由级中间件，没有则返回 nullptr；返回的指针在路由表生命周期内有效
+    const RouteMiddleware* middleware(const HttpRequest& req) const;
+
     HttpRouter(const HttpRouter&) = delete;
     HttpRouter& operator=(const HttpRouter&) = delete;
 
@@ -38,12 +81,30 @@ public:
 private:
     HttpRouter() = default;
 
+    RouteMiddleware& route_middleware(const std::string& path, HttpRequest::Method method);
+
+    struct Route;
+    // 请求路径命中的路由（精确匹配优先，其次通配符 / 扩展名），match 与中间件查找共用
+    const std::pair<const std::string, Route>* find_route(std::string_view uri) const;
+
     struct Route {
         HttpHandlerFunc get_handler;
         HttpHandlerFunc post_handler;
+        HttpCoroHandler get_coro;
+        HttpCoroHandler post_coro;
+    };
+
+    // 按路径挂载的附加设置，与路由表分开保存：只设置附加项的路径不会变成没有处理函数的路由（否则返回 405）
+    struct RouteOptions {
+        std::shared_ptr<ConcurrencyLimiter> bulkhead;
+        std::shared_ptr<const MicroCache::Policy> cache;
+        RouteMiddleware get_middleware;
+        RouteMiddleware post_middleware;
     };
 
     std::unordered_map<std::string, Route> routes_ {};
+    std::unordered_map<std::string, RouteOptions> options_ {};
+    bool pattern_middleware_ = false; // 是否有中间件挂在通配符 / 扩展名路由上
 };
 
 
@@ -8,6 +8,8 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <cerrno>
+#include <climits>
+#include <cstdint>
 #include <cstring>
 #include <vector>
 #include "logger.h"
@@ -17,6 +19,7 @@ private:
     static constexpr size_t BUFFER_SIZE = 4096;
     std::vector<char> buffer_;
     size_t read_end_; // 已经接收到的数据末尾位置
+    bool budget_exhausted_ {false}; // 上一次 ET 读取因预算耗尽而提前停止（socket 中可能还有数据）
 
 public:
     InputBuffer() : buffer_(BUFFER_SIZE), read_end_(0) {}
@@ -55,11 +58,15 @@ public:
     void clear() { read_end_ = 0; }
 
     // 真正执行读操作（LT/ET 模式在此区分）
-    bool read_from(int fd, bool use_edge_trigger = false, bool graceful_closing = false);
+    // budget_bytes / budget_iterations 限制单次 ET 读取的字节数与 recv 次数，避免单个连接霸占 reactor
+    bool read_from(int fd, bool use_edge_trigger = false, bool graceful_closing = false,
+                   size_t budget_bytes = SIZE_MAX, int budget_iterations = INT_MAX);
+
+    bool budget_exhausted() const { return budget_exhausted_; }
 
 private:
     bool read_lt(int fd);
-    bool read_et(int fd);
+    bool read_et(int fd, size_t budget_bytes, int budget_iterations);
     bool check_peer_fin(int fd); // 优雅关闭时检查对端 FIN
 };
 
@@ -0,0 +1,135 @@
+#ifndef MICRO_CACHE_H
+#define MICRO_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "http_response.h"
+#include "metrics.h"
+
+class HttpRequest;
+
+/**
+ * @brief 动态路由的响应微缓存（按路由开启）
+ *        - key 为 方法 + URI + 查询串 + 策略中列出的请求头（HEAD 与 GET 共用）；响应含 Set-Cookie 或
+ *          Cache-Control: no-store / private 时不缓存，按用户区分的页面须把 Cookie 列入 vary
+ *        - 条目为经后置中间件（压缩）处理后的预序列化响应头块 + 响应体，
+ *          以 shared_ptr<const Entry> 在各 reactor 间只读共享，命中时不拷贝
+ *        - 同一 key 同时只有一次计算（singleflight）：第一个未命中的请求负责计算，其余请求挂起等待它的结果
+ *        - 过期后 stale_while_revalidate 内先返回旧响应，同时交给本请求一个 ticket 负责后台刷新
+ *          （由 HttpConnection 按普通请求的路径调度）；计算失败（5xx）时 stale_if_error 内改用旧响应
+ */
+class MicroCache {
+public:
+    struct Policy {
+        std::chrono::milliseconds ttl {1000};
+        std::chrono::milliseconds stale_while_revalidate {0};
+        std::chrono::milliseconds stale_if_error {0};
+        std::vector<std::string> vary; // 参与 key 的请求头
+    };
+
+    struct Entry {
+        HttpStatus status;
+        std::string headers; // 每行以 \r\n 结尾，含 Content-Type
+        std::string body;
+        std::chrono::steady_clock::time_point stored;
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    // 一次进行中的计算；结果为空表示计算失败且没有可用的旧响应
+    class Flight {
+    public:
+        using Waiter = std::function<void(const EntryPtr&)>;
+        // 结果已就绪时在当前线程立即回调，否则在完成计算的线程上回调
+        void wait(Waiter waiter);
+
+    private:
+        friend class MicroCache;
+        void finish(EntryPtr result);
+
+        std::mutex mutex_;
+        bool done_ = false;
+        EntryPtr result_;
+        std::vector<Waiter> waiters_;
+    };
+
+    // 负责计算的请求持有：complete 时写入缓存并唤醒等待者，未 complete 即析构视为计算失败
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(Ticket&&) noexcept = default;
+        Ticket& operator=(Ticket&& other) noexcept;
+        ~Ticket();
+
+        explicit operator bool() const { return flight_ != nullptr; }
+        // 处理函数与后置中间件执行完后调用；失败且有可用旧响应时把 resp 替换为旧响应
+        void complete(HttpResponse& resp);
+
+    private:
+        friend class MicroCache;
+        std::string key_;
+        const Policy* policy_ = nullptr;
+        std::shared_ptr<Flight> flight_;
+    };
+
+    enum class Lookup {
+        Served,  // resp 已填好（新鲜或过期可用的条目）；ticket 非空表示条目已过期，本请求负责后台刷新
+        Wait,    // 同一 key 正在计算，flight 为其结果
+        Compute, // 未命中，ticket 交给本请求
+    };
+
+    static MicroCache& Instance();
+
+    void init(size_t budget_bytes);
+
+    Lookup lookup(const HttpRequest& req, const Policy& policy, HttpResponse& resp,
+                  std::shared_ptr<Flight>& flight, Ticket& ticket);
+
+    // 用条目填充响应（引用条目内存，不拷贝）
+    static void serve(const EntryPtr& entry, HttpResponse& resp);
+
+private:
+    MicroCache();
+
+    static constexpr size_t kShards = 16;
+
+    struct Slot {
+        EntryPtr entry;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Slot> entries;
+        std::list<std::string> lru; // 头部最近使用
+        std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+        size_t bytes = 0;
+    };
+
+    static std::string makeKey(const HttpRequest& req, const Policy& policy);
+    Shard& shardOf(const std::string& key);
+    void finish(Ticket& ticket, HttpResponse* resp);
+    void insertLocked(Shard& shard, const std::string& key, EntryPtr entry);
+
+    size_t shard_budget_ = 0;
+    std::atomic<size_t> total_bytes_ {0};
+    std::array<Shard, kShards> shards_;
+
+    // metrics
+    Metrics::Counter& hits_;
+    Metrics::Counter& stale_hits_;
+    Metrics::Counter& misses_;
+    Metrics::Counter& coalesced_;
+    Metrics::Counter& stale_on_error_;
+    Metrics::Counter& bytes_gauge_;
+};
+
+#endif // MICRO_CACHE_H
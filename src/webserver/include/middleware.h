@@ -0,0 +1,82 @@
+#ifndef MIDDLEWARE_H
+#define MIDDLEWARE_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class HttpRequest;
+class HttpResponse;
+
+namespace MiddlewareDetail {
+    // 返回 bool 的中间件由返回值决定是否继续，返回 void 的中间件总是继续
+    template <typename M>
+    inline bool invoke(const M& middleware, const HttpRequest& req, HttpResponse& resp) {
+        if constexpr (std::is_void_v<decltype(middleware(req, resp))>) {
+            middleware(req, resp);
+            return true;
+        } else {
+            return static_cast<bool>(middleware(req, resp));
+        }
+    }
+}
+
+/**
+ * @brief 中间件流水线：启动时组装成扁平的调用表 {函数指针, 状态}，请求路径上顺序执行，不经过 std::function
+ *        - 中间件签名为 bool / void (const HttpRequest&, HttpResponse&)；返回 false 表示响应已生成（短路），
+ *          其后的中间件与路由处理函数都不再执行
+ *        - 中间件对象由流水线持有，拷贝流水线时共享；组装须在开始处理请求前完成，之后只读
+ */
+class MiddlewarePipeline {
+public:
+    template <typename M>
+    MiddlewarePipeline& add(M middleware) {
+        auto state = std::make_shared<const M>(std::move(middleware));
+        stages_.push_back({[](const void* self, const HttpRequest& req, HttpResponse& resp) {
+            return MiddlewareDetail::invoke(*static_cast<const M*>(self), req, resp);
+        }, state.get()});
+        states_.push_back(std::move(state));
+        return *this;
+    }
+
+    bool run(const HttpRequest& req, HttpResponse& resp) const {
+        for (const auto& stage : stages_) {
+            if (!stage.call(stage.self, req, resp)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool empty() const { return stages_.empty(); }
+    size_t size() const { return stages_.size(); }
+
+private:
+    struct Stage {
+        bool (*call)(const void* self, const HttpRequest& req, HttpResponse& resp);
+        const void* self;
+    };
+
+    std::vector<Stage> stages_;
+    std::vector<std::shared_ptr<const void>> states_;
+};
+
+// 编译期组合：多个中间件合成一个阶段，调用在同一函数内展开（无间接调用），按顺序短路
+template <typename... Ms>
+auto compose_middleware(Ms... middlewares) {
+    return [... middlewares = std::move(middlewares)](const HttpRequest& req, HttpResponse& resp) {
+        return (MiddlewareDetail::invoke(middlewares, req, resp) && ...);
+    };
+}
+
+// 路由级中间件：before 在全局前置中间件之后、微缓存 / 隔离舱 / 处理函数之前执行，短路时跳过处理函数；
+// after 在处理函数之后、全局后置中间件之前执行
+struct RouteMiddleware {
+    MiddlewarePipeline before;
+    MiddlewarePipeline after;
+
+    bool empty() const { return before.empty() && after.empty(); }
+};
+
+#endif // MIDDLEWARE_H
@@ -0,0 +1,64 @@
+#ifndef MYSQL_ASYNC_H
+#define MYSQL_ASYNC_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "coro.h"
+#include "mysql_connection.h"
+
+/**
+ * @brief reactor 线程上的非阻塞 MySQL 客户端
+ *        每个 SubReactor 线程持有自己的一组连接（只在本线程使用，无锁）；查询期间连接的 socket 注册在本 reactor 的
+ *        epoll 中，可读后在本线程恢复发起查询的协程，整个查询不占用工作线程
+ */
+class MySQLAsync {
+public:
+    // 租用的连接：析构时归还本线程的空闲列表；超时或网络错误后协议状态未知，调用 discard 关闭
+    class Lease {
+    public:
+        Lease() = default;
+        explicit Lease(std::unique_ptr<MySQLConnection> conn) : conn_(std::move(conn)) {}
+        Lease(Lease&&) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        MySQLConnection* get() const { return conn_.get(); }
+        MySQLConnection* operator->() const { return conn_.get(); }
+        explicit operator bool() const { return conn_ != nullptr; }
+
+        void discard();
+
+        // 最近一条语句失败时的错误码（连接因该错误被关闭后仍可读取），成功为 0；
+        // 超时或结果集为空等没有服务端错误码的失败为 2000（CR_UNKNOWN_ERROR）
+        unsigned int errorCode() const { return error_; }
+
+    private:
+        friend class MySQLAsync;
+
+        std::unique_ptr<MySQLConnection> conn_;
+        unsigned int error_ = 0;
+    };
+
+    // 每个 reactor 的连接上限、单次等待超时与排队取连接的超时（启动 reactor 前调用）
+    static void init(int pool_size, std::chrono::milliseconds io_timeout, std::chrono::milliseconds acquire_timeout);
+
+    // 取本线程的空闲连接：不足上限时在线程池上建立新连接（握手阻塞，只在扩容时发生），已达上限则排队等待；
+    // 排队超时、建连失败或数据库熔断打开时返回空 Lease
+    static Coro::Task<Lease> acquire();
+
+    // 执行不返回结果集的语句；失败时错误码见 conn.errorCode()（如 1062 唯一索引冲突）
+    static Coro::Task<bool> exec(Lease& conn, const std::string& sql);
+    // 执行查询并取回结果集，结果经 conn->fetchRow() 读取；失败（不同于没有结果行）时错误码见 conn.errorCode()
+    static Coro::Task<bool> query(Lease& conn, const std::string& sql);
+
+private:
+    static Coro::Task<bool> run(Lease& conn, const std::string& sql, bool store);
+
+    static inline int pool_size_ {4};
+    static inline std::chrono::milliseconds io_timeout_ {30000};
+    static inline std::chrono::milliseconds acquire_timeout_ {1000};
+};
+
+#endif // MYSQL_ASYNC_H
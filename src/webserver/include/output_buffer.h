@@ -7,14 +7,24 @@
 
 #include <fcntl.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 
 enum class WriteResult {
     SUCCESS,      // 数据已全部写完
     CONTINUE,     // 写未完成，需继续监听 EPOLLOUT
+    PROGRESS,     // 本次请求的数据已全部写入，socket 可能仍可写，可在预算内继续写
     ERROR         // 发生不可恢复错误（如 EPIPE），应关闭连接
 };
 
+// 文件段：先发送 prefix（如 multipart 分段头），再发送文件 [offset, offset + length)
+struct FileSegment {
+    std::string_view prefix;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
 class OutputBuffer {
 
 public:
@@ -33,42 +43,113 @@ public:
     void reset();
 
     // 统一的设置接口（应用层只传参数，I/O 层决定如何处理）
+    // file_fd >= 0 时直接使用已打开的文件并接管其所有权，否则按 file_path 打开
     void set_response_with_mmap(const char* response_data, size_t response_len,
-                                const std::string& file_path, size_t file_offset, size_t file_size);
-    
+                                const std::string& file_path, size_t file_offset, size_t file_size,
+                                int file_fd = -1);
+
     void set_response_with_sendfile(const char* response_data, size_t response_len,
-                                    const std::string& file_path, size_t file_offset, size_t file_size);
+                                    const std::string& file_path, size_t file_offset, size_t file_size,
+                                    int file_fd = -1);
+
+    // 多文件段版本（multipart/byteranges），segments 与 trailer 指向的内存需在发送完成前保持有效
+    void set_response_with_mmap(const char* response_data, size_t response_len, const std::string& file_path,
+                                const std::vector<FileSegment>& segments, std::string_view trailer,
+                                int file_fd = -1);
+
+    void set_response_with_sendfile(const char* response_data, size_t response_len, const std::string& file_path,
+                                    const std::vector<FileSegment>& segments, std::string_view trailer,
+                                    int file_fd = -1);
+
+    // header 与独立的内存响应体分两块 writev 发送，body 需在发送完成前保持有效
+    void set_response_with_body(const char* response_data, size_t response_len, const char* body, size_t body_len);
+
+    // 异步预读：待发送文件窗口不在 page cache 时，返回需要预读的区间
+    struct ReadaheadHint {
+        off_t offset = 0;
+        size_t length = 0;
+    };
+
+    // 检查下一段文件数据 [offset, offset + window) 是否已逐页常驻内存（mincore；sendfile 模式临时映射窗口后检查）
+    // 文件数据总量小于 min_file_bytes 时直接返回 false，小文件不付出额外的系统调用
+    bool needs_readahead(size_t window, size_t min_file_bytes, ReadaheadHint& hint);
+
+    // 预读完成后标记该窗口已常驻，写入将被限制在已确认的窗口内，避免在 reactor 线程上缺页阻塞
+    void mark_resident(const ReadaheadHint& hint);
+
+    // 预读完成后重新探测窗口是否已全部常驻
+    bool window_resident(const ReadaheadHint& hint) const;
+
+    // 复制正在发送的文件 fd（调用方负责关闭），供 I/O 线程预读同一个 inode；没有文件时返回 -1
+    int dup_file_fd() const;
+
+    // 大文件顺序读提示：POSIX_FADV_SEQUENTIAL / MADV_SEQUENTIAL，并随发送进度提前 prefetch_window 字节预读
+    void enable_sequential(size_t prefetch_window);
 
     // 尝试写一次
     WriteResult write_to(int fd);
 
     // 是否还有数据未发送？
     bool pending() const { return bytes_to_send_ > 0; }
+    size_t bytes_sent() const { return bytes_have_sent_; }
 
     // 清理 mmap 资源
     void unmap_if_needed();
-    
+
     // 清理sendfile文件描述符
     void close_file_if_needed();
 
 private:
-    struct iovec iov_[2];
-    int iov_count_ = 0;
+    // 发送单元：内存块（header / 分段头 / mmap 后的文件数据）或待 sendfile 的文件区间
+    struct Chunk {
+        const char* data = nullptr;
+        size_t len = 0;
+        off_t file_offset = 0;
+        bool from_file = false;    // 通过 sendfile 发送
+        bool file_backed = false;  // 数据来自文件（sendfile 区间或 mmap 映射区）
+    };
+
+    static constexpr int kMaxIov = 64; // 单次 writev 聚合的最大内存块数
+
+    void setup_mmap(const char* response_data, size_t response_len, const std::string& file_path,
+                    const FileSegment* segments, size_t count, std::string_view trailer, int file_fd);
+    void setup_sendfile(const char* response_data, size_t response_len, const std::string& file_path,
+                        const FileSegment* segments, size_t count, std::string_view trailer, int file_fd);
+    void begin(const char* response_data, size_t response_len);
+    void push_memory(const char* data, size_t len);
+    void push_file(off_t offset, size_t len);
+    void push_mapped(const char* data, size_t len, off_t offset);
+    void consume(size_t n);
+    size_t writable_len(const Chunk& chunk) const;
+    bool probe_mincore(const char* data, size_t len) const;
+    bool probe_file(off_t offset, size_t len) const;
+    void prefetch_ahead();
+
+    std::vector<Chunk> chunks_;
+    size_t chunk_index_ = 0;
 
     size_t bytes_have_sent_ = 0;     // 已发送总字节数
     size_t bytes_to_send_ = 0;       // 待发送总字节数
-    size_t response_bound_ = 0;           // header 长度（即 iov[0].iov_len 初始值）
+    size_t file_bytes_ = 0;          // 文件数据总字节数
+
+    // 已确认常驻 page cache 的文件区间 [resident_from_, resident_until_)
+    bool residency_tracked_ = false;
+    off_t resident_from_ = 0;
+    off_t resident_until_ = 0;
+
+    // 渐进式预读：发送位置越过 prefetch_next_ 时对下一窗口发起异步预读
+    size_t prefetch_window_ = 0;
+    off_t prefetch_next_ = 0;
 
     // mmap 模式
     void* file_address_ = nullptr;
+    size_t map_offset_ = 0; // 映射区起点对应的文件偏移（页对齐）
     size_t mmap_size_ = 0;  // mmap 的原始大小，用于 munmap
     bool should_unmap_ = false;
-    
+
     // sendfile 模式
     int file_fd_ = -1;
-    off_t file_offset_ = 0;
-    size_t file_remain_ = 0;
-    
+
     bool use_sendfile_ = false;  // true=sendfile, false=mmap
     bool close_connection_ = false;
 };
@@ -0,0 +1,58 @@
+#ifndef WEBSERVER_PATH_UTIL_H
+#define WEBSERVER_PATH_UTIL_H
+
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+/**
+ * @brief 请求路径处理：URI 解码 + 词法规范化，以及在 docroot 目录 fd 之下打开文件
+ *        越界由内核（openat2 RESOLVE_BENEATH）保证，不再逐级 lstat
+ */
+namespace PathUtil {
+    // 就地百分号解码并规范化（合并 //，消去 . 与 ..）；非法编码、%00 或 .. 越过根目录时返回 false
+    bool normalize(std::string& path);
+
+    // 以 dirfd 为根打开相对路径（path 可以 / 开头），禁止越出 dirfd 与 /proc 魔法链接
+    // 失败返回 -1 并保留 errno：ENOENT 不存在，EXDEV/ELOOP 试图越界
+    int openBeneath(int dirfd, std::string_view path, int flags);
+}
+
+// 独占的文件描述符，析构时关闭
+class UniqueFd {
+public:
+    UniqueFd() = default;
+    explicit UniqueFd(int fd) : fd_(fd) {}
+    ~UniqueFd() { reset(); }
+
+    UniqueFd(const UniqueFd&) = delete;
+    UniqueFd& operator=(const UniqueFd&) = delete;
+    UniqueFd(UniqueFd&& other) noexcept : fd_(other.release()) {}
+    UniqueFd& operator=(UniqueFd&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    int get() const { return fd_; }
+    explicit operator bool() const { return fd_ >= 0; }
+
+    int release() {
+        int fd = fd_;
+        fd_ = -1;
+        return fd;
+    }
+
+    void reset(int fd = -1) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = fd;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+#endif // WEBSERVER_PATH_UTIL_H
@@ -4,49 +4,104 @@
 #include "http_request.h"
 #include "http_response.h"
 #include "mime_types.h"
+#include "compression.h"
+#include "asset_fingerprint.h"
+#include "path_util.h"
 #include "logger.h"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <filesystem>
 #include <ctime>
 #include <sstream>
 #include <iomanip>
-#include <regex>
+#include <sys/stat.h>
 
 class HttpRequest;
 class HttpResponse;
 
 class StaticFileController {
 public:
-    // 处理静态文件请求（供路由系统调用的接口）
+    // 处理静态文件请求（供路由系统调用的接口），包括指纹别名 /static/<hash>/<name>
     static void serveStaticFile(const HttpRequest& req, HttpResponse& resp);
     
-    // 处理静态文件请求（内部实现）
-    static void serveFile(const std::string& filepath, HttpResponse& resp);
+    // 控制器发送页面：name 为相对 docroot 的路径（如 "/log.html"）；与静态资源相同地经过资源包、元数据缓存与内容协商，
+    // 按 no-cache 每次验证；POST 的结果页只做内容协商，不处理条件请求与 Range
+    static void serveFile(const HttpRequest& req, const std::string& name, HttpResponse& resp);
+
+    // 启动阶段：为 docroot 资源计算内容指纹并改写页面引用
+    static void enableFingerprints() { AssetFingerprint::Instance().build(kDocRoot); }
+
+    // 文本类静态资源的压缩策略：enabled=false 时只发送原始文件；小于 min_bytes 的文件不做动态压缩（仍可使用预压缩文件）
+    static void set_compression(bool enabled, size_t min_bytes) {
+        compression_enabled_ = enabled;
+        compress_min_bytes_ = min_bytes;
+    }
+
+    // 文件元数据（ETag、预序列化头部）在每个线程内的缓存有效期；HEAD 与条件请求命中时不打开文件，0 关闭
+    static void set_meta_ttl(int64_t ms) { meta_ttl_ms_ = ms; }
 
 private:
     static constexpr const char* kDocRoot = PROJECT_ROOT_DIR "/root";
+    static constexpr std::string_view kDefaultCacheControl = "public, max-age=3600";
+    static constexpr std::string_view kImmutableCacheControl = "public, max-age=31536000, immutable";
 
-    // 解析 HTTP 日期格式
-    static std::time_t parseHttpDate(const std::string& date) {
-        std::tm tm = {};
-        std::istringstream ss(date);
-        ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S GMT");
-        return std::mktime(&tm);
-    }
+    static inline bool compression_enabled_ = true;
+    static inline size_t compress_min_bytes_ = 1024;
+    static inline int64_t meta_ttl_ms_ = 1000;
+
+    // 选中的压缩变体：预压缩旁路文件（sidecar_path 非空）或压缩缓存中的结果（blob 非空）
+    struct EncodedVariant {
+        Compression::Encoding encoding = Compression::Encoding::IDENTITY;
+        std::string sidecar_path;
+        UniqueFd sidecar_fd;
+        size_t sidecar_size = 0;
+        std::shared_ptr<const std::string> blob;
+    };
+
+    // 按 uri（相对 docroot）发送资源，cacheControl 决定缓存策略
+    static void serveAsset(const HttpRequest& req, const std::string& uri, std::string_view cacheControl,
+                           HttpResponse& resp);
+
+    // 发送改写过资源引用的页面（按 Accept-Encoding 选择启动时压缩好的变体），POST 不处理条件请求
+    static void servePage(const AssetFingerprint::Page& page, const HttpRequest& req, HttpResponse& resp);
+
+    // HEAD / 条件请求命中元数据缓存时只用预序列化头部响应（304 或无响应体的 200），不打开文件；未命中返回 false
+    static bool serveFromMeta(const HttpRequest& req, const std::string& uri, std::string_view cacheControl,
+                              HttpResponse& resp);
+
+    // 资源包命中时直接从映射区响应（含条件请求与单段 Range），不触发任何文件系统调用；未命中返回 false
+    static bool servePacked(const HttpRequest& req, const std::string& uri, std::string_view cacheControl,
+                            HttpResponse& resp);
+
+    // 按 Accept-Encoding 偏好依次尝试 .zst/.gz 旁路文件与压缩缓存，缓存未命中时提交后台压缩并本次返回原始文件
+    static EncodedVariant selectVariant(const HttpRequest& req, const std::string& uri, const std::string& filepath,
+                                        const struct stat& st);
+
+    // docroot 目录 fd（O_PATH），首次使用时打开，所有静态文件都相对它打开
+    static int docRootFd();
+
+    // 解析 IMF-fixdate（"Sun, 06 Nov 1994 08:49:37 GMT"），按 UTC 计算；格式不符返回 -1
+    static std::time_t parseHttpDate(std::string_view date);
 
     // 生成 ETag
-    static std::string generateETag(const std::filesystem::file_time_type& mtime, 
-                                  std::uintmax_t size) {
-        auto timePoint = std::chrono::clock_cast<std::chrono::system_clock>(mtime);
-        auto timestamp = std::chrono::system_clock::to_time_t(timePoint);
-        return "\"" + std::to_string(timestamp) + "-" + std::to_string(size) + "\"";
+    static std::string generateETag(std::time_t mtime, std::uintmax_t size) {
+        return "\"" + std::to_string(mtime) + "-" + std::to_string(size) + "\"";
+    }
+
+    // 压缩变体使用不同的强 ETag："123-456" -> "123-456-gzip"
+    static std::string variantETag(const std::string& etag, Compression::Encoding encoding) {
+        if (encoding == Compression::Encoding::IDENTITY || etag.size() < 2) {
+            return etag;
+        }
+        return etag.substr(0, etag.size() - 1) + "-" + std::string(Compression::name(encoding)) + "\"";
     }
 
-    // 处理范围请求
-    static void handleRangeRequest(const std::string& rangeHeader, 
+    // 处理范围请求（单段 206 / 多段 multipart/byteranges / 416），语法无效时保持 200 整文件响应
+    static void handleRangeRequest(std::string_view rangeHeader,
                                  std::uintmax_t fileSize,
                                  const std::string& filepath,
-                                 const HttpRequest& req,
+                                 std::string_view mimeType,
                                  HttpResponse& resp);
 };
 
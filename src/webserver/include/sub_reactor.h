@@ -6,6 +6,8 @@
 #define SUB_REACTOR_H
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -15,8 +17,21 @@
 #include <sys/epoll.h>
 
 #include "http_conn.h"
+#include "metrics.h"
 #include "time_wheel.h"
 
+class SubReactor;
+
+// 其他线程向 reactor 交还结果的入口：线程池任务 / 等待回调持有它而不是 SubReactor*，
+// reactor 析构时置空，之后的投递直接丢弃，不会访问已销毁的 reactor
+struct ReactorLink {
+    std::mutex mutex;
+    SubReactor* reactor = nullptr;
+
+    // reactor 已销毁时返回 false，task 不执行
+    bool queueInLoop(std::function<void()> task);
+};
+
 class SubReactor {
 public:
     SubReactor(int id);
@@ -32,6 +47,21 @@ public:
     // 获取当前连接数（用于负载均衡）
     size_t getConnectionCount() const { return connection_count_.load(); }
 
+    // 投递任务到本 reactor 线程执行（线程安全）；调用方可能比 reactor 活得久（线程池任务等）时经 link() 投递
+    void queueInLoop(std::function<void()> task);
+    const std::shared_ptr<ReactorLink>& link() const { return link_; }
+
+    // 当前线程所属的 SubReactor（非 reactor 线程返回 nullptr）
+    static SubReactor* current() { return tls_current_; }
+
+    // 以下仅在本 reactor 线程调用（协程等待者使用）
+    // delay 后在本线程执行 cb，精度为时间轮刻度
+    void runAfter(std::chrono::milliseconds delay, std::function<void()> cb);
+    // fd 上出现 events 后注销并在本线程执行 cb(revents)，一次性；返回本次等待的编号
+    uint64_t watchFd(int fd, uint32_t events, std::function<void(uint32_t)> cb);
+    // 撤销仍在等待的编号为 id 的注册（超时），已触发或已被新的等待替换时返回 false
+    bool unwatchFd(int fd, uint64_t id);
+
 private:
     void eventLoop();
     
@@ -41,10 +71,35 @@ private:
     
     void handleNewConnection();
 
+    void doPendingTasks();
+
+    // I/O 预算耗尽的连接放入就绪队列，本轮其他事件处理完后再恢复（无需再经过 epoll）
+    void pushReady(int fd, bool write);
+    void runReadyList();
+
+    // 连接写入因冷文件挂起时，把预读任务交给 I/O 线程池，完成后回到本线程恢复写入
+    void scheduleReadahead(int fd);
+
+    // 移交出连接的请求（协程路由 / 等待微缓存），完成后经 queueInLoop 回到本线程；按连接代数校验 fd 槽位未被复用
+    void dispatchOffload(int fd, std::unique_ptr<HttpConnection::OffloadJob> job);
+
+    // 协程路由：在本线程启动处理协程，结束后同样按连接代数校验再交还
+    void dispatchCoroutine(int fd, std::shared_ptr<HttpConnection::OffloadJob> job);
+
+    // 微缓存：同一 key 正在计算时挂起，结果就绪后回到本线程应答
+    void dispatchCacheWait(int fd, std::shared_ptr<HttpConnection::OffloadJob> job);
+
+    // 微缓存后台刷新：与普通请求一样在本线程执行（本轮已准备好的应答先发出），结果只写入缓存，不交还任何连接
+    void dispatchRevalidation(std::unique_ptr<HttpConnection::OffloadJob> job);
+
+    // 协程等待的外部 fd 就绪
+    void handleWatched(int fd, uint32_t revents);
+
 private:
     int id_;            // SubReactor ID
     int epoll_fd_;      // 独立的 epoll 实例
     int wakeup_fd_;     // eventfd，用于唤醒 epoll_wait
+    std::shared_ptr<ReactorLink> link_;
     
     std::atomic<bool> running_{false};
     std::unique_ptr<std::thread> thread_;
@@ -57,6 +112,31 @@ private:
     // 定时器管理（每个 SubReactor 独立的 TimerWheel - 无锁！）
     TimerWheel timer_wheel_;
     std::unordered_map<int, std::shared_ptr<TimerWheel::Timer>> timer_handles_;
+
+    // reactor 本地就绪队列（仅本线程访问，无锁）
+    struct ReadyEntry {
+        int fd;
+        uint64_t generation;
+        bool write;
+    };
+    std::vector<ReadyEntry> ready_list_;
+    std::vector<ReadyEntry> ready_running_;
+
+    // 协程等待中的外部 fd（仅本线程访问）
+    struct Watcher {
+        uint64_t id;
+        std::function<void(uint32_t)> cb;
+    };
+    std::unordered_map<int, Watcher> watchers_;
+    uint64_t watch_seq_ {0};
+    static inline thread_local SubReactor* tls_current_ {nullptr};
+
+    // metrics
+    Metrics::Histogram& loop_us_;
+    Metrics::Counter& read_budget_exhausted_;
+    Metrics::Counter& write_budget_exhausted_;
+    Metrics::Counter& offload_stale_;
+    Metrics::Counter& coroutine_total_;
     
     // 待添加的新连接队列
     struct PendingConnection {
@@ -64,10 +144,8 @@ private:
         sockaddr_in addr;
     };
     std::queue<PendingConnection> pending_connections_;
-    std::mutex pending_mutex_;  // 保护 pending_connections_
-
-    // config
-    bool use_thread_pool_ {false};
+    std::vector<std::function<void()>> pending_tasks_;
+    std::mutex pending_mutex_;  // 保护 pending_connections_ 与 pending_tasks_
 };
 
 #endif // SUB_REACTOR_H
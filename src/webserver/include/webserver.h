@@ -7,7 +7,6 @@
 
 
 #include <string>
-#include <unordered_set>
 #include <memory>
 #include <vector>
 
@@ -26,6 +25,8 @@ public:
 
 private:
     void acceptConnections();
+    void handleSignals();
+    void loadAssetPack();
 
     void initLogger();
     void initEpoll();
@@ -41,7 +42,9 @@ private:
 
 private:
     int server_fd_;
-    int epoll_fd_;  // MainReactor 的 epoll（只监听 server_fd）
+    int epoll_fd_;  // MainReactor 的 epoll（监听 server_fd 与 signal_fd）
+    int signal_fd_ = -1;  // SIGHUP：重新加载资源包
+    std::string asset_pack_path_;
     std::string host_;
     int port_;
 
@@ -51,9 +54,6 @@ private:
 
     // MainReactor 的独立 TimerWheel（虽然目前只管理 accept，但保持架构一致）
     TimerWheel timer_wheel_;
-
-    // Debug
-    std::unordered_set<std::string> client_ips_;
 };
 
 
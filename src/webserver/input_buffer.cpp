@@ -14,12 +14,18 @@ bool InputBuffer::read_lt(int fd) {
     return n == 0 ? false : (errno == EAGAIN || errno == EWOULDBLOCK);
 }
 
-bool InputBuffer::read_et(int fd) {
+bool InputBuffer::read_et(int fd, size_t budget_bytes, int budget_iterations) {
     bool success = true;
-    while (true) {
+    size_t total = 0;
+    for (int iterations = 0;; ++iterations) {
+        if (iterations >= budget_iterations || total >= budget_bytes) {
+            budget_exhausted_ = true; // 预算耗尽，剩余数据由 reactor 就绪队列稍后继续读
+            break;
+        }
         ssize_t n = recv(fd, write_ptr(), writable_bytes(), 0);
         if (n > 0) {
             has_written(n);
+            total += n;
             continue; // 继续读直到无数据
         }
         if (n == 0) {
@@ -65,7 +71,9 @@ bool InputBuffer::check_peer_fin(int fd) {
     return false;
 }
 
-bool InputBuffer::read_from(int fd, bool use_edge_trigger, bool graceful_closing) {
+bool InputBuffer::read_from(int fd, bool use_edge_trigger, bool graceful_closing,
+                            size_t budget_bytes, int budget_iterations) {
+    budget_exhausted_ = false;
     // 优雅关闭状态：只检查对端 FIN
     if (graceful_closing) {
         return check_peer_fin(fd);
@@ -77,5 +85,5 @@ bool InputBuffer::read_from(int fd, bool use_edge_trigger, bool graceful_closing
         return false;
     }
 
-    return use_edge_trigger ? read_et(fd) : read_lt(fd);
+    return use_edge_trigger ? read_et(fd, budget_bytes, budget_iterations) : read_lt(fd);
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "micro_cache.h"
+#include "http_request.h"
+
+#include <functional>
+
+namespace {
+    bool cacheable(const HttpResponse& resp) {
+        if (resp.status() != HttpStatus::OK || resp.has_header("Set-Cookie")) {
+            return false;
+        }
+        const std::string* cache_control = resp.header("Cache-Control");
+        return !cache_control || (cache_control->find("no-store") == std::string::npos &&
+                                  cache_control->find("private") == std::string::npos);
+    }
+
+    size_t footprint(const std::string& key, const MicroCache::Entry& entry) {
+        return key.size() + entry.headers.size() + entry.body.size() + 128;
+    }
+}
+
+void MicroCache::Flight::wait(Waiter waiter) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!done_) {
+        waiters_.push_back(std::move(waiter));
+        return;
+    }
+    EntryPtr result = result_;
+    lock.unlock();
+    waiter(result);
+}
+
+void MicroCache::Flight::finish(EntryPtr result) {
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        result_ = std::move(result);
+        waiters.swap(waiters_);
+    }
+    for (auto& waiter : waiters) {
+        waiter(result_);
+    }
+}
+
+MicroCache::Ticket& MicroCache::Ticket::operator=(Ticket&& other) noexcept {
+    if (this != &other) {
+        if (flight_) {
+            MicroCache::Instance().finish(*this, nullptr);
+        }
+        key_ = std::move(other.key_);
+        policy_ = other.policy_;
+        flight_ = std::move(other.flight_);
+    }
+    return *this;
+}
+
+MicroCache::Ticket::~Ticket() {
+    if (flight_) {
+        MicroCache::Instance().finish(*this, nullptr);
+    }
+}
+
+void MicroCache::Ticket::complete(HttpResponse& resp) {
+    if (flight_) {
+        MicroCache::Instance().finish(*this, &resp);
+    }
+}
+
+MicroCache::MicroCache()
+    : hits_(Metrics::counter("micro_cache_hit_total")),
+      stale_hits_(Metrics::counter("micro_cache_stale_hit_total")),
+      misses_(Metrics::counter("micro_cache_miss_total")),
+      coalesced_(Metrics::counter("micro_cache_coalesced_total")),
+      stale_on_error_(Metrics::counter("micro_cache_stale_on_error_total")),
+      bytes_gauge_(Metrics::counter("micro_cache_bytes")) {}
+
+MicroCache& MicroCache::Instance() {
+    static MicroCache instance;
+    return instance;
+}
+
+void MicroCache::init(size_t budget_bytes) {
+    shard_budget_ = budget_bytes / kShards;
+}
+
+std::string MicroCache::makeKey(const HttpRequest& req, const Policy& policy) {
+    std::string key = req.method() == HttpRequest::Method::POST ? "POST " : "GET ";
+    key += req.uri();
+    auto query = req.headers().find("Query-String");
+    if (query != req.headers().end()) {
+        key += '?';
+        key += query->second;
+    }
+    for (const auto& name : policy.vary) {
+        key += '\n';
+        key += name;
+        key += ':';
+        auto it = req.headers().find(name);
+        if (it != req.headers().end()) {
+            key += it->second;
+        }
+    }
+    return key;
+}
+
+MicroCache::Shard& MicroCache::shardOf(const std::string& key) {
+    return shards_[std::hash<std::string> {}(key) % kShards];
+}
+
+MicroCache::Lookup MicroCache::lookup(const HttpRequest& req, const Policy& policy, HttpResponse& resp,
+                                      std::shared_ptr<Flight>& flight, Ticket& ticket) {
+    if (shard_budget_ == 0) {
+        return Lookup::Compute; // 未启用：不发 ticket，照常处理
+    }
+
+    std::string key = makeKey(req, policy);
+    auto now = std::chrono::steady_clock::now();
+    auto& shard = shardOf(key);
+    EntryPtr entry;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            auto age = now - it->second.entry->stored;
+            if (age < policy.ttl + policy.stale_while_revalidate) {
+                entry = it->second.entry;
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+                // 过期但仍可用：没有进行中的计算时由本请求发起后台刷新
+                if (age >= policy.ttl && !shard.flights.contains(key)) {
+                    ticket.key_ = key;
+                    ticket.policy_ = &policy;
+                    ticket.flight_ = std::make_shared<Flight>();
+                    shard.flights.emplace(key, ticket.flight_);
+                }
+                (age < policy.ttl ? hits_ : stale_hits_).add();
+            }
+        }
+
+        if (!entry) {
+            auto in_flight = shard.flights.find(key);
+            if (in_flight != shard.flights.end()) {
+                flight = in_flight->second;
+                coalesced_.add();
+                return Lookup::Wait;
+            }
+            ticket.key_ = std::move(key);
+            ticket.policy_ = &policy;
+            ticket.flight_ = std::make_shared<Flight>();
+            shard.flights.emplace(ticket.key_, ticket.flight_);
+            misses_.add();
+            return Lookup::Compute;
+        }
+    }
+
+    serve(entry, resp);
+    return Lookup::Served;
+}
+
+void MicroCache::serve(const EntryPtr& entry, HttpResponse& resp) {
+    resp.set_status(entry->status);
+    resp.set_raw_headers(entry->headers, entry);
+    resp.set_external_body(entry->body, entry);
+    resp.set_handled();
+}
+
+void MicroCache::finish(Ticket& ticket, HttpResponse* resp) {
+    auto flight = std::move(ticket.flight_);
+    const Policy& policy = *ticket.policy_;
+    bool failed = !resp || static_cast<int>(resp->status()) >= 500;
+
+    EntryPtr result;
+    std::string headers;
+    if (resp && resp->export_headers(headers)) {
+        auto body = resp->body_view();
+        result = std::make_shared<const Entry>(Entry {resp->status(), std::move(headers), std::string(body),
+                                                      std::chrono::steady_clock::now()});
+    }
+
+    EntryPtr stale;
+    auto& shard = shardOf(ticket.key_);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.flights.find(ticket.key_);
+        if (it != shard.flights.end() && it->second == flight) {
+            shard.flights.erase(it);
+        }
+        if (failed) {
+            auto cached = shard.entries.find(ticket.key_);
+            if (cached != shard.entries.end() &&
+                std::chrono::steady_clock::now() - cached->second.entry->stored < policy.ttl + policy.stale_if_error) {
+                stale = cached->second.entry;
+            }
+        } else if (result && cacheable(*resp)) {
+            insertLocked(shard, ticket.key_, result);
+        }
+    }
+
+    if (stale) {
+        // 计算失败：本请求与等待者都改用旧响应
+        stale_on_error_.add();
+        result = stale;
+        if (resp) {
+            bool keep_alive = resp->keep_alive();
+            resp->reset();
+            resp->set_keep_alive(keep_alive);
+            serve(stale, *resp);
+        }
+    }
+    flight->finish(std::move(result));
+}
+
+void MicroCache::insertLocked(Shard& shard, const std::string& key, EntryPtr entry) {
+    size_t size = footprint(key, *entry);
+    if (size > shard_budget_) {
+        return;
+    }
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        shard.bytes -= footprint(key, *it->second.entry);
+        total_bytes_.fetch_sub(footprint(key, *it->second.entry), std::memory_order_relaxed);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        it->second.entry = std::move(entry);
+    } else {
+        shard.lru.push_front(key);
+        shard.entries.emplace(key, Slot {std::move(entry), shard.lru.begin()});
+    }
+    shard.bytes += size;
+    total_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+    while (shard.bytes > shard_budget_ && shard.lru.size() > 1) {
+        auto victim = shard.entries.find(shard.lru.back());
+        size_t victim_size = footprint(victim->first, *victim->second.entry);
+        shard.bytes -= victim_size;
+        total_bytes_.fetch_sub(victim_size, std::memory_order_relaxed);
+        shard.entries.erase(victim);
+        shard.lru.pop_back();
+    }
+    bytes_gauge_.set(total_bytes_.load(std::memory_order_relaxed));
+}
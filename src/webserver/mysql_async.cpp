@@ -0,0 +1,219 @@
+#include "mysql_async.h"
+#include "logger.h"
+#include "metrics.h"
+#include "mysql_conn_pool.h"
+#include "sub_reactor.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace {
+    constexpr unsigned int kUnknownError = 2000; // CR_UNKNOWN_ERROR：超时 / 没有结果集等没有服务端错误码的失败
+
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        std::unique_ptr<MySQLConnection> conn; // 归还的连接；为空表示有连接被丢弃，名额空出可以新建
+        bool done = false;                     // 已被唤醒或已超时，另一方不再处理
+        bool timed_out = false;
+    };
+
+    // 本 reactor 线程的连接，只在本线程访问
+    struct LocalPool {
+        std::vector<std::unique_ptr<MySQLConnection>> idle;
+        std::deque<std::shared_ptr<Waiter>> waiters;
+        int total = 0; // 已建立（含租出、握手中）的连接数
+
+        LocalPool() { mysql_thread_init(); }
+
+        ~LocalPool() {
+            idle.clear();
+            mysql_thread_end();
+        }
+    };
+
+    thread_local LocalPool tls_pool;
+
+    // 定时器持有等待状态的共享所有权：先唤醒的一方置 done，另一方不再访问协程
+    struct WaitAwaiter {
+        std::shared_ptr<Waiter> waiter = std::make_shared<Waiter>();
+        std::chrono::milliseconds timeout;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            waiter->handle = h;
+            tls_pool.waiters.push_back(waiter);
+            if (timeout.count() > 0) {
+                Coro::detail::currentReactor().runAfter(timeout, [w = waiter]() {
+                    if (w->done) {
+                        return;
+                    }
+                    w->done = true;
+                    w->timed_out = true;
+                    std::erase(tls_pool.waiters, w);
+                    w->handle.resume();
+                });
+            }
+        }
+
+        std::shared_ptr<Waiter> await_resume() noexcept { return std::move(waiter); }
+    };
+
+    // 交给最早排队的协程，经 queueInLoop 恢复，不在归还方的调用栈里嵌套执行
+    void wakeWaiter(std::unique_ptr<MySQLConnection> conn) {
+        auto waiter = std::move(tls_pool.waiters.front());
+        tls_pool.waiters.pop_front();
+        waiter->done = true;
+        waiter->conn = std::move(conn);
+        Coro::detail::currentReactor().queueInLoop([h = waiter->handle]() { h.resume(); });
+    }
+
+    void giveBack(std::unique_ptr<MySQLConnection> conn) {
+        if (!conn) {
+            return;
+        }
+        if (!tls_pool.waiters.empty()) {
+            wakeWaiter(std::move(conn));
+        } else {
+            tls_pool.idle.push_back(std::move(conn));
+        }
+    }
+
+    // 反复调用非阻塞步骤直到完成；NOT_READY 时等待 socket 可读（语句很短，发送阶段一次写完，
+    // 之后都是在等服务端响应）
+    template<typename Step>
+    Coro::Task<net_async_status> drive(MySQLConnection& conn, std::chrono::milliseconds timeout, bool& timed_out,
+                                       Step step) {
+        net_async_status status;
+        while ((status = step()) == NET_ASYNC_NOT_READY) {
+            if (co_await Coro::readable(conn.socketFd(), timeout) == 0) {
+                LOG_WARN("[MySQLAsync] No response from server within {}ms", timeout.count());
+                timed_out = true;
+                co_return NET_ASYNC_ERROR;
+            }
+        }
+        co_return status;
+    }
+}
+
+MySQLAsync::Lease& MySQLAsync::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        giveBack(std::move(conn_));
+        conn_ = std::move(other.conn_);
+        error_ = other.error_;
+    }
+    return *this;
+}
+
+MySQLAsync::Lease::~Lease() {
+    giveBack(std::move(conn_));
+}
+
+void MySQLAsync::Lease::discard() {
+    if (!conn_) {
+        return;
+    }
+    conn_.reset();
+    --tls_pool.total;
+    if (!tls_pool.waiters.empty()) {
+        wakeWaiter(nullptr);
+    }
+}
+
+void MySQLAsync::init(int pool_size, std::chrono::milliseconds io_timeout, std::chrono::milliseconds acquire_timeout) {
+    pool_size_ = pool_size > 0 ? pool_size : 1;
+    io_timeout_ = io_timeout;
+    acquire_timeout_ = acquire_timeout;
+}
+
+Coro::Task<MySQLAsync::Lease> MySQLAsync::acquire() {
+    static Metrics::Histogram& wait_us = Metrics::histogram("mysql_async_acquire_wait_us");
+    static Metrics::Counter& timeouts = Metrics::counter("mysql_async_acquire_timeout_total");
+
+    // 熔断打开时不排队也不建连，直接失败
+    if (!MySQLConnectionPool::Instance().available()) {
+        co_return Lease();
+    }
+
+    auto& pool = tls_pool;
+    if (!pool.idle.empty()) {
+        auto conn = std::move(pool.idle.back());
+        pool.idle.pop_back();
+        co_return Lease(std::move(conn));
+    }
+
+    if (pool.total >= pool_size_) {
+        auto start = std::chrono::steady_clock::now();
+        auto waiter = co_await WaitAwaiter {.timeout = acquire_timeout_};
+        wait_us.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+        if (waiter->timed_out) {
+            LOG_WARN("[MySQLAsync] Connection acquire timed out after {}ms", acquire_timeout_.count());
+            timeouts.add();
+            co_return Lease();
+        }
+        if (waiter->conn) {
+            co_return Lease(std::move(waiter->conn));
+        }
+    }
+
+    // 先占名额，握手期间其他协程不会重复扩容
+    ++pool.total;
+    MySQLConnection* created = co_await Coro::offload([] {
+        return MySQLConnectionPool::Instance().createConnection();
+    });
+    if (!created) {
+        LOG_ERROR("[MySQLAsync] Failed to create MySQL connection");
+        --pool.total;
+        if (!pool.waiters.empty()) {
+            wakeWaiter(nullptr);
+        }
+        co_return Lease();
+    }
+    co_return Lease(std::unique_ptr<MySQLConnection>(created));
+}
+
+Coro::Task<bool> MySQLAsync::exec(Lease& conn, const std::string& sql) {
+    co_return co_await run(conn, sql, false);
+}
+
+Coro::Task<bool> MySQLAsync::query(Lease& conn, const std::string& sql) {
+    co_return co_await run(conn, sql, true);
+}
+
+Coro::Task<bool> MySQLAsync::run(Lease& conn, const std::string& sql, bool store) {
+    static Metrics::Histogram& query_us = Metrics::histogram("mysql_async_query_us");
+    static Metrics::Counter& discarded = Metrics::counter("mysql_async_discarded_total");
+
+    if (!conn) {
+        conn.error_ = kUnknownError;
+        co_return false;
+    }
+    conn.error_ = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    bool timed_out = false;
+    MySQLConnection& raw = *conn.get();
+    net_async_status status = co_await drive(raw, io_timeout_, timed_out, [&] { return raw.queryNonBlocking(sql); });
+    if (status == NET_ASYNC_COMPLETE && store) {
+        status = co_await drive(raw, io_timeout_, timed_out, [&] { return raw.storeResultNonBlocking(); });
+    }
+    query_us.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+
+    if (status == NET_ASYNC_ERROR) {
+        conn.error_ = !timed_out && raw.errorCode() != 0 ? raw.errorCode() : kUnknownError;
+        // SQL 错误不影响连接；超时或网络错误后连接处于未知的协议状态，不能再用
+        if (timed_out || MySQLConnection::isClientError(raw.errorCode())) {
+            discarded.add();
+            conn.discard();
+        }
+        co_return false;
+    }
+    if (store && raw.getResult() == nullptr) {
+        conn.error_ = raw.errorCode() != 0 ? raw.errorCode() : kUnknownError;
+        co_return false;
+    }
+    co_return true;
+}
@@ -3,7 +3,10 @@
 //
 
 #include "output_buffer.h"
+#include "path_util.h"
+#include <algorithm>
 #include <cerrno>
+#include <cstdint>
 #include <string>
 #include <cstring>
 #include "logger.h"
@@ -18,103 +21,216 @@
 void OutputBuffer::reset() {
     unmap_if_needed();
     close_file_if_needed();
-    
+
+    chunks_.clear();
+    chunk_index_ = 0;
     bytes_have_sent_ = 0;
     bytes_to_send_ = 0;
-    response_bound_ = 0;
-    iov_count_ = 0;
+    file_bytes_ = 0;
+    residency_tracked_ = false;
+    resident_from_ = 0;
+    resident_until_ = 0;
+    prefetch_window_ = 0;
+    prefetch_next_ = 0;
     file_address_ = nullptr;
+    map_offset_ = 0;
     mmap_size_ = 0;
     should_unmap_ = false;
-    file_offset_ = 0;
-    file_remain_ = 0;
     use_sendfile_ = false;
-    std::memset(iov_, 0, sizeof(iov_));
+}
+
+void OutputBuffer::begin(const char* response_data, size_t response_len) {
+    chunks_.clear();
+    chunk_index_ = 0;
+    bytes_to_send_ = 0;
+    bytes_have_sent_ = 0;
+    file_bytes_ = 0;
+    residency_tracked_ = false;
+    resident_from_ = 0;
+    resident_until_ = 0;
+    prefetch_window_ = 0;
+    prefetch_next_ = 0;
+    push_memory(response_data, response_len);
+}
+
+void OutputBuffer::push_memory(const char* data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    chunks_.push_back({data, len, 0, false, false});
+    bytes_to_send_ += len;
+}
+
+void OutputBuffer::push_file(off_t offset, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    chunks_.push_back({nullptr, len, offset, true, true});
+    bytes_to_send_ += len;
+    file_bytes_ += len;
+}
+
+void OutputBuffer::push_mapped(const char* data, size_t len, off_t offset) {
+    if (len == 0) {
+        return;
+    }
+    chunks_.push_back({data, len, offset, false, true});
+    bytes_to_send_ += len;
+    file_bytes_ += len;
+}
+
+void OutputBuffer::consume(size_t n) {
+    bytes_have_sent_ += n;
+    bytes_to_send_ -= n;
+
+    while (n > 0 && chunk_index_ < chunks_.size()) {
+        auto& chunk = chunks_[chunk_index_];
+        size_t step = n < chunk.len ? n : chunk.len;
+        chunk.len -= step;
+        if (chunk.file_backed) {
+            chunk.file_offset += static_cast<off_t>(step);
+        }
+        if (!chunk.from_file) {
+            chunk.data += step;
+        }
+        n -= step;
+        if (chunk.len == 0) {
+            ++chunk_index_;
+        }
+    }
+}
+
+void OutputBuffer::set_response_with_mmap(const char* response_data, size_t response_len,
+                                          const std::string& file_path, size_t file_offset, size_t file_size,
+                                          int file_fd) {
+    FileSegment segment {{}, file_offset, file_size};
+    setup_mmap(response_data, response_len, file_path, &segment, file_size > 0 ? 1 : 0, {}, file_fd);
+}
+
+void OutputBuffer::set_response_with_sendfile(const char* response_data, size_t response_len,
+                                              const std::string& file_path, size_t file_offset, size_t file_size,
+                                              int file_fd) {
+    FileSegment segment {{}, file_offset, file_size};
+    setup_sendfile(response_data, response_len, file_path, &segment, file_size > 0 ? 1 : 0, {}, file_fd);
 }
 
 void OutputBuffer::set_response_with_mmap(const char* response_data, size_t response_len,
-                                          const std::string& file_path, size_t file_offset, size_t file_size) {
+                                          const std::string& file_path, const std::vector<FileSegment>& segments,
+                                          std::string_view trailer, int file_fd) {
+    setup_mmap(response_data, response_len, file_path, segments.data(), segments.size(), trailer, file_fd);
+}
+
+void OutputBuffer::set_response_with_sendfile(const char* response_data, size_t response_len,
+                                              const std::string& file_path, const std::vector<FileSegment>& segments,
+                                              std::string_view trailer, int file_fd) {
+    setup_sendfile(response_data, response_len, file_path, segments.data(), segments.size(), trailer, file_fd);
+}
+
+void OutputBuffer::set_response_with_body(const char* response_data, size_t response_len,
+                                          const char* body, size_t body_len) {
     unmap_if_needed();
     close_file_if_needed();
     use_sendfile_ = false;
+    begin(response_data, response_len);
+    push_memory(body, body_len);
+}
 
-    iov_[0].iov_base = const_cast<char*>(response_data);
-    iov_[0].iov_len = response_len;
-    response_bound_ = response_len;
-    bytes_to_send_ = response_len;
-    bytes_have_sent_ = 0;
+void OutputBuffer::setup_mmap(const char* response_data, size_t response_len, const std::string& file_path,
+                              const FileSegment* segments, size_t count, std::string_view trailer, int file_fd) {
+    UniqueFd opened(file_fd);
+    unmap_if_needed();
+    close_file_if_needed();
+    use_sendfile_ = false;
+    begin(response_data, response_len);
 
-    // 如果有文件，进行 mmap
-    if (!file_path.empty() && file_size > 0) {
-        int fd = open(file_path.c_str(), O_RDONLY);
-        if (fd < 0) {
-            LOG_ERROR("Failed to open file for mmap: {}", file_path);
-            iov_count_ = 1;
-            return;
-        }
+    if (file_path.empty() || count == 0) {
+        return;
+    }
 
-        // mmap 的 offset 必须页对齐（通常 4KB）
-        static const size_t PAGE_SIZE = sysconf(_SC_PAGE_SIZE);  // 通常是 4096
-        size_t aligned_offset = (file_offset / PAGE_SIZE) * PAGE_SIZE;  // 向下对齐到页边界
-        size_t offset_in_page = file_offset - aligned_offset;  // 页内偏移
-        size_t map_size = offset_in_page + file_size;  // 需要 map 的总大小
-
-        void* addr = mmap(
-            nullptr, // 建议映射起始位置
-            map_size, // 映射字节数
-            PROT_READ, // PROT_WRITE | PROT_EXEC（加载可执行代码（如 .so 库）） | PROT_NONE
-            MAP_PRIVATE, // MAP_PRIVATE 私有写时复制，修改不影响原文件 | MAP_SHARED 共享映射，修改会同步到文件，用于进程间通信、修改文件 | MAP_ANONYMOUS
-            fd,
-            aligned_offset // 文件内偏移量
-            );
-        close(fd);  // mmap 后可关闭 fd
-
-        if (addr == MAP_FAILED) {
-            LOG_ERROR("mmap failed: {} (offset={}, aligned={}, map_size={})", 
-                      strerror(errno), file_offset, aligned_offset, map_size);
-            iov_count_ = 1;
-            return;
-        }
+    // 所有段共用一次映射：覆盖 [最小 offset, 最大 end)
+    size_t lo = SIZE_MAX;
+    size_t hi = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& seg = segments[i];
+        if (seg.length == 0) continue;
+        lo = std::min(lo, seg.offset);
+        hi = std::max(hi, seg.offset + seg.length);
+    }
+    if (hi == 0) {
+        return;
+    }
 
-        file_address_ = static_cast<char*>(addr);
-        mmap_size_ = map_size;  // 保存对齐后的大小用于 munmap
-        should_unmap_ = true;
+    if (!opened) {
+        opened.reset(open(file_path.c_str(), O_RDONLY | O_CLOEXEC));
+    }
+    int fd = opened.get();
+    if (fd < 0) {
+        LOG_ERROR("Failed to open file for mmap: {}", file_path);
+        return;
+    }
 
-        // iov[1] 指向实际需要发送的数据（跳过页内偏移）
-        iov_[1].iov_base = static_cast<char*>(addr) + offset_in_page;
-        iov_[1].iov_len = file_size;
-        iov_count_ = 2;
-        bytes_to_send_ += file_size;
-    } else {
-        iov_count_ = 1;
+    // mmap 的 offset 必须页对齐（通常 4KB）
+    static const size_t PAGE_SIZE = sysconf(_SC_PAGE_SIZE);  // 通常是 4096
+    size_t aligned_offset = (lo / PAGE_SIZE) * PAGE_SIZE;  // 向下对齐到页边界
+    size_t map_size = hi - aligned_offset;  // 需要 map 的总大小
+
+    void* addr = mmap(
+        nullptr, // 建议映射起始位置
+        map_size, // 映射字节数
+        PROT_READ, // PROT_WRITE | PROT_EXEC（加载可执行代码（如 .so 库）） | PROT_NONE
+        MAP_PRIVATE, // MAP_PRIVATE 私有写时复制，修改不影响原文件 | MAP_SHARED 共享映射，修改会同步到文件，用于进程间通信、修改文件 | MAP_ANONYMOUS
+        fd,
+        aligned_offset // 文件内偏移量
+        );
+    // mmap 后保留 fd：异步预读在 I/O 线程上 dup 它读盘，保证读的是本次打开的同一个 inode
+    file_fd_ = opened.release();
+
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("mmap failed: {} (offset={}, aligned={}, map_size={})",
+                  strerror(errno), lo, aligned_offset, map_size);
+        return;
+    }
+
+    file_address_ = addr;
+    map_offset_ = aligned_offset;
+    mmap_size_ = map_size;  // 保存对齐后的大小用于 munmap
+    should_unmap_ = true;
+
+    // 文件段直接指向映射区（跳过页内偏移），与 header 一起 writev
+    const char* base = static_cast<const char*>(addr);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& seg = segments[i];
+        push_memory(seg.prefix.data(), seg.prefix.size());
+        push_mapped(base + (seg.offset - aligned_offset), seg.length, static_cast<off_t>(seg.offset));
     }
+    push_memory(trailer.data(), trailer.size());
 }
 
-void OutputBuffer::set_response_with_sendfile(const char* response_data, size_t response_len,
-                                              const std::string& file_path, size_t file_offset, size_t file_size) {
+void OutputBuffer::setup_sendfile(const char* response_data, size_t response_len, const std::string& file_path,
+                                  const FileSegment* segments, size_t count, std::string_view trailer, int file_fd) {
+    UniqueFd opened(file_fd);
     unmap_if_needed();
     close_file_if_needed();
     use_sendfile_ = true;
+    begin(response_data, response_len);
 
-    iov_[0].iov_base = const_cast<char*>(response_data);
-    iov_[0].iov_len = response_len;
-    response_bound_ = response_len;
-    bytes_to_send_ = response_len;
-    bytes_have_sent_ = 0;
-    iov_count_ = 1;
-
-    // 如果有文件，打开 fd 准备 sendfile
-    if (!file_path.empty() && file_size > 0) {
-        file_fd_ = open(file_path.c_str(), O_RDONLY);
-        if (file_fd_ < 0) {
-            LOG_ERROR("Failed to open file for sendfile: {}", file_path);
-            return;
-        }
+    if (file_path.empty() || count == 0) {
+        return;
+    }
+
+    // 如果有文件，打开 fd 准备 sendfile（已打开则直接接管）
+    file_fd_ = opened ? opened.release() : open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd_ < 0) {
+        LOG_ERROR("Failed to open file for sendfile: {}", file_path);
+        return;
+    }
 
-        file_offset_ = static_cast<off_t>(file_offset);
-        file_remain_ = file_size;
-        bytes_to_send_ += file_size;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& seg = segments[i];
+        push_memory(seg.prefix.data(), seg.prefix.size());
+        push_file(static_cast<off_t>(seg.offset), seg.length);
     }
+    push_memory(trailer.data(), trailer.size());
 }
 
 WriteResult OutputBuffer::write_to(int fd) {
@@ -122,62 +238,50 @@ WriteResult OutputBuffer::write_to(int fd) {
         return WriteResult::SUCCESS;
     }
 
-    // 根据模式选择不同的发送方式
-    if (use_sendfile_) {
+    ssize_t n = 0;
+    size_t attempted = 0;
+    if (chunks_[chunk_index_].from_file) {
         LOG_DEBUG("[OutputBuffer] Sending using sendfile.");
-        // sendfile 模式
-        // 1. 先发送 header
-        if (bytes_have_sent_ < response_bound_) {
-            char* base = static_cast<char*>(iov_[0].iov_base);
-            size_t header_remain = response_bound_ - bytes_have_sent_;
-            ssize_t n = write(fd, base + bytes_have_sent_, header_remain);
-            
-            if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    return WriteResult::CONTINUE;
-                }
-                // 客户端主动断开
-                if (errno == EPIPE || errno == ECONNRESET) {
-                    LOG_DEBUG("[OutputBuffer] Client disconnected during header write");
-                    return WriteResult::ERROR;
-                }
-                LOG_ERROR("[OutputBuffer] write error: {}", strerror(errno));
-                return WriteResult::ERROR;
-            }
-            
-            bytes_have_sent_ += n;
-            bytes_to_send_ -= n;
-            
-            if (bytes_have_sent_ < response_bound_) {
+        // 文件区间：sendfile 零拷贝
+        auto& chunk = chunks_[chunk_index_];
+        off_t offset = chunk.file_offset;
+        attempted = writable_len(chunk);
+        n = sendfile(fd, file_fd_, &offset, attempted);
+
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 return WriteResult::CONTINUE;
             }
-        }
-
-        // 2. header 已发完，发送文件
-        if (file_fd_ >= 0 && file_remain_ > 0) {
-            ssize_t n = sendfile(fd, file_fd_, &file_offset_, file_remain_);
-            
-            if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    return WriteResult::CONTINUE;
-                }
-                // 客户端主动断开（正常情况，如视频播放器获取足够数据后断开）
-                if (errno == EPIPE || errno == ECONNRESET) {
-                    LOG_DEBUG("[OutputBuffer] Client disconnected during sendfile (EPIPE/ECONNRESET), errno={}", errno);
-                    return WriteResult::ERROR;
-                }
-                LOG_ERROR("[OutputBuffer] sendfile error: {}", strerror(errno));
+            // 客户端主动断开（正常情况，如视频播放器获取足够数据后断开）
+            if (errno == EPIPE || errno == ECONNRESET) {
+                LOG_DEBUG("[OutputBuffer] Client disconnected during sendfile (EPIPE/ECONNRESET), errno={}", errno);
                 return WriteResult::ERROR;
             }
-            
-            file_remain_ -= n;
-            bytes_to_send_ -= n;
-            bytes_have_sent_ += n;
+            LOG_ERROR("[OutputBuffer] sendfile error: {}", strerror(errno));
+            return WriteResult::ERROR;
+        }
+        if (n == 0) {
+            // 文件在发送过程中被截断，已无法满足 Content-Length
+            LOG_ERROR("[OutputBuffer] sendfile hit EOF early, file truncated?");
+            return WriteResult::ERROR;
         }
     } else {
-        LOG_DEBUG("[OutputBuffer] Sending using mmap.");
-        // mmap + writev 模式
-        ssize_t n = writev(fd, iov_, iov_count_);
+        LOG_DEBUG("[OutputBuffer] Sending using {}.", use_sendfile_ ? "writev" : "mmap");
+        // 连续的内存块（header、分段头、mmap 文件数据）聚合为一次 writev
+        struct iovec iov[kMaxIov];
+        int iov_count = 0;
+        for (size_t i = chunk_index_; i < chunks_.size() && iov_count < kMaxIov; ++i) {
+            if (chunks_[i].from_file) break;
+            iov[iov_count].iov_base = const_cast<char*>(chunks_[i].data);
+            iov[iov_count].iov_len = writable_len(chunks_[i]);
+            attempted += iov[iov_count].iov_len;
+            ++iov_count;
+            if (iov[iov_count - 1].iov_len < chunks_[i].len) {
+                break; // 超出已确认常驻的窗口，剩余部分等待下一次预读检查
+            }
+        }
+
+        n = writev(fd, iov, iov_count);
         if (n < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 return WriteResult::CONTINUE;
@@ -190,28 +294,184 @@ WriteResult OutputBuffer::write_to(int fd) {
             LOG_ERROR("[OutputBuffer] writev error: {}", strerror(errno));
             return WriteResult::ERROR;
         }
+    }
+
+    consume(static_cast<size_t>(n));
+    if (prefetch_window_ > 0) {
+        prefetch_ahead();
+    }
+    if (bytes_to_send_ == 0) {
+        return WriteResult::SUCCESS;
+    }
+    // 短写说明发送缓冲区已满，等待 EPOLLOUT；否则调用方可在预算内继续写
+    return static_cast<size_t>(n) < attempted ? WriteResult::CONTINUE : WriteResult::PROGRESS;
+}
+
+size_t OutputBuffer::writable_len(const Chunk& chunk) const {
+    if (!residency_tracked_ || !chunk.file_backed) {
+        return chunk.len;
+    }
+    if (chunk.file_offset < resident_from_ || chunk.file_offset >= resident_until_) {
+        return chunk.len; // 不在跟踪窗口内（如 multipart 的后续分段），由下一次检查负责
+    }
+    size_t remain = static_cast<size_t>(resident_until_ - chunk.file_offset);
+    return remain < chunk.len ? remain : chunk.len;
+}
 
-        bytes_have_sent_ += n;
-        bytes_to_send_ -= n;
-
-        if (bytes_have_sent_ >= response_bound_) {
-            iov_[0].iov_len = 0;
-            size_t file_bytes_sent = bytes_have_sent_ - response_bound_;
-            iov_[1].iov_base = static_cast<char*>(file_address_) + file_bytes_sent;
-            iov_[1].iov_len = bytes_to_send_;
-        } else {
-            char* base = static_cast<char*>(iov_[0].iov_base);
-            iov_[0].iov_base = base + bytes_have_sent_;
-            iov_[0].iov_len = response_bound_ - bytes_have_sent_;
+bool OutputBuffer::needs_readahead(size_t window, size_t min_file_bytes, ReadaheadHint& hint) {
+    if (window == 0 || file_bytes_ < min_file_bytes) {
+        return false;
+    }
+
+    // 找到下一个待发送的文件段（header 可能还没发完）
+    const Chunk* chunk = nullptr;
+    for (size_t i = chunk_index_; i < chunks_.size(); ++i) {
+        if (chunks_[i].file_backed && chunks_[i].len > 0) {
+            chunk = &chunks_[i];
+            break;
         }
     }
+    if (!chunk) {
+        return false;
+    }
+
+    off_t offset = chunk->file_offset;
+    if (residency_tracked_ && offset >= resident_from_ && offset < resident_until_) {
+        return false; // 仍在已确认的窗口内
+    }
+
+    size_t length = window < chunk->len ? window : chunk->len;
+    hint = {offset, length};
+    if (window_resident(hint)) {
+        mark_resident(hint);
+        return false;
+    }
+    return true;
+}
+
+void OutputBuffer::mark_resident(const ReadaheadHint& hint) {
+    residency_tracked_ = true;
+    resident_from_ = hint.offset;
+    resident_until_ = hint.offset + static_cast<off_t>(hint.length);
+}
+
+bool OutputBuffer::probe_mincore(const char* data, size_t len) const {
+    static const size_t PAGE_SIZE = sysconf(_SC_PAGE_SIZE);
+    auto addr = reinterpret_cast<uintptr_t>(data);
+    uintptr_t aligned = addr & ~(PAGE_SIZE - 1);
+    size_t span = addr + len - aligned;
+    size_t pages = (span + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    thread_local std::vector<unsigned char> vec;
+    vec.resize(pages);
+    if (mincore(reinterpret_cast<void*>(aligned), span, vec.data()) != 0) {
+        LOG_DEBUG("[OutputBuffer] mincore failed: {}", strerror(errno));
+        return true; // 检查失败时按常驻处理，退化为原来的同步发送
+    }
+    return std::all_of(vec.begin(), vec.end(), [](unsigned char v) { return v & 1; });
+}
 
-    return bytes_to_send_ > 0 ? WriteResult::CONTINUE : WriteResult::SUCCESS;
+bool OutputBuffer::window_resident(const ReadaheadHint& hint) const {
+    if (file_address_) {
+        auto begin = static_cast<size_t>(hint.offset) - map_offset_;
+        return probe_mincore(static_cast<const char*>(file_address_) + begin, hint.length);
+    }
+    return probe_file(hint.offset, hint.length);
+}
+
+int OutputBuffer::dup_file_fd() const {
+    return file_fd_ >= 0 ? fcntl(file_fd_, F_DUPFD_CLOEXEC, 0) : -1;
+}
+
+bool OutputBuffer::probe_file(off_t offset, size_t len) const {
+    // 临时映射窗口后用 mincore 逐页检查（建立映射不会读盘）
+    static const size_t PAGE_SIZE = sysconf(_SC_PAGE_SIZE);
+    off_t aligned = offset & ~static_cast<off_t>(PAGE_SIZE - 1);
+    size_t span = static_cast<size_t>(offset - aligned) + len;
+    void* addr = mmap(nullptr, span, PROT_READ, MAP_SHARED, file_fd_, aligned);
+    if (addr != MAP_FAILED) {
+        bool resident = probe_mincore(static_cast<const char*>(addr) + (offset - aligned), len);
+        munmap(addr, span);
+        return resident;
+    }
+
+    // 无法映射时退化为探测窗口首尾两页：RWF_NOWAIT 在数据不在 page cache 时返回 EAGAIN 而不是阻塞
+    char byte;
+    struct iovec iov {&byte, 1};
+    for (off_t pos : {offset, offset + static_cast<off_t>(len) - 1}) {
+        ssize_t n = preadv2(file_fd_, &iov, 1, pos, RWF_NOWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN) {
+                return false;
+            }
+            LOG_DEBUG("[OutputBuffer] preadv2 probe failed: {}", strerror(errno));
+            return true; // 内核不支持时退化为同步发送
+        }
+    }
+    return true;
+}
+
+void OutputBuffer::enable_sequential(size_t prefetch_window) {
+    if (file_bytes_ == 0) {
+        return;
+    }
+
+    if (file_address_) {
+        if (madvise(file_address_, mmap_size_, MADV_SEQUENTIAL) != 0) {
+            LOG_DEBUG("[OutputBuffer] madvise SEQUENTIAL failed: {}", strerror(errno));
+        }
+    } else if (file_fd_ >= 0) {
+        posix_fadvise(file_fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    prefetch_window_ = prefetch_window;
+    prefetch_next_ = 0;
+    if (prefetch_window_ > 0) {
+        prefetch_ahead();
+    }
+}
+
+void OutputBuffer::prefetch_ahead() {
+    const Chunk* chunk = nullptr;
+    for (size_t i = chunk_index_; i < chunks_.size(); ++i) {
+        if (chunks_[i].file_backed && chunks_[i].len > 0) {
+            chunk = &chunks_[i];
+            break;
+        }
+    }
+    if (!chunk) {
+        return;
+    }
+
+    // 前方已预读的数据仍多于一个窗口
+    off_t pos = chunk->file_offset;
+    if (pos + static_cast<off_t>(prefetch_window_) < prefetch_next_) {
+        return;
+    }
+
+    // 预读 [pos, pos + 2 * window) 中尚未发起的部分，只发起异步 I/O，不等待完成
+    off_t from = pos > prefetch_next_ ? pos : prefetch_next_;
+    off_t chunk_end = pos + static_cast<off_t>(chunk->len);
+    off_t to = std::min<off_t>(pos + 2 * static_cast<off_t>(prefetch_window_), chunk_end);
+    if (from >= to) {
+        return;
+    }
+
+    if (file_address_) {
+        static const size_t PAGE_SIZE = sysconf(_SC_PAGE_SIZE);
+        size_t begin = static_cast<size_t>(from) - map_offset_;
+        size_t aligned = begin / PAGE_SIZE * PAGE_SIZE;
+        madvise(static_cast<char*>(file_address_) + aligned, static_cast<size_t>(to - from) + (begin - aligned),
+                MADV_WILLNEED);
+    } else if (file_fd_ >= 0) {
+        posix_fadvise(file_fd_, from, to - from, POSIX_FADV_WILLNEED);
+    }
+    prefetch_next_ = to;
 }
 
 void OutputBuffer::unmap_if_needed() {
     if (should_unmap_ && file_address_) {
-        munmap(file_address_, mmap_size_);  // 使用原始大小，而不是被修改的 iov_[1].iov_len，否则有可能造成内存泄露
+        munmap(file_address_, mmap_size_);  // 使用原始大小，而不是被修改的 chunk 长度，否则有可能造成内存泄露
         file_address_ = nullptr;
         mmap_size_ = 0;
         should_unmap_ = false;
@@ -227,37 +487,58 @@ void OutputBuffer::close_file_if_needed() {
 
 // 移动语义支持
 OutputBuffer::OutputBuffer(OutputBuffer&& other) noexcept
-    : iov_{other.iov_[0], other.iov_[1]}
-    , iov_count_(other.iov_count_)
+    : chunks_(std::move(other.chunks_))
+    , chunk_index_(other.chunk_index_)
     , bytes_have_sent_(other.bytes_have_sent_)
     , bytes_to_send_(other.bytes_to_send_)
-    , response_bound_(other.response_bound_)
+    , file_bytes_(other.file_bytes_)
+    , residency_tracked_(other.residency_tracked_)
+    , resident_from_(other.resident_from_)
+    , resident_until_(other.resident_until_)
+    , prefetch_window_(other.prefetch_window_)
+    , prefetch_next_(other.prefetch_next_)
     , file_address_(other.file_address_)
+    , map_offset_(other.map_offset_)
     , mmap_size_(other.mmap_size_)
-    , should_unmap_(other.should_unmap_) {
-    other.reset();
+    , should_unmap_(other.should_unmap_)
+    , file_fd_(other.file_fd_)
+    , use_sendfile_(other.use_sendfile_)
+    , close_connection_(other.close_connection_) {
+    // 资源所有权已转移，先清空再 reset，避免 other 释放
     other.file_address_ = nullptr;
     other.mmap_size_ = 0;
     other.should_unmap_ = false;
+    other.file_fd_ = -1;
+    other.reset();
 }
 
 OutputBuffer& OutputBuffer::operator=(OutputBuffer&& other) noexcept {
     if (this != &other) {
         unmap_if_needed();
-        iov_[0] = other.iov_[0];
-        iov_[1] = other.iov_[1];
-        iov_count_ = other.iov_count_;
+        close_file_if_needed();
+        chunks_ = std::move(other.chunks_);
+        chunk_index_ = other.chunk_index_;
         bytes_have_sent_ = other.bytes_have_sent_;
         bytes_to_send_ = other.bytes_to_send_;
-        response_bound_ = other.response_bound_;
+        file_bytes_ = other.file_bytes_;
+        residency_tracked_ = other.residency_tracked_;
+        resident_from_ = other.resident_from_;
+        resident_until_ = other.resident_until_;
+        prefetch_window_ = other.prefetch_window_;
+        prefetch_next_ = other.prefetch_next_;
         file_address_ = other.file_address_;
+        map_offset_ = other.map_offset_;
         mmap_size_ = other.mmap_size_;
         should_unmap_ = other.should_unmap_;
+        file_fd_ = other.file_fd_;
+        use_sendfile_ = other.use_sendfile_;
+        close_connection_ = other.close_connection_;
 
-        other.reset();
         other.file_address_ = nullptr;
         other.mmap_size_ = 0;
         other.should_unmap_ = false;
+        other.file_fd_ = -1;
+        other.reset();
     }
     return *this;
 }
@@ -0,0 +1,108 @@
+#include "path_util.h"
+#include "logger.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/openat2.h>
+#include <sys/syscall.h>
+
+namespace {
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool percentDecode(std::string& path) {
+        size_t w = 0;
+        for (size_t r = 0; r < path.size(); ++r, ++w) {
+            char c = path[r];
+            if (c == '%') {
+                if (r + 2 >= path.size()) {
+                    return false;
+                }
+                int hi = hexValue(path[r + 1]);
+                int lo = hexValue(path[r + 2]);
+                if (hi < 0 || lo < 0 || (hi == 0 && lo == 0)) {
+                    return false;
+                }
+                c = static_cast<char>(hi << 4 | lo);
+                r += 2;
+            }
+            path[w] = c;
+        }
+        path.resize(w);
+        return true;
+    }
+}
+
+namespace PathUtil {
+    bool normalize(std::string& path) {
+        if (std::memchr(path.data(), '%', path.size()) && !percentDecode(path)) {
+            return false;
+        }
+        if (path.empty() || path[0] != '/') {
+            return false;
+        }
+
+        // 快路径：绝大多数请求不含 "//" 与 "/."，memmem 由 libc 向量化实现
+        if (!memmem(path.data(), path.size(), "//", 2) && !memmem(path.data(), path.size(), "/.", 2)) {
+            return true;
+        }
+
+        // 慢路径：逐段就地重写，w 指向已输出部分的末尾
+        size_t w = 0;
+        size_t r = 0;
+        while (r < path.size()) {
+            while (r < path.size() && path[r] == '/') ++r;
+            size_t end = path.find('/', r);
+            if (end == std::string::npos) end = path.size();
+            std::string_view segment(path.data() + r, end - r);
+
+            if (segment.empty() || segment == ".") {
+                // 跳过
+            } else if (segment == "..") {
+                if (w == 0) {
+                    return false; // 越过根目录
+                }
+                while (w > 0 && path[--w] != '/') {
+                }
+            } else {
+                path[w++] = '/';
+                std::memmove(path.data() + w, segment.data(), segment.size());
+                w += segment.size();
+            }
+            r = end;
+        }
+        if (w == 0) {
+            path[w++] = '/';
+        }
+        path.resize(w);
+        return true;
+    }
+
+    int openBeneath(int dirfd, std::string_view path, int flags) {
+        while (!path.empty() && path.front() == '/') {
+            path.remove_prefix(1);
+        }
+        std::string relative = path.empty() ? std::string(".") : std::string(path);
+
+        open_how how {};
+        how.flags = static_cast<uint64_t>(flags | O_CLOEXEC);
+        how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+        int fd = static_cast<int>(syscall(SYS_openat2, dirfd, relative.c_str(), &how, sizeof(how)));
+        if (fd >= 0 || errno != ENOSYS) {
+            return fd;
+        }
+
+        // 内核早于 5.6：路径已做词法规范化，不含 ..；仍可能经符号链接越界，只能退化为 openat
+        static std::atomic<bool> warned {false};
+        if (!warned.exchange(true, std::memory_order_relaxed)) {
+            LOG_WARN("[PathUtil] openat2 unavailable, falling back to openat");
+        }
+        return ::openat(dirfd, relative.c_str(), flags | O_CLOEXEC);
+    }
+}
@@ -1,164 +1,534 @@
 #include "static_file_controller.h"
+#include "http_range.h"
+#include "compressed_cache.h"
+#include "asset_pack.h"
+#include "asset_fingerprint.h"
+#include "path_util.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
 #include <filesystem>
-#include <regex>
 #include <fstream>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace {
+    // 一次 fstat 得到的响应元数据，HEAD 与条件请求据此直接应答
+    struct FileMeta {
+        std::string etag;
+        std::string headers; // Content-Type / Last-Modified / Accept-Ranges [/ Vary]，每行以 \r\n 结尾
+        std::time_t mtime = 0;
+        std::uintmax_t size = 0;
+        bool compressible = false; // 存在压缩变体，HEAD 的长度取决于内容协商
+        int64_t checked_ms = 0;
+    };
+
+    constexpr size_t kMaxMetaEntries = 4096;
+
+    // 每个 reactor 线程一份，无锁；过期条目下次走慢路径时刷新
+    thread_local std::unordered_map<std::string, std::shared_ptr<const FileMeta>> tls_meta;
+
+    int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string httpDate(std::time_t time) {
+        char buf[64] = {};
+        std::tm tm {};
+        std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&time, &tm));
+        return buf;
+    }
+
+    void rememberMeta(const std::string& uri, std::string etag, std::string_view mimeType,
+                      const std::string& lastModified, const struct stat& st, bool compressible) {
+        if (tls_meta.size() >= kMaxMetaEntries && !tls_meta.contains(uri)) {
+            tls_meta.clear();
+        }
+        auto meta = std::make_shared<FileMeta>();
+        meta->etag = std::move(etag);
+        meta->headers.reserve(128);
+        meta->headers.append("Content-Type: ").append(mimeType).append("\r\n");
+        meta->headers.append("Last-Modified: ").append(lastModified).append("\r\n");
+        meta->headers.append("Accept-Ranges: bytes\r\n");
+        if (compressible) {
+            meta->headers.append("Vary: Accept-Encoding\r\n");
+        }
+        meta->mtime = st.st_mtim.tv_sec;
+        meta->size = static_cast<std::uintmax_t>(st.st_size);
+        meta->compressible = compressible;
+        meta->checked_ms = nowMs();
+        tls_meta[uri] = std::move(meta);
+    }
+
+    // days_from_civil（proleptic Gregorian），避免 mktime 依赖本地时区
+    int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    bool parseDigits(std::string_view s, size_t pos, size_t len, int& out) {
+        out = 0;
+        for (size_t i = pos; i < pos + len; ++i) {
+            if (s[i] < '0' || s[i] > '9') {
+                return false;
+            }
+            out = out * 10 + (s[i] - '0');
+        }
+        return true;
+    }
+}
+
+int StaticFileController::docRootFd() {
+    static const int fd = [] {
+        int dirfd = ::open(kDocRoot, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (dirfd < 0) {
+            LOG_ERROR("[StaticFileController] Failed to open document root {}: {}", kDocRoot, strerror(errno));
+        }
+        return dirfd;
+    }();
+    return fd;
+}
 
 void StaticFileController::serveStaticFile(const HttpRequest& req, HttpResponse& resp) {
     LOG_INFO("[StaticFileController] Handling url {}", req.uri());
-    std::string filepath = std::string(kDocRoot) + req.uri();
-    
-    // 规范化路径，防止目录遍历攻击
-    std::error_code ec;
-    std::filesystem::path normalizedPath = std::filesystem::canonical(filepath, ec);
-    if (ec || !normalizedPath.string().starts_with(kDocRoot)) {
-        resp.set_status(HttpStatus::FORBIDDEN);
-        resp.set_body("Access denied");
-        LOG_INFO("[StaticFileController] Access deny, url {} ", req.uri());
+
+    // 路径已在解析请求行时解码并规范化（不再二次解码），越界由 openBeneath 兜底
+    const std::string& uri = req.uri();
+
+    // 指纹别名 /static/<hash>/<name>；旧指纹（页面缓存了上一版本的引用）仍返回当前内容，但不能标记为 immutable
+    std::string name;
+    bool current = false;
+    if (AssetFingerprint::Instance().resolve(uri, name, current)) {
+        serveAsset(req, name, current ? kImmutableCacheControl : "no-cache", resp);
         return;
     }
 
-    // 检查文件是否存在且可访问
-    if (!std::filesystem::exists(filepath)) {
-        resp.set_status(HttpStatus::NOT_FOUND);
-        resp.set_body("File not found");
-        LOG_INFO("[StaticFileController] File not found, url {} ", req.uri());
+    if (const auto* page = AssetFingerprint::Instance().page(std::string(kDocRoot) + uri)) {
+        servePage(*page, req, resp);
+        return;
+    }
+    serveAsset(req, uri, kDefaultCacheControl, resp);
+}
+
+void StaticFileController::servePage(const AssetFingerprint::Page& page, const HttpRequest& req, HttpResponse& resp) {
+    auto encoding = Compression::Encoding::IDENTITY;
+    std::shared_ptr<const std::string> body = page.body;
+    if (compression_enabled_ && (page.gzip || page.zstd)) {
+        resp.add_header("Vary", "Accept-Encoding");
+        if (auto it = req.headers().find("Accept-Encoding"); it != req.headers().end()) {
+            Compression::Encoding candidates[2];
+            size_t count = Compression::acceptable(it->second, candidates);
+            for (size_t i = 0; i < count; ++i) {
+                const auto& variant = candidates[i] == Compression::Encoding::ZSTD ? page.zstd : page.gzip;
+                if (variant) {
+                    encoding = candidates[i];
+                    body = variant;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::string etag = variantETag(page.etag, encoding);
+    resp.add_header("Content-Type", "text/html");
+    resp.add_header("ETag", etag);
+    // 页面本身引用的是指纹别名，必须每次验证才能在发布后拿到新的引用
+    resp.add_header("Cache-Control", "no-cache");
+    if (req.method() != HttpRequest::Method::POST) {
+        if (auto it = req.headers().find("If-None-Match"); it != req.headers().end() && it->second == etag) {
+            resp.set_status(HttpStatus::NOT_MODIFIED);
+            resp.set_handled();
+            return;
+        }
+    }
+    if (encoding != Compression::Encoding::IDENTITY) {
+        resp.add_header("Content-Encoding", std::string(Compression::name(encoding)));
+    }
+    resp.set_shared_body(std::move(body));
+}
+
+void StaticFileController::serveAsset(const HttpRequest& req, const std::string& uri, std::string_view cacheControl,
+                                      HttpResponse& resp) {
+    if (servePacked(req, uri, cacheControl, resp) || serveFromMeta(req, uri, cacheControl, resp)) {
         return;
     }
 
-    // 获取文件信息
-    auto fileSize = std::filesystem::file_size(filepath, ec);
-    if (ec) {
-        resp.set_status(HttpStatus::INTERNAL_ERROR);
-        resp.set_body("Failed to get file info");
-        LOG_INFO("[StaticFileController] Failed to get file info, url {} ", req.uri());
+    std::string filepath = std::string(kDocRoot) + uri;
+
+    // 在 docroot 目录 fd 之下打开：.. 与指向外部的符号链接由内核拒绝，一次系统调用替代 canonical 的逐级 lstat
+    UniqueFd fd(PathUtil::openBeneath(docRootFd(), uri, O_RDONLY));
+    if (!fd) {
+        if (errno == ENOENT || errno == ENOTDIR) {
+            resp.set_status(HttpStatus::NOT_FOUND);
+            resp.set_body("File not found");
+            LOG_INFO("[StaticFileController] File not found, url {} ", uri);
+        } else if (errno == EXDEV || errno == ELOOP || errno == EACCES || errno == EPERM) {
+            resp.set_status(HttpStatus::FORBIDDEN);
+            resp.set_body("Access denied");
+            LOG_INFO("[StaticFileController] Access deny, url {} ", uri);
+        } else {
+            resp.set_status(HttpStatus::INTERNAL_ERROR);
+            resp.set_body("Failed to open file");
+            LOG_INFO("[StaticFileController] Failed to open file, url {}: {}", uri, strerror(errno));
+        }
         return;
     }
 
-    // 处理部分内容请求（Range）
-    if (auto it = req.headers().find("Range"); it != req.headers().end()) {
-        handleRangeRequest(it->second, fileSize, filepath, req, resp);
+    // 获取文件信息（目录等非普通文件按不存在处理）
+    struct stat st {};
+    if (::fstat(fd.get(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        resp.set_status(HttpStatus::NOT_FOUND);
+        resp.set_body("File not found");
+        LOG_INFO("[StaticFileController] File not found, url {} ", uri);
         return;
     }
+    auto fileSize = static_cast<std::uintmax_t>(st.st_size);
 
     // 设置 Content-Type
     auto mimeType = MimeTypes::getMimeType(filepath);
     resp.add_header("Content-Type", std::string(mimeType));
 
-    // 设置文件
-    resp.set_file(filepath);
+    std::time_t lastModifiedTime = st.st_mtim.tv_sec;
+    std::string lastModified = httpDate(lastModifiedTime);
+    bool compressible = compression_enabled_ && MimeTypes::isTextType(mimeType);
+    std::string identityETag = generateETag(lastModifiedTime, fileSize);
+    if (meta_ttl_ms_ > 0) {
+        rememberMeta(uri, identityETag, mimeType, lastModified, st, compressible);
+    }
+
+    // 设置文件（发送时直接使用这个 fd）
+    resp.set_opened_file(filepath, std::move(fd), fileSize);
+
+    // 内容协商：文本类资源按 Accept-Encoding 选择压缩变体；Range 请求始终针对原始字节
+    EncodedVariant variant;
+    if (compressible) {
+        resp.add_header("Vary", "Accept-Encoding");
+        if (req.headers().find("Range") == req.headers().end()) {
+            variant = selectVariant(req, uri, filepath, st);
+        }
+    }
+    
+    // 处理条件请求：If-None-Match 优先于 If-Modified-Since；304 不发送文件，提前关闭 fd
+    resp.add_header("Last-Modified", lastModified);
+    std::string etag = variantETag(identityETag, variant.encoding);
+    resp.add_header("ETag", etag);
+    resp.add_header("Cache-Control", std::string(cacheControl));
+    bool notModified = false;
+    if (auto it = req.headers().find("If-None-Match"); it != req.headers().end()) {
+        notModified = it->second == etag;
+    } else if (auto it = req.headers().find("If-Modified-Since"); it != req.headers().end()) {
+        notModified = parseHttpDate(it->second) >= lastModifiedTime;
+    }
+    if (notModified) {
+        resp.set_status(HttpStatus::NOT_MODIFIED);
+        resp.clear_file();
+        resp.set_handled();
+        return;
+    }
     
-    // 只有在需要时才添加缓存相关头
-    // 处理条件请求（If-Modified-Since，If-None-Match）
-    auto lastModified = std::filesystem::last_write_time(filepath, ec);
-    if (!ec) {
-        auto lastModifiedTime = std::chrono::system_clock::to_time_t(
-            std::chrono::clock_cast<std::chrono::system_clock>(lastModified)
-        );
-        char timeBuf[100];
-        std::strftime(timeBuf, sizeof(timeBuf), "%a, %d %b %Y %H:%M:%S GMT", 
-                     std::gmtime(&lastModifiedTime));
-        resp.add_header("Last-Modified", timeBuf);
-
-        // 处理 If-Modified-Since
-        if (auto it = req.headers().find("If-Modified-Since"); it != req.headers().end()) {
-            std::time_t ifModifiedSince = parseHttpDate(it->second);
-            if (ifModifiedSince >= lastModifiedTime) {
-                resp.set_status(HttpStatus::NOT_MODIFIED);
-                return;
+    // 添加 Accept-Ranges 头表明服务器支持范围请求
+    resp.add_header("Accept-Ranges", "bytes");
+
+    if (variant.encoding != Compression::Encoding::IDENTITY) {
+        resp.add_header("Content-Encoding", std::string(Compression::name(variant.encoding)));
+        if (variant.blob) {
+            resp.clear_file();
+            resp.set_shared_body(std::move(variant.blob));
+        } else {
+            resp.set_opened_file(std::move(variant.sidecar_path), std::move(variant.sidecar_fd), variant.sidecar_size);
+        }
+        return;
+    }
+
+    // 处理部分内容请求（Range），条件请求之后评估；If-Range 不匹配时忽略 Range 返回整个文件
+    if (auto it = req.headers().find("Range"); it != req.headers().end()) {
+        auto ifRange = req.headers().find("If-Range");
+        if (ifRange == req.headers().end() || HttpRange::ifRangeMatches(ifRange->second, etag, lastModified)) {
+            handleRangeRequest(it->second, fileSize, filepath, mimeType, resp);
+        }
+    }
+}
+
+bool StaticFileController::servePacked(const HttpRequest& req, const std::string& uri,
+                                       std::string_view cacheControl, HttpResponse& resp) {
+    auto pack = AssetPack::Pack::current();
+    AssetPack::Pack::Asset asset;
+    if (!pack || !pack->find(uri, asset)) {
+        return false;
+    }
+
+    const auto& headers = req.headers();
+    auto rangeIt = headers.find("Range");
+
+    bool useGzip = false;
+    if (!asset.gzip.empty() && compression_enabled_ && rangeIt == headers.end()) {
+        if (auto it = headers.find("Accept-Encoding"); it != headers.end()) {
+            Compression::Encoding candidates[2];
+            auto end = candidates + Compression::acceptable(it->second, candidates);
+            useGzip = std::find(candidates, end, Compression::Encoding::GZIP) != end;
+        }
+    }
+
+    std::string etag(asset.etag);
+    if (useGzip) {
+        etag = variantETag(etag, Compression::Encoding::GZIP);
+    }
+    resp.set_raw_headers(useGzip ? asset.gzip_headers : asset.headers, pack);
+    resp.add_header("Cache-Control", std::string(cacheControl));
+
+    // If-None-Match 优先于 If-Modified-Since
+    if (auto it = headers.find("If-None-Match"); it != headers.end()) {
+        if (it->second == etag) {
+            resp.set_status(HttpStatus::NOT_MODIFIED);
+            resp.set_handled();
+            return true;
+        }
+    } else if (auto it = headers.find("If-Modified-Since"); it != headers.end()) {
+        if (parseHttpDate(it->second) >= asset.mtime) {
+            resp.set_status(HttpStatus::NOT_MODIFIED);
+            resp.set_handled();
+            return true;
+        }
+    }
+
+    std::string_view body = useGzip ? asset.gzip : asset.body;
+
+    if (rangeIt != headers.end()) {
+        bool rangeApplies = true;
+        if (auto ifRange = headers.find("If-Range"); ifRange != headers.end()) {
+            char timeBuf[100] = {};
+            std::time_t mtime = static_cast<std::time_t>(asset.mtime);
+            std::tm tm {};
+            std::strftime(timeBuf, sizeof(timeBuf), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&mtime, &tm));
+            rangeApplies = HttpRange::ifRangeMatches(ifRange->second, etag, timeBuf);
+        }
+
+        HttpRange::RangeSet ranges;
+        auto result = rangeApplies ? HttpRange::parse(rangeIt->second, body.size(), ranges)
+                                   : HttpRange::Result::IGNORE;
+        if (result == HttpRange::Result::NOT_SATISFIABLE) {
+            resp.set_status(HttpStatus::REQUESTED_RANGE_NOT_SATISFIABLE);
+            resp.add_header("Content-Range", "bytes */" + std::to_string(body.size()));
+            resp.set_content_length(0);
+            resp.set_handled();
+            return true;
+        }
+        // 多段范围按 RFC 7233 允许的方式退化为 200 整体响应，单段直接切片映射区
+        if (result == HttpRange::Result::OK && ranges.count == 1) {
+            const auto& range = ranges.ranges[0];
+            resp.set_status(HttpStatus::PARTIAL_CONTENT);
+            resp.add_header("Content-Range",
+                "bytes " + std::to_string(range.start) + "-" +
+                std::to_string(range.start + range.length - 1) + "/" + std::to_string(body.size()));
+            body = body.substr(range.start, range.length);
+        }
+    }
+
+    resp.set_external_body(body, std::move(pack));
+    return true;
+}
+
+bool StaticFileController::serveFromMeta(const HttpRequest& req, const std::string& uri,
+                                        std::string_view cacheControl, HttpResponse& resp) {
+    const auto& headers = req.headers();
+    bool head = req.method() == HttpRequest::Method::HEAD;
+    auto inm = headers.find("If-None-Match");
+    auto ims = headers.find("If-Modified-Since");
+    if (meta_ttl_ms_ <= 0 || (!head && inm == headers.end() && ims == headers.end())) {
+        return false;
+    }
+
+    auto it = tls_meta.find(uri);
+    if (it == tls_meta.end()) {
+        return false;
+    }
+    if (nowMs() - it->second->checked_ms > meta_ttl_ms_) {
+        tls_meta.erase(it);
+        return false;
+    }
+    std::shared_ptr<const FileMeta> meta = it->second;
+
+    // 条件请求：任一表示（原始或压缩变体）的 ETag 匹配都说明内容未变
+    std::string matched;
+    if (inm != headers.end()) {
+        if (inm->second == meta->etag) {
+            matched = meta->etag;
+        } else if (meta->compressible) {
+            for (auto encoding : {Compression::Encoding::GZIP, Compression::Encoding::ZSTD}) {
+                if (auto etag = variantETag(meta->etag, encoding); inm->second == etag) {
+                    matched = std::move(etag);
+                    break;
+                }
             }
         }
-        
-        // 设置 ETag（简单实现，实际应该基于文件内容）
-        std::string etag = generateETag(lastModified, fileSize);
-        resp.add_header("ETag", etag);
+    }
+    bool notModified = inm != headers.end() ? !matched.empty()
+                                            : ims != headers.end() && parseHttpDate(ims->second) >= meta->mtime;
+    if (notModified) {
+        resp.set_status(HttpStatus::NOT_MODIFIED);
+        resp.set_raw_headers(meta->headers, meta);
+        if (!matched.empty()) {
+            resp.add_header("ETag", matched);
+        }
+        resp.add_header("Cache-Control", std::string(cacheControl));
+        resp.set_handled();
+        return true;
+    }
+    if (!head || headers.contains("Range")) {
+        return false;
+    }
 
-        // 处理 If-None-Match
-        if (auto it = req.headers().find("If-None-Match"); it != req.headers().end()) {
-            if (it->second == etag) {
-                resp.set_status(HttpStatus::NOT_MODIFIED);
-                return;
+    // HEAD：可能返回压缩变体时长度取决于协商结果，交给慢路径
+    if (meta->compressible) {
+        if (auto ae = headers.find("Accept-Encoding"); ae != headers.end()) {
+            Compression::Encoding candidates[2];
+            if (Compression::acceptable(ae->second, candidates) > 0) {
+                return false;
             }
         }
-        
-        // 启用缓存控制
-        resp.add_header("Cache-Control", "public, max-age=3600");
     }
-    
-    // 添加 Accept-Ranges 头表明服务器支持范围请求
-    resp.add_header("Accept-Ranges", "bytes");
+    resp.set_raw_headers(meta->headers, meta);
+    resp.add_header("ETag", meta->etag);
+    resp.add_header("Cache-Control", std::string(cacheControl));
+    resp.set_content_length(meta->size);
+    resp.set_handled();
+    return true;
 }
 
-void StaticFileController::serveFile(const std::string& filepath, HttpResponse& resp) {
-    // 检查文件是否存在且可访问
-    std::error_code ec;
-    if (!std::filesystem::exists(filepath, ec)) {
-        resp.set_status(HttpStatus::NOT_FOUND);
-        resp.set_body("File not found");
-        return;
+StaticFileController::EncodedVariant StaticFileController::selectVariant(const HttpRequest& req,
+                                                                        const std::string& uri,
+                                                                        const std::string& filepath,
+                                                                        const struct stat& st) {
+    EncodedVariant variant;
+    auto it = req.headers().find("Accept-Encoding");
+    if (it == req.headers().end()) {
+        return variant;
+    }
+    Compression::Encoding candidates[2];
+    size_t count = Compression::acceptable(it->second, candidates);
+    if (count == 0) {
+        return variant;
+    }
+
+    // 预压缩文件优先（构建期生成，压缩级别更高），须不旧于原文件；同样在 docroot 之下打开
+    for (size_t i = 0; i < count; ++i) {
+        std::string_view suffix = Compression::sidecarSuffix(candidates[i]);
+        UniqueFd fd(PathUtil::openBeneath(docRootFd(), uri + std::string(suffix), O_RDONLY));
+        struct stat sst {};
+        if (fd && ::fstat(fd.get(), &sst) == 0 && S_ISREG(sst.st_mode) && sst.st_mtim.tv_sec >= st.st_mtim.tv_sec) {
+            variant.encoding = candidates[i];
+            variant.sidecar_path = filepath + std::string(suffix);
+            variant.sidecar_fd = std::move(fd);
+            variant.sidecar_size = static_cast<size_t>(sst.st_size);
+            return variant;
+        }
     }
 
-    // 获取文件信息
-    auto fileSize = std::filesystem::file_size(filepath, ec);
-    if (ec) {
-        resp.set_status(HttpStatus::INTERNAL_ERROR);
-        resp.set_body("Failed to get file info");
+    if (static_cast<size_t>(st.st_size) < compress_min_bytes_) {
+        return variant;
+    }
+
+    auto& cache = CompressedCache::Instance();
+    CompressedCache::Key key {st.st_dev, st.st_ino,
+                              static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+                              st.st_size, candidates[0]};
+    for (size_t i = 0; i < count; ++i) {
+        key.encoding = candidates[i];
+        if (auto blob = cache.lookup(key)) {
+            if (blob->empty()) {
+                return variant; // 不可压缩，换编码也不会更小
+            }
+            variant.encoding = candidates[i];
+            variant.blob = std::move(blob);
+            return variant;
+        }
+    }
+
+    // 未命中：后台压缩首选编码，本次先返回原始文件，不阻塞 reactor
+    key.encoding = candidates[0];
+    cache.compressAsync(key, filepath);
+    return variant;
+}
+
+void StaticFileController::serveFile(const HttpRequest& req, const std::string& name, HttpResponse& resp) {
+    if (const auto* page = AssetFingerprint::Instance().page(std::string(kDocRoot) + name)) {
+        servePage(*page, req, resp);
+        return;
+    }
+    if (req.method() != HttpRequest::Method::POST) {
+        serveAsset(req, name, "no-cache", resp);
         return;
     }
 
-    // 设置 Content-Type
-    auto mimeType = MimeTypes::getMimeType(filepath);
-    resp.add_header("Content-Type", std::string(mimeType));
-    
-    // 设置文件
-    resp.set_file(filepath);
+    // POST 的结果页（登录失败等）：只保留内容协商需要的请求头
+    HttpRequest negotiation;
+    negotiation.set_method(HttpRequest::Method::GET);
+    if (auto it = req.headers().find("Accept-Encoding"); it != req.headers().end()) {
+        negotiation.add_header("Accept-Encoding", it->second);
+    }
+    serveAsset(negotiation, name, "no-cache", resp);
 }
 
-void StaticFileController::handleRangeRequest(const std::string& rangeHeader, 
+std::time_t StaticFileController::parseHttpDate(std::string_view date) {
+    static constexpr std::string_view kMonths = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    // 固定 29 字节："Sun, 06 Nov 1994 08:49:37 GMT"
+    if (date.size() != 29 || date[3] != ',' || date[4] != ' ' || date[7] != ' ' || date[11] != ' ' ||
+        date[16] != ' ' || date[19] != ':' || date[22] != ':' || date.substr(25) != " GMT") {
+        return -1;
+    }
+    auto month = kMonths.find(date.substr(8, 3));
+    int day, year, hour, minute, second;
+    if (month == std::string_view::npos || month % 3 != 0 || !parseDigits(date, 5, 2, day) ||
+        !parseDigits(date, 12, 4, year) || !parseDigits(date, 17, 2, hour) || !parseDigits(date, 20, 2, minute) ||
+        !parseDigits(date, 23, 2, second) || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return -1;
+    }
+    int64_t days = daysFromCivil(year, static_cast<unsigned>(month / 3 + 1), static_cast<unsigned>(day));
+    return static_cast<std::time_t>(days * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+void StaticFileController::handleRangeRequest(std::string_view rangeHeader,
                                              std::uintmax_t fileSize,
                                              const std::string& filepath,
-                                             const HttpRequest& req,
+                                             std::string_view mimeType,
                                              HttpResponse& resp) {
-    // 解析范围请求头
-    std::smatch matches;
-    std::regex rangeRegex(R"(bytes=(\d*)-(\d*))");
-    if (!std::regex_match(rangeHeader, matches, rangeRegex)) {
-        resp.set_status(HttpStatus::BAD_REQUEST);
-        resp.set_body("Invalid range format");
-        return;
+    HttpRange::RangeSet ranges;
+    switch (HttpRange::parse(rangeHeader, fileSize, ranges)) {
+        case HttpRange::Result::IGNORE:
+            // RFC 7233：无法识别的 Range 直接忽略，按 200 返回整个文件
+            LOG_DEBUG("[StaticFileController] Ignoring range header: {}", rangeHeader);
+            return;
+
+        case HttpRange::Result::NOT_SATISFIABLE:
+            resp.set_status(HttpStatus::REQUESTED_RANGE_NOT_SATISFIABLE);
+            resp.add_header("Content-Range", "bytes */" + std::to_string(fileSize));
+            resp.clear_file();
+            resp.set_content_length(0);
+            return;
+
+        case HttpRange::Result::OK:
+            break;
     }
 
-    // 解析范围值
-    std::string startStr = matches[1].str();
-    std::string endStr = matches[2].str();
-    
-    size_t start = startStr.empty() ? 0 : std::stoull(startStr);
-    size_t end = endStr.empty() ? fileSize - 1 : std::stoull(endStr);
+    resp.set_status(HttpStatus::PARTIAL_CONTENT);
+
+    if (ranges.count == 1) {
+        const auto& range = ranges.ranges[0];
+        resp.add_header("Content-Range",
+            "bytes " + std::to_string(range.start) + "-" +
+            std::to_string(range.start + range.length - 1) + "/" + std::to_string(fileSize));
 
-    // 验证范围
-    if (start >= fileSize || end >= fileSize || start > end) {
-        resp.set_status(HttpStatus::REQUESTED_RANGE_NOT_SATISFIABLE);
-        resp.add_header("Content-Range", "bytes */" + std::to_string(fileSize));
+        // 使用文件映射方式处理范围请求，避免在内存中加载整个文件；Content-Length 由 build_response 统一计算
+        resp.set_file_with_range(filepath, range.start, range.length);
         return;
     }
 
-    // 设置部分内容响应
-    resp.set_status(HttpStatus::PARTIAL_CONTENT);
-    resp.add_header("Content-Range", 
-        "bytes " + std::to_string(start) + "-" + 
-        std::to_string(end) + "/" + std::to_string(fileSize));
-    
-    // 设置 Content-Type
-    auto mimeType = MimeTypes::getMimeType(filepath);
-    resp.add_header("Content-Type", std::string(mimeType));
-    
-    // 对于范围请求，我们需要提供特定范围的数据
-    // 通过设置 Accept-Ranges 头来表明服务器支持范围请求
-    resp.add_header("Accept-Ranges", "bytes");
-    
-    // 设置 Content-Length 为范围大小
-    size_t rangeSize = end - start + 1;
-    resp.add_header("Content-Length", std::to_string(rangeSize));
-    
-    // 使用文件映射方式处理范围请求，避免在内存中加载整个文件
-    resp.set_file_with_range(filepath, start, rangeSize);
-}
\ No newline at end of file
+    // 多个区间：multipart/byteranges，每段文件数据仍由 OutputBuffer 零拷贝发送
+    resp.set_file_with_ranges(filepath, mimeType, fileSize, ranges);
+}
@@ -3,22 +3,45 @@
 //
 
 #include "sub_reactor.h"
+#include "coro.h"
 #include "epoll_util.h"
 #include "logger.h"
+#include "rate_limiter.h"
 #include "threadpool.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cstring>
+#include <fcntl.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
 #include "config_manager.h"
 
-SubReactor::SubReactor(int id) : id_(id) {
+namespace {
+    // 未交给 HttpConnection 的连接：关闭并归还 accept 时占用的每地址连接名额
+    void rejectConnection(int client_fd, const sockaddr_in& client_addr) {
+        if (client_fd >= 0) {
+            close(client_fd);
+        }
+        RateLimiter::Instance().releaseConnection(client_addr.sin_addr.s_addr);
+    }
+}
+
+SubReactor::SubReactor(int id) :
+    id_(id),
+    loop_us_(Metrics::histogram("reactor_loop_busy_us")),
+    read_budget_exhausted_(Metrics::counter("reactor_read_budget_exhausted_total")),
+    write_budget_exhausted_(Metrics::counter("reactor_write_budget_exhausted_total")),
+    offload_stale_(Metrics::counter("reactor_offload_stale_total")),
+    coroutine_total_(Metrics::counter("reactor_coroutine_total")) {
+    link_ = std::make_shared<ReactorLink>();
+    link_->reactor = this;
     
     connections_.resize(MAX_FD);
+    ready_list_.reserve(1024);
+    ready_running_.reserve(1024);
     timer_handles_.reserve(10000);
-    use_thread_pool_ = ConfigManager::Instance().get<bool>("server.use_thread_pool", true);
     
     // 创建独立的 epoll 实例
     epoll_fd_ = epoll_create1(0);
@@ -50,7 +73,21 @@ SubReactor::SubReactor(int id) : id_(id) {
              id_, epoll_fd_, wakeup_fd_);
 }
 
+bool ReactorLink::queueInLoop(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!reactor) {
+        return false;
+    }
+    reactor->queueInLoop(std::move(task));
+    return true;
+}
+
 SubReactor::~SubReactor() {
+    // 先断开交还入口：仍在线程池上运行的任务（预读、协程的 offload 等）完成后不再投递到本对象
+    {
+        std::lock_guard<std::mutex> lock(link_->mutex);
+        link_->reactor = nullptr;
+    }
     stop();
     
     // 清理所有定时器，防止回调访问已销毁的成员变量
@@ -59,13 +96,17 @@ SubReactor::~SubReactor() {
     }
     timer_handles_.clear();
     
-    // 关闭所有连接
+    // 关闭所有连接，包括已分发但尚未接管的连接
     for (auto& conn : connections_) {
         if (conn) {
             conn->Destroy();
         }
     }
     connections_.clear();
+    while (!pending_connections_.empty()) {
+        rejectConnection(pending_connections_.front().fd, pending_connections_.front().addr);
+        pending_connections_.pop();
+    }
     
     if (epoll_fd_ >= 0) {
         close(epoll_fd_);
@@ -120,6 +161,196 @@ void SubReactor::addConnection(int client_fd, sockaddr_in client_addr) {
     }
 }
 
+void SubReactor::queueInLoop(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_tasks_.push_back(std::move(task));
+    }
+
+    // 唤醒 epoll_wait
+    uint64_t val = 1;
+    ssize_t n = write(wakeup_fd_, &val, sizeof(val));
+    if (n != sizeof(val)) {
+        LOG_ERROR("[SubReactor {}] Failed to wake up: {}", id_, strerror(errno));
+    }
+}
+
+void SubReactor::doPendingTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        tasks.swap(pending_tasks_);
+    }
+
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void SubReactor::runAfter(std::chrono::milliseconds delay, std::function<void()> cb) {
+    timer_wheel_.addTimer(static_cast<double>(delay.count()) / 1000.0, std::move(cb));
+}
+
+uint64_t SubReactor::watchFd(int fd, uint32_t events, std::function<void(uint32_t)> cb) {
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        throw std::runtime_error(std::string("epoll_ctl add watched fd failed: ") + strerror(errno));
+    }
+    uint64_t id = ++watch_seq_;
+    watchers_[fd] = Watcher {id, std::move(cb)};
+    return id;
+}
+
+bool SubReactor::unwatchFd(int fd, uint64_t id) {
+    auto it = watchers_.find(fd);
+    if (it == watchers_.end() || it->second.id != id) {
+        return false;
+    }
+    watchers_.erase(it);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    return true;
+}
+
+void SubReactor::handleWatched(int fd, uint32_t revents) {
+    auto it = watchers_.find(fd);
+    auto cb = std::move(it->second.cb);
+    watchers_.erase(it);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    cb(revents);
+}
+
+void SubReactor::scheduleReadahead(int fd) {
+    auto& http_conn = connections_[fd];
+    int file_fd = -1;
+    OutputBuffer::ReadaheadHint hint;
+    if (!http_conn || !http_conn->TakeReadahead(file_fd, hint)) {
+        return;
+    }
+
+    uint64_t generation = http_conn->Generation();
+    FThreadPool::getIoInst().pushTask([this, link = link_, id = id_, fd, generation, file_fd, hint](size_t) {
+        // I/O 线程上阻塞读盘，只填充 page cache；读的是连接已打开文件的副本，不按路径重新打开
+        if (file_fd >= 0) {
+            // readahead 只发起 I/O、可能在数据到达前返回；随后顺序 pread 整个窗口，等数据真正进入 page cache
+            posix_fadvise(file_fd, hint.offset, static_cast<off_t>(hint.length), POSIX_FADV_WILLNEED);
+            thread_local std::vector<char> sink(256 * 1024);
+            for (size_t done = 0; done < hint.length;) {
+                size_t want = std::min(sink.size(), hint.length - done);
+                ssize_t n = pread(file_fd, sink.data(), want, hint.offset + static_cast<off_t>(done));
+                if (n <= 0) {
+                    break;
+                }
+                done += static_cast<size_t>(n);
+            }
+            close(file_fd);
+        } else {
+            LOG_ERROR("[SubReactor {}] Readahead skipped, no file descriptor for fd:{}", id, fd);
+        }
+
+        // reactor 已销毁时丢弃（文件副本已关闭）
+        link->queueInLoop([this, fd, generation]() {
+            // 连接已关闭或 fd 槽位已被新连接复用
+            if (!connections_[fd] || connections_[fd]->Generation() != generation) {
+                return;
+            }
+            if (!connections_[fd]->ResumeAfterReadahead()) {
+                scheduleReadahead(fd); // 窗口仍未常驻，再预读一次
+                return;
+            }
+            handleWrite(fd);
+        });
+    });
+}
+
+void SubReactor::dispatchOffload(int fd, std::unique_ptr<HttpConnection::OffloadJob> job) {
+    // 完成回调要求可拷贝，任务以 shared_ptr 持有
+    std::shared_ptr<HttpConnection::OffloadJob> shared_job(std::move(job));
+    if (shared_job->coroutine) {
+        dispatchCoroutine(fd, std::move(shared_job));
+        return;
+    }
+    dispatchCacheWait(fd, std::move(shared_job));
+}
+
+void SubReactor::dispatchRevalidation(std::unique_ptr<HttpConnection::OffloadJob> job) {
+    std::shared_ptr<HttpConnection::OffloadJob> shared_job(std::move(job));
+    // 本轮已准备好的应答先发出，刷新随后在本线程执行
+    queueInLoop([shared_job]() {
+        HttpConnection::RunOffload(*shared_job);
+        shared_job->permit.release(static_cast<int>(shared_job->response.status()) >= 500);
+    });
+}
+
+void SubReactor::dispatchCoroutine(int fd, std::shared_ptr<HttpConnection::OffloadJob> job) {
+    coroutine_total_.add();
+    uint64_t generation = connections_[fd]->Generation();
+    // 协程帧引用 job 中的请求与响应，job 由完成回调持有到协程结束；
+    // 同步结束的协程也经 queueInLoop 交还，避免在 handleRead 中途改动连接
+    Coro::spawn(HttpConnection::RunCoroutine(*job), [this, fd, generation, job](std::exception_ptr) {
+        queueInLoop([this, fd, generation, job]() {
+            if (!connections_[fd] || connections_[fd]->Generation() != generation) {
+                offload_stale_.add();
+                return;
+            }
+            connections_[fd]->CompleteOffload(*job);
+            handleWrite(fd);
+        });
+    });
+}
+
+void SubReactor::dispatchCacheWait(int fd, std::shared_ptr<HttpConnection::OffloadJob> job) {
+    uint64_t generation = connections_[fd]->Generation();
+    auto flight = std::move(job->awaiting);
+    // 回调可能在本线程立即执行，也可能在完成计算的线程上执行，统一经 queueInLoop 交还
+    flight->wait([this, link = link_, fd, generation, job](const MicroCache::EntryPtr& entry) {
+        link->queueInLoop([this, fd, generation, job, entry]() {
+            if (!connections_[fd] || connections_[fd]->Generation() != generation) {
+                offload_stale_.add();
+                return;
+            }
+            if (entry) {
+                MicroCache::serve(entry, job->response);
+            } else {
+                // 那次计算失败且没有可用的旧响应
+                job->response.set_error_page(HttpStatus::SERVICE_UNAVAILABLE);
+                job->response.add_header("Retry-After", "1");
+            }
+            connections_[fd]->CompleteOffload(*job);
+            handleWrite(fd);
+        });
+    });
+}
+
+void SubReactor::pushReady(int fd, bool write) {
+    if (!connections_[fd]) {
+        return;
+    }
+    if (write) {
+        write_budget_exhausted_.add();
+    } else {
+        read_budget_exhausted_.add();
+    }
+    ready_list_.push_back({fd, connections_[fd]->Generation(), write});
+}
+
+void SubReactor::runReadyList() {
+    // 交换出来处理，本轮再次耗尽预算的连接进入下一轮，保证轮转公平
+    ready_running_.swap(ready_list_);
+    for (const auto& entry : ready_running_) {
+        if (!connections_[entry.fd] || connections_[entry.fd]->Generation() != entry.generation) {
+            continue; // 连接已关闭或 fd 槽位已被复用
+        }
+        if (entry.write) {
+            handleWrite(entry.fd);
+        } else {
+            handleRead(entry.fd);
+        }
+    }
+    ready_running_.clear();
+}
+
 void SubReactor::handleNewConnection() {
     // 读取 eventfd（清空计数）
     uint64_t val;
@@ -138,6 +369,7 @@ void SubReactor::handleNewConnection() {
         
         if (client_fd < 0 || client_fd >= MAX_FD) {
             LOG_ERROR("[SubReactor {}] Invalid fd: {}", id_, client_fd);
+            rejectConnection(client_fd, client_addr);
             continue;
         }
         
@@ -175,19 +407,17 @@ void SubReactor::handleRead(int fd) {
     auto& http_conn = connections_[fd];
     
     if (http_conn->ReadOnce()) {
-        if (use_thread_pool_) {
-            FThreadPool::getInst().pushTask([this, fd = fd]() {
-                if (connections_[fd]) {
-                    connections_[fd]->ProcessHttp();
-                }
-            });
-
+        // 直接在当前线程处理 HTTP 请求，避免线程切换开销；阻塞调用由协程路由交给线程池
+        http_conn->ProcessHttp();
+        if (auto job = http_conn->TakeRevalidation()) {
+            dispatchRevalidation(std::move(job));
+        }
+        if (auto job = http_conn->TakeOffload()) {
+            dispatchOffload(fd, std::move(job));
             if (timer) {
                 timer_wheel_.refresh(timer);
             }
         } else {
-            // 优化：直接在当前线程处理 HTTP 请求，避免线程池切换开销
-            http_conn->ProcessHttp();
 
             // 处理完后立即尝试写入响应
             if (http_conn->WriteOnce()) {
@@ -195,6 +425,12 @@ void SubReactor::handleRead(int fd) {
                 if (timer) {
                     timer_wheel_.refresh(timer);
                 }
+                if (http_conn->ReadBudgetExhausted()) {
+                    pushReady(fd, false);
+                } else if (http_conn->WriteBudgetExhausted()) {
+                    pushReady(fd, true);
+                }
+                scheduleReadahead(fd);
             } else {
                 // 写完成或失败，关闭连接
                 if (timer) {
@@ -233,6 +469,10 @@ void SubReactor::handleWrite(int fd) {
         if (timer) {
             timer_wheel_.refresh(timer);
         }
+        if (http_conn->WriteBudgetExhausted()) {
+            pushReady(fd, true);
+        }
+        scheduleReadahead(fd);
     } else {
         // 写完成或失败，关闭连接并释放内存
         if (timer) {
@@ -247,13 +487,15 @@ void SubReactor::handleWrite(int fd) {
 
 void SubReactor::eventLoop() {
     LOG_DEBUG("[SubReactor {}] Event loop started", id_);
+    tls_current_ = this;
     
     std::vector<epoll_event> events(1024);
     
     while (running_.load()) {
-        // 使用 timer_wheel_ 计算超时时间，避免长时间阻塞
-        int timeout = timer_wheel_.nextTimeoutMs();
+        // 使用 timer_wheel_ 计算超时时间，避免长时间阻塞；就绪队列非空时不阻塞
+        int timeout = ready_list_.empty() ? timer_wheel_.nextTimeoutMs() : 0;
         int num_events = epoll_wait(epoll_fd_, events.data(), events.size(), timeout);
+        auto busy_start = std::chrono::steady_clock::now();
         
         if (num_events < 0) {
             if (errno == EINTR) {
@@ -268,18 +510,28 @@ void SubReactor::eventLoop() {
             int fd = events[i].data.fd;
             
             if (fd == wakeup_fd_) {
-                // 新连接通知
+                // 新连接通知 / 跨线程任务
                 handleNewConnection();
+                doPendingTasks();
+            } else if (!watchers_.empty() && watchers_.count(fd)) {
+                handleWatched(fd, events[i].events);
             } else if (events[i].events & EPOLLIN) {
                 handleRead(fd);
             } else if (events[i].events & EPOLLOUT) {
                 handleWrite(fd);
             }
         }
+
+        // 上一轮及本轮预算耗尽的连接，在其他就绪事件之后恢复
+        runReadyList();
         
         // 定时器 tick（每个 SubReactor 独立管理，无锁！）
         timer_wheel_.tick();
+
+        loop_us_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - busy_start).count()));
     }
     
+    tls_current_ = nullptr;
     LOG_DEBUG("[SubReactor {}] Event loop stopped", id_);
 }
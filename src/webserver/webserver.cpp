@@ -9,6 +9,12 @@
 #include "logger.h"
 #include "config_manager.h"
 #include "user_service.h"
+#include "compressed_cache.h"
+#include "compression.h"
+#include "concurrency_limiter.h"
+#include "asset_pack.h"
+#include "rate_limiter.h"
+#include "session_token.h"
 
 #include <arpa/inet.h>
 #include <cstring>
@@ -17,7 +23,10 @@
 #include <netinet/in.h>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
+#include <csignal>
 #include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <vector>
@@ -27,6 +36,8 @@
 #include "http_controller.h"
 #include "http_request.h"
 #include "http_response.h"
+#include "mime_types.h"
+#include "mysql_async.h"
 #include "static_file_controller.h"
 
 void EpollServer::initLogger() {
@@ -87,53 +98,308 @@ void EpollServer::initEpoll() {
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev) == -1) {
         throw std::runtime_error("Failed to add server socket to epoll");
     }
+
+    // SIGHUP 重新加载资源包：信号已在构造函数开头屏蔽，这里经 signalfd 交给 MainReactor 同步处理
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    signal_fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd_ == -1) {
+        throw std::runtime_error("Failed to create signalfd");
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = signal_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, signal_fd_, &ev) == -1) {
+        throw std::runtime_error("Failed to add signalfd to epoll");
+    }
+}
+
+// 打开并替换资源包；失败时保留当前包，正在发送的响应持有旧包引用直到发送完成
+void EpollServer::loadAssetPack() {
+    std::string error;
+    if (auto pack = AssetPack::Pack::open(asset_pack_path_, error)) {
+        LOG_INFO("[EpollServer] Asset pack {} loaded, {} assets", asset_pack_path_, pack->size());
+        AssetPack::Pack::install(std::move(pack));
+    } else if (AssetPack::Pack::current()) {
+        LOG_ERROR("[EpollServer] Failed to reload asset pack {}: {}, keeping the current pack", asset_pack_path_, error);
+    } else {
+        LOG_ERROR("[EpollServer] Failed to load asset pack {}: {}, serving from document root", asset_pack_path_, error);
+    }
+}
+
+void EpollServer::handleSignals() {
+    signalfd_siginfo info;
+    bool reload = false;
+    while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+        reload |= info.ssi_signo == SIGHUP;
+    }
+    if (reload && !asset_pack_path_.empty()) {
+        LOG_INFO("[MainReactor] SIGHUP received, reloading asset pack");
+        loadAssetPack();
+    }
 }
 
 void EpollServer::initRouter() {
     auto& router = HttpRouter::instance();
     router.RegisterRoutes();
+
+    // 登录 / 注册改走 reactor 上的非阻塞 MySQL 客户端（替换默认的哈希线程池协程路由），只用于 MySQL 存储
+    auto& config_manager = ConfigManager::Instance();
+    if (config_manager.get<bool>("mysql.async", false) &&
+        config_manager.get<std::string>("user_store.backend", "mysql") == "mysql") {
+        MySQLAsync::init(config_manager.get<int>("mysql.async_pool_size", 4),
+                         std::chrono::seconds(config_manager.get<int>("mysql.read_timeout", 30)),
+                         std::chrono::milliseconds(config_manager.get<int>("mysql.acquire_timeout_ms", 1000)));
+        router.post_co("/login", HttpController::handleLoginAsync);
+        router.post_co("/register", HttpController::handleRegisterAsync);
+    }
+
+    // 访问用户存储的路由共用一个隔离舱：数据库变慢时多出的请求立即 503，不拖住线程池与静态资源
+    if (config_manager.get<bool>("bulkhead.enabled", true)) {
+        ConcurrencyLimiter::Options options;
+        options.limit = config_manager.get<int>("bulkhead.auth_limit", 32);
+        options.adaptive = config_manager.get<bool>("bulkhead.adaptive", true);
+        options.min_limit = config_manager.get<int>("bulkhead.min_limit", 4);
+        options.max_limit = config_manager.get<int>("bulkhead.max_limit", 256);
+        options.window = std::chrono::milliseconds(config_manager.get<int>("bulkhead.window_ms", 250));
+        auto auth = std::make_shared<ConcurrencyLimiter>("auth", options);
+        router.set_bulkhead("/login", auth);
+        router.set_bulkhead("/register", auth);
+    }
+
+    // 响应微缓存：只对显式列出的 GET 路由开启（默认不开启任何路由）
+    size_t cache_mb = static_cast<size_t>(std::max(0, config_manager.get<int>("micro_cache.max_mb", 32)));
+    MicroCache::Instance().init(cache_mb * 1024 * 1024);
+    MicroCache::Policy policy;
+    policy.ttl = std::chrono::milliseconds(config_manager.get<int>("micro_cache.ttl_ms", 100));
+    policy.stale_while_revalidate =
+        std::chrono::milliseconds(config_manager.get<int>("micro_cache.stale_while_revalidate_ms", 1000));
+    policy.stale_if_error = std::chrono::milliseconds(config_manager.get<int>("micro_cache.stale_if_error_ms", 10000));
+    std::string vary = config_manager.get<std::string>("micro_cache.vary", "Accept-Encoding");
+    for (std::string_view rest = vary; !rest.empty();) {
+        size_t comma = rest.find(',');
+        if (!rest.substr(0, comma).empty()) {
+            policy.vary.emplace_back(rest.substr(0, comma));
+        }
+        rest = comma == std::string_view::npos ? std::string_view {} : rest.substr(comma + 1);
+    }
+    std::string cached_routes = config_manager.get<std::string>("micro_cache.routes", "");
+    for (std::string_view rest = cached_routes; !rest.empty();) {
+        size_t comma = rest.find(',');
+        if (!rest.substr(0, comma).empty()) {
+            router.set_micro_cache(std::string(rest.substr(0, comma)), policy);
+            LOG_INFO("[EpollServer] Micro-cache enabled for {}, ttl {}ms", rest.substr(0, comma), policy.ttl.count());
+        }
+        rest = comma == std::string_view::npos ? std::string_view {} : rest.substr(comma + 1);
+    }
 }
 
 void EpollServer::initHttpPreHandlers() {
-    HttpConnection::add_pre_handler([](const HttpRequest& req, HttpResponse& resp) {
+    auto& config_manager = ConfigManager::Instance();
+    auto& router = HttpRouter::instance();
+
+    // 每个请求都要经过的两个检查在编译期合成一个阶段
+    auto keep_alive = [](const HttpRequest& req, HttpResponse& resp) {
         bool keep_alive = (req.version() == "HTTP/1.1" && req.keep_alive()) ||
                           (req.version() == "HTTP/1.0" && req.keep_alive());
 
         resp.set_keep_alive(keep_alive);
-    });
-
-    HttpConnection::add_pre_handler([](const HttpRequest& req, HttpResponse& resp) {
+    };
+    auto require_host = [](const HttpRequest& req, HttpResponse& resp) {
         if (req.host().empty()) {
             resp.set_status(HttpStatus::BAD_REQUEST);
             resp.set_body("Host header is required");
+            return false;
         }
-    });
+        return true;
+    };
+    HttpConnection::add_pre_handler(compose_middleware(keep_alive, require_host));
+
+    // 按客户端地址限流：在 keep-alive 判定之后，超限请求不再往下走
+    RateLimiter::Options limits;
+    limits.enabled = config_manager.get<bool>("rate_limit.enabled", false);
+    limits.rate = static_cast<uint32_t>(config_manager.get<int>("rate_limit.rate", 500));
+    limits.burst = static_cast<uint32_t>(config_manager.get<int>("rate_limit.burst", 1000));
+    limits.credential_rate = static_cast<uint32_t>(config_manager.get<int>("rate_limit.login_rate", 5));
+    limits.credential_burst = static_cast<uint32_t>(config_manager.get<int>("rate_limit.login_burst", 10));
+    limits.max_connections = static_cast<uint32_t>(config_manager.get<int>("rate_limit.max_connections_per_ip", 0));
+    limits.table_sets = static_cast<size_t>(config_manager.get<int>("rate_limit.table_sets", 4096));
+    std::string exempt = config_manager.get<std::string>("rate_limit.exempt", "127.0.0.1");
+    for (std::string_view rest = exempt; !rest.empty();) {
+        size_t comma = rest.find(',');
+        std::string ip(rest.substr(0, comma));
+        rest = comma == std::string_view::npos ? std::string_view {} : rest.substr(comma + 1);
+        in_addr addr {};
+        if (inet_pton(AF_INET, ip.c_str(), &addr) == 1) {
+            limits.exempt.push_back(addr.s_addr);
+        } else if (!ip.empty()) {
+            LOG_WARN("[EpollServer] Ignoring invalid rate limit exemption: {}", ip);
+        }
+    }
+    RateLimiter::Instance().init(limits);
+
+    if (limits.enabled) {
+        auto limit = [](RateLimiter::Bucket bucket) {
+            return [bucket](const HttpRequest& req, HttpResponse& resp) {
+                if (RateLimiter::Instance().allow(req.client_addr(), bucket)) {
+                    return true;
+                }
+                // 429 的响应头块与响应体为静态常量，只补 Content-Length / Connection，不做格式化
+                static constexpr std::string_view kHeaders = "Content-Type: text/plain\r\nRetry-After: 1\r\n";
+                static const auto kBody = std::make_shared<const std::string>("Too Many Requests\n");
+                resp.set_status(HttpStatus::TOO_MANY_REQUESTS);
+                resp.set_raw_headers(kHeaders);
+                resp.set_shared_body(kBody);
+                return false;
+            };
+        };
+        HttpConnection::add_pre_handler(limit(RateLimiter::Bucket::Default));
+        // 登录 / 注册（口令哈希开销大）另有一个更严的桶，只挂在这两个路由上
+        router.before("/login", HttpRequest::Method::POST, limit(RateLimiter::Bucket::Credential));
+        router.before("/register", HttpRequest::Method::POST, limit(RateLimiter::Bucket::Credential));
+    }
 
+    // 会话：登录签发 HMAC 签名的 Cookie，受保护页面在这里校验（只做一次 HMAC，不访问存储），无效时跳转登录页
+    auto& session = SessionToken::Instance();
+    session.setTtl(config_manager.get<int>("session.ttl_s", 86400));
+    session.setCookie(config_manager.get<std::string>("session.cookie", "sid"),
+                      config_manager.get<bool>("session.secure", false));
+    auto keys = SessionToken::parseKeys(config_manager.get<std::string>("session.keys", ""));
+    if (keys.empty()) {
+        LOG_WARN("[EpollServer] No session keys configured, sessions will not survive a restart");
+    } else if (!session.setKeys(keys, config_manager.get<std::string>("session.active_key", ""))) {
+        throw std::runtime_error("invalid session key configuration");
+    }
 
+    auto require_session = [](const HttpRequest& req, HttpResponse& resp) {
+        auto& session = SessionToken::Instance();
+        auto it = req.headers().find("Cookie");
+        if (it != req.headers().end() &&
+            session.verify(session.findCookie(it->second)) == SessionToken::Result::Valid) {
+            return true;
+        }
+        resp.set_status(HttpStatus::FOUND);
+        resp.add_header("Location", "/login");
+        resp.add_header("Cache-Control", "no-store");
+        resp.set_handled();
+        return false;
+    };
+    std::string paths = config_manager.get<std::string>("session.protected", "/welcome,/welcome.html");
+    for (std::string_view rest = paths; !rest.empty();) {
+        size_t comma = rest.find(',');
+        if (!rest.substr(0, comma).empty()) {
+            router.before(std::string(rest.substr(0, comma)), HttpRequest::Method::GET, require_session);
+        }
+        rest = comma == std::string_view::npos ? std::string_view {} : rest.substr(comma + 1);
+    }
 }
 
 void EpollServer::initHttpPostHandlers() {
-    HttpConnection::add_post_handler([](const HttpRequest& req, HttpResponse& resp) {
-        // mmp默认不设置body，这里html会被设置成plain，url上也看不出html特征
-        // if (resp.body().starts_with("<!DOCTYPE html") ||
-        //     req.uri().ends_with(".html")) {
-        //     resp.add_header("Content-Type", "text/html");
-        // } else if (req.uri().ends_with(".js")) {
-        //     resp.add_header("Content-Type", "application/javascript");
-        // } else if (req.uri().ends_with(".css")) {
-        //     resp.add_header("Content-Type", "text/css");
-        // } else {
-        //     resp.add_header("Content-Type", "text/plain");
-        // }
+    auto& config_manager = ConfigManager::Instance();
+    if (!config_manager.get<bool>("server.compression", true)) {
+        return;
+    }
+
+    // 动态响应体压缩：只处理中小文本（同步压缩在 reactor 线程上，大响应体不做以免拖慢同一 reactor 上的其他连接）
+    size_t min_bytes = static_cast<size_t>(config_manager.get<int>("server.compress_min_bytes", 1024));
+    size_t max_bytes = static_cast<size_t>(config_manager.get<int>("server.compress_inline_max_kb", 64)) * 1024;
+    int gzip_level = config_manager.get<int>("server.gzip_level", 6);
+    int zstd_level = config_manager.get<int>("server.zstd_level", 3);
+
+    HttpConnection::add_post_handler([=](const HttpRequest& req, HttpResponse& resp) {
+        const std::string& body = resp.body();
+        if (body.size() < min_bytes || body.size() > max_bytes || resp.has_header("Content-Encoding")) {
+            return;
+        }
+        const std::string* content_type = resp.header("Content-Type");
+        if (!content_type) {
+            return;
+        }
+        std::string_view mime = *content_type;
+        mime = mime.substr(0, mime.find(';'));
+        if (!MimeTypes::isTextType(mime)) {
+            return;
+        }
+
+        resp.add_header("Vary", "Accept-Encoding");
+        auto it = req.headers().find("Accept-Encoding");
+        if (it == req.headers().end()) {
+            return;
+        }
+        auto encoding = Compression::negotiate(it->second);
+        if (encoding == Compression::Encoding::IDENTITY) {
+            return;
+        }
+
+        std::string compressed;
+        int level = encoding == Compression::Encoding::ZSTD ? zstd_level : gzip_level;
+        if (Compression::compress(encoding, body, compressed, level) && compressed.size() < body.size()) {
+            resp.set_body(std::move(compressed));
+            resp.add_header("Content-Encoding", std::string(Compression::name(encoding)));
+        }
     });
 }
 
 EpollServer::EpollServer(const std::string &host, int port, int sub_reactor_count) 
     : host_(host), port_(port) {
 
+    // 在创建任何线程之前屏蔽 SIGHUP，所有线程继承该掩码，信号只经 MainReactor 的 signalfd 读取
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
     auto& config_manager = ConfigManager::Instance();
     // Init config
     HttpConnection::set_use_sendfile(config_manager.get<bool>("server.use_sendfile", true));
+    HttpConnection::set_io_budget(
+        static_cast<size_t>(config_manager.get<int>("server.io_budget_kb", 512)) * 1024,
+        config_manager.get<int>("server.io_budget_iterations", 16));
+    // 协程路由交给线程池的调用（存储访问等）受此时限约束
+    HttpConnection::set_offload_timeout(config_manager.get<int>("server.offload_timeout_ms", 3000));
+    HttpConnection::set_readahead(
+        static_cast<size_t>(config_manager.get<int>("server.readahead_window_kb", 2048)) * 1024,
+        static_cast<size_t>(config_manager.get<int>("server.readahead_min_kb", 1024)) * 1024);
+
+    // 大文件限速（KiB/s，即 1024 字节/秒，0 为不限速）与顺序读提示
+    LargeFilePolicy large_file_policy;
+    large_file_policy.min_bytes = static_cast<size_t>(config_manager.get<int>("server.large_file_kb", 1024)) * 1024;
+    large_file_policy.prefetch_window =
+            static_cast<size_t>(config_manager.get<int>("server.readahead_window_kb", 2048)) * 1024;
+    large_file_policy.video_rate =
+            static_cast<uint32_t>(config_manager.get<int>("server.pacing_video_kib_per_s", 0)) * 1024;
+    large_file_policy.audio_rate =
+            static_cast<uint32_t>(config_manager.get<int>("server.pacing_audio_kib_per_s", 0)) * 1024;
+    large_file_policy.image_rate =
+            static_cast<uint32_t>(config_manager.get<int>("server.pacing_image_kib_per_s", 0)) * 1024;
+    large_file_policy.default_rate =
+            static_cast<uint32_t>(config_manager.get<int>("server.pacing_default_kib_per_s", 0)) * 1024;
+    HttpConnection::set_large_file_policy(large_file_policy);
+
+    // 静态资源压缩：预压缩文件 / 压缩缓存（后台线程池生成）
+    StaticFileController::set_compression(
+        config_manager.get<bool>("server.compression", true),
+        static_cast<size_t>(config_manager.get<int>("server.compress_min_bytes", 1024)));
+    // 静态文件元数据缓存：HEAD / 条件请求在有效期内直接用缓存的头部应答
+    StaticFileController::set_meta_ttl(config_manager.get<int>("server.static_meta_ttl_ms", 1000));
+    // 资源包：启动时整体 mmap，包内资源不再逐个访问文件系统；部署新包后发 SIGHUP 整体替换
+    if (auto pack_path = config_manager.get<std::string>("server.asset_pack", ""); !pack_path.empty()) {
+        if (!pack_path.starts_with("/")) {
+            pack_path = std::string(PROJECT_ROOT_DIR) + "/" + pack_path;
+        }
+        asset_pack_path_ = std::move(pack_path);
+        loadAssetPack();
+    }
+
+    // 资源指纹：启动时哈希 docroot，页面中的资源引用改写为可永久缓存的 /static/<hash>/ 别名
+    if (config_manager.get<bool>("server.fingerprint_assets", false)) {
+        StaticFileController::enableFingerprints();
+    }
+
+    CompressedCache::Instance().init(
+        static_cast<size_t>(config_manager.get<int>("server.compress_cache_mb", 64)) * 1024 * 1024,
+        config_manager.get<int>("server.gzip_level", 6),
+        config_manager.get<int>("server.zstd_level", 3));
 
     initHttpPreHandlers();
     initHttpPostHandlers();
@@ -161,6 +427,7 @@ EpollServer::~EpollServer() {
     sub_reactors_.clear();
     
     close(server_fd_);
+    close(signal_fd_);
     close(epoll_fd_);
     LOG_INFO("[MainReactor] Shutdown complete");
 }
@@ -201,12 +468,14 @@ void EpollServer::eventloop() {
             break;
         }
 
-        // MainReactor 只处理 accept
+        // MainReactor 只处理 accept 与 SIGHUP
         for (int i = 0; i < num_events; ++i) {
             int fd = events[i].data.fd;
 
             if (fd == server_fd_) {
                 acceptConnections();
+            } else if (fd == signal_fd_) {
+                handleSignals();
             }
         }
         
@@ -236,15 +505,13 @@ void EpollServer::acceptConnections() {
             return;
         }
 
-        // 记录客户端 IP（调试用）
-        {
-            auto client_ip = std::string(inet_ntoa(client_addr.sin_addr));
-            if (!client_ips_.contains(client_ip)) {
-                client_ips_.insert(client_ip);
-                LOG_INFO("[MainReactor] New client IP: {}", client_ip);
-            }
+        // 每地址并发连接上限：超出直接关闭，名额在连接销毁时归还
+        if (!RateLimiter::Instance().acquireConnection(client_addr.sin_addr.s_addr)) {
+            LOG_DEBUG("[MainReactor] Too many connections from one client, closing fd:{}", client_fd);
+            close(client_fd);
+            continue;
         }
-        
+
         // 选择一个 SubReactor 并分发连接
         SubReactor* reactor = selectSubReactor();
         reactor->addConnection(client_fd, client_addr);
@@ -0,0 +1,196 @@
+#include "concurrency_limiter.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+// 绕过 Permit 的计时，直接以指定的在途数与延迟喂入一次 release
+class ConcurrencyLimiterTest {
+public:
+    static void sample(ConcurrencyLimiter& limiter, int latency_us, int inflight, bool failed = false) {
+        limiter.inflight_.fetch_add(inflight);
+        limiter.onRelease(std::chrono::microseconds(latency_us), true, failed);
+        limiter.inflight_.fetch_sub(inflight - 1);
+    }
+};
+
+// 窗口长度为 0 时每个样本单独成一个窗口，调整过程与时钟无关
+static ConcurrencyLimiter::Options adaptiveOptions(int limit, int min_limit, int max_limit) {
+    ConcurrencyLimiter::Options options;
+    options.limit = limit;
+    options.adaptive = true;
+    options.min_limit = min_limit;
+    options.max_limit = max_limit;
+    options.window = std::chrono::milliseconds(0);
+    options.min_samples = 1;
+    return options;
+}
+
+void testFixedLimit() {
+    std::cout << "Testing Fixed Limit..." << std::endl;
+
+    ConcurrencyLimiter::Options options;
+    options.limit = 2;
+    ConcurrencyLimiter limiter("test_fixed", options);
+
+    auto first = limiter.tryAcquire();
+    auto second = limiter.tryAcquire();
+    assert(first && second);
+    assert(!limiter.tryAcquire());
+    assert(limiter.inflight() == 2);
+
+    // 显式 release 与析构都归还名额
+    first.release(false);
+    assert(!first);
+    assert(limiter.inflight() == 1);
+    {
+        auto third = limiter.tryAcquire();
+        assert(third);
+        assert(!limiter.tryAcquire());
+    }
+    assert(limiter.inflight() == 1);
+
+    // 移动后只归还一次
+    ConcurrencyLimiter::Permit moved = std::move(second);
+    assert(!second && moved);
+    moved = ConcurrencyLimiter::Permit();
+    assert(limiter.inflight() == 0);
+
+    // 非自适应时延迟与失败都不改变上限
+    for (int i = 0; i < 100; ++i) {
+        ConcurrencyLimiterTest::sample(limiter, 1000000, 2, true);
+    }
+    assert(limiter.limit() == 2);
+    assert(limiter.inflight() == 0);
+
+    std::cout << "Fixed limit test passed." << std::endl;
+}
+
+void testGrowWhenIdle() {
+    std::cout << "Testing Grow When Idle..." << std::endl;
+
+    ConcurrencyLimiter limiter("test_grow", adaptiveOptions(10, 4, 40));
+
+    // 延迟维持在空载水平且上限被用满：逐窗口加一
+    for (int i = 1; i <= 5; ++i) {
+        ConcurrencyLimiterTest::sample(limiter, 1000, limiter.limit());
+        assert(limiter.limit() == 10 + i);
+    }
+
+    // 上限远未用到时不放大
+    for (int i = 0; i < 20; ++i) {
+        ConcurrencyLimiterTest::sample(limiter, 1000, 2);
+    }
+    assert(limiter.limit() == 15);
+
+    // 持续放大直到 max_limit
+    for (int i = 0; i < 100; ++i) {
+        ConcurrencyLimiterTest::sample(limiter, 1000, limiter.limit());
+        assert(limiter.limit() <= 40);
+    }
+    assert(limiter.limit() == 40);
+    assert(limiter.inflight() == 0);
+
+    std::cout << "Grow when idle test passed." << std::endl;
+}
+
+void testShrinkOnLatency() {
+    std::cout << "Testing Shrink On Latency..." << std::endl;
+
+    ConcurrencyLimiter limiter("test_latency", adaptiveOptions(40, 4, 40));
+
+    // 建立 1ms 的空载延迟
+    ConcurrencyLimiterTest::sample(limiter, 1000, 40);
+    assert(limiter.limit() == 40);
+
+    // 延迟翻倍：估算排队 limit / 2 个请求，逐窗口收缩
+    int previous = limiter.limit();
+    ConcurrencyLimiterTest::sample(limiter, 2000, 40);
+    assert(limiter.limit() < previous);
+
+    // 延迟持续膨胀时一路收缩，不低于 min_limit（空载延迟每 100 个窗口重新取样，这里不跨过）
+    for (int i = 0; i < 50; ++i) {
+        previous = limiter.limit();
+        ConcurrencyLimiterTest::sample(limiter, 50000, limiter.limit());
+        assert(limiter.limit() <= previous);
+        assert(limiter.limit() >= 4);
+    }
+    assert(limiter.limit() < 12);
+
+    // 延迟恢复后重新放大
+    previous = limiter.limit();
+    ConcurrencyLimiterTest::sample(limiter, 1000, limiter.limit());
+    assert(limiter.limit() > previous);
+
+    std::cout << "Shrink on latency test passed." << std::endl;
+}
+
+void testShrinkOnFailure() {
+    std::cout << "Testing Shrink On Failure..." << std::endl;
+
+    ConcurrencyLimiter limiter("test_failure", adaptiveOptions(20, 4, 40));
+
+    // 延迟正常但窗口内全部失败：乘性收缩（20 -> 18 -> 16 -> 14）
+    ConcurrencyLimiterTest::sample(limiter, 1000, 20, true);
+    assert(limiter.limit() == 18);
+    ConcurrencyLimiterTest::sample(limiter, 1000, 20, true);
+    assert(limiter.limit() == 16);
+    ConcurrencyLimiterTest::sample(limiter, 1000, 20, true);
+    assert(limiter.limit() == 14);
+
+    // 不低于 min_limit
+    for (int i = 0; i < 100; ++i) {
+        ConcurrencyLimiterTest::sample(limiter, 1000, limiter.limit(), true);
+        assert(limiter.limit() >= 4);
+    }
+    assert(limiter.limit() == 4);
+
+    // 失败停止后恢复增长
+    ConcurrencyLimiterTest::sample(limiter, 1000, 4);
+    assert(limiter.limit() == 5);
+
+    std::cout << "Shrink on failure test passed." << std::endl;
+}
+
+void testClampOptions() {
+    std::cout << "Testing Clamp Options..." << std::endl;
+
+    // 初始值超出 max_limit 时取 max_limit
+    ConcurrencyLimiter high("test_clamp_high", adaptiveOptions(1000, 4, 64));
+    assert(high.limit() == 64);
+    for (int i = 0; i < 10; ++i) {
+        ConcurrencyLimiterTest::sample(high, 1000, 64);
+    }
+    assert(high.limit() == 64);
+
+    // min_limit 大于初始值时下调到初始值
+    ConcurrencyLimiter low("test_clamp_low", adaptiveOptions(2, 8, 64));
+    assert(low.limit() == 2);
+    for (int i = 0; i < 10; ++i) {
+        ConcurrencyLimiterTest::sample(low, 1000, 2, true);
+    }
+    assert(low.limit() == 2);
+
+    // 非法上限至少为 1
+    ConcurrencyLimiter zero("test_clamp_zero", adaptiveOptions(0, 0, 0));
+    assert(zero.limit() == 1);
+    for (int i = 0; i < 10; ++i) {
+        ConcurrencyLimiterTest::sample(zero, 1000, 1, true);
+    }
+    assert(zero.limit() == 1);
+    auto permit = zero.tryAcquire();
+    assert(permit);
+    assert(!zero.tryAcquire());
+
+    std::cout << "Clamp options test passed." << std::endl;
+}
+
+int main() {
+    testFixedLimit();
+    testGrowWhenIdle();
+    testShrinkOnLatency();
+    testShrinkOnFailure();
+    testClampOptions();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
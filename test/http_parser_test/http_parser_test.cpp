@@ -0,0 +1,118 @@
+#include "http_parser.h"
+#include "http_request.h"
+#include "http_response.h"
+#include "http_router.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+static ParseResult parse(const std::string& target, HttpRequest& req) {
+    HttpRequestParser parser;
+    std::string raw = "GET " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    return parser.parse(raw, req);
+}
+
+void testNormalizeUri() {
+    std::cout << "Testing URI Normalization..." << std::endl;
+
+    struct Case {
+        const char* target;
+        const char* uri;
+    } cases[] = {
+        {"/welcome.html", "/welcome.html"},
+        {"/static/../welcome.html", "/welcome.html"},
+        {"/static/./../welcome.html?x=1", "/welcome.html"},
+        {"//welcome.html", "/welcome.html"},
+        {"/static/%2e%2e/welcome.html", "/welcome.html"},
+        {"http://localhost/static/../welcome", "/welcome"},
+    };
+    for (const auto& c : cases) {
+        HttpRequest req;
+        assert(parse(c.target, req) == ParseResult::OK);
+        assert(req.uri() == c.uri);
+    }
+
+    // .. 越过根目录、%00 与非法编码在解析时拒绝
+    for (const char* target : {"/../etc/passwd", "/static/../../etc/passwd", "/a%00b", "/a%zz"}) {
+        HttpRequest req;
+        assert(parse(target, req) == ParseResult::FORBIDDEN);
+    }
+
+    std::cout << "URI normalization test passed." << std::endl;
+}
+
+void testDotSegmentsHitRouteMiddleware() {
+    std::cout << "Testing Dot Segments Against Protected Route..." << std::endl;
+
+    auto& router = HttpRouter::instance();
+    router.get("/static/*", [](const HttpRequest&, HttpResponse& resp) { resp.set_status(HttpStatus::OK); });
+    router.get("/welcome.html", [](const HttpRequest&, HttpResponse& resp) { resp.set_status(HttpStatus::OK); });
+    router.before("/welcome.html", HttpRequest::Method::GET, [](const HttpRequest&, HttpResponse& resp) {
+        resp.set_status(HttpStatus::FOUND);
+        resp.add_header("Location", "/login");
+        resp.set_handled();
+        return false;
+    });
+
+    for (const char* target : {"/welcome.html", "/static/../welcome.html", "/static/%2E%2E/welcome.html"}) {
+        HttpRequest req;
+        assert(parse(target, req) == ParseResult::OK);
+        const RouteMiddleware* route = router.middleware(req);
+        assert(route != nullptr);
+
+        HttpResponse resp;
+        assert(!route->before.run(req, resp));
+        assert(resp.status() == HttpStatus::FOUND);
+    }
+
+    std::cout << "Dot segments test passed." << std::endl;
+}
+
+void testRouteOptionsKeepWildcardRoutes() {
+    std::cout << "Testing Route Options On Wildcard Routes..." << std::endl;
+
+    auto& router = HttpRouter::instance();
+    auto deny = [](const HttpRequest&, HttpResponse& resp) {
+        resp.set_status(HttpStatus::FORBIDDEN);
+        resp.set_handled();
+        return false;
+    };
+    // 挂在尚未注册（或由通配符路由服务）的路径上，不能把它变成没有处理函数的路由
+    router.before("/assets/private.png", HttpRequest::Method::GET, deny);
+    router.set_micro_cache("/assets/logo.png", MicroCache::Policy {});
+    router.before("*.zip", HttpRequest::Method::GET, deny);
+    router.get("*.png", [](const HttpRequest&, HttpResponse& resp) { resp.set_status(HttpStatus::OK); });
+    router.get("*.zip", [](const HttpRequest&, HttpResponse& resp) { resp.set_status(HttpStatus::OK); });
+
+    for (const char* target : {"/assets/private.png", "/assets/logo.png"}) {
+        HttpRequest req;
+        assert(parse(target, req) == ParseResult::OK);
+        HttpResponse resp;
+        assert(router.match(req, resp));
+        assert(resp.status() == HttpStatus::OK);
+    }
+
+    // 中间件按请求路径或实际命中的路由查找
+    HttpRequest req;
+    assert(parse("/assets/private.png", req) == ParseResult::OK);
+    assert(router.middleware(req) != nullptr);
+    assert(parse("/assets/public.png", req) == ParseResult::OK);
+    assert(router.middleware(req) == nullptr);
+    assert(parse("/downloads/a.zip", req) == ParseResult::OK);
+    const RouteMiddleware* route = router.middleware(req);
+    assert(route != nullptr);
+    HttpResponse resp;
+    assert(!route->before.run(req, resp));
+    assert(resp.status() == HttpStatus::FORBIDDEN);
+
+    std::cout << "Route options test passed." << std::endl;
+}
+
+int main() {
+    testNormalizeUri();
+    testDotSegmentsHitRouteMiddleware();
+    testRouteOptionsKeepWildcardRoutes();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "http_range.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using HttpRange::Result;
+
+static bool same(const HttpRange::ByteRange& range, size_t start, size_t length) {
+    return range.start == start && range.length == length;
+}
+
+void testSingleRange() {
+    std::cout << "Testing Single Range..." << std::endl;
+
+    HttpRange::RangeSet set;
+    assert(HttpRange::parse("bytes=0-99", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 100));
+
+    // 省略 last-byte-pos 与超出文件末尾的 last-byte-pos 都裁剪到文件末尾
+    assert(HttpRange::parse("bytes=900-", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 900, 100));
+    assert(HttpRange::parse("bytes=900-5000", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 900, 100));
+
+    // 单位大小写不敏感，允许 OWS
+    assert(HttpRange::parse("  BYTES=0-0 ", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 1));
+
+    std::cout << "Single range test passed." << std::endl;
+}
+
+void testSuffixRange() {
+    std::cout << "Testing Suffix Range..." << std::endl;
+
+    HttpRange::RangeSet set;
+    assert(HttpRange::parse("bytes=-100", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 900, 100));
+
+    // 后缀长度超过文件大小时返回整个文件
+    assert(HttpRange::parse("bytes=-5000", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 1000));
+
+    // 长度为 0 的后缀与空文件上的后缀都不可满足
+    assert(HttpRange::parse("bytes=-0", 1000, set) == Result::NOT_SATISFIABLE);
+    assert(HttpRange::parse("bytes=-100", 0, set) == Result::NOT_SATISFIABLE);
+
+    std::cout << "Suffix range test passed." << std::endl;
+}
+
+void testOverflow() {
+    std::cout << "Testing Overflow..." << std::endl;
+
+    // 超大数字饱和到 SIZE_MAX：作为 last-byte-pos 被裁剪，作为 first-byte-pos 不可满足
+    HttpRange::RangeSet set;
+    assert(HttpRange::parse("bytes=0-99999999999999999999999999", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 1000));
+    assert(HttpRange::parse("bytes=99999999999999999999999999-", 1000, set) == Result::NOT_SATISFIABLE);
+    assert(HttpRange::parse("bytes=-99999999999999999999999999", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 1000));
+
+    // 饱和后 first > last 的区间视为语法错误
+    assert(HttpRange::parse("bytes=99999999999999999999999999-5", 1000, set) == Result::IGNORE);
+
+    std::cout << "Overflow test passed." << std::endl;
+}
+
+void testCoalesce() {
+    std::cout << "Testing Coalesce..." << std::endl;
+
+    HttpRange::RangeSet set;
+    // 重复的整文件区间合并为一个，不会放大响应
+    assert(HttpRange::parse("bytes=0-,0-,0-,0-", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 1000));
+
+    // 存在重叠时按起点排序后合并
+    assert(HttpRange::parse("bytes=500-599,0-99,50-149", 1000, set) == Result::OK);
+    assert(set.count == 2);
+    assert(same(set.ranges[0], 0, 150));
+    assert(same(set.ranges[1], 500, 100));
+
+    // 相邻区间同样合并
+    assert(HttpRange::parse("bytes=0-99,100-199", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 200));
+
+    // 互不重叠时保持客户端请求的顺序
+    assert(HttpRange::parse("bytes=500-599,0-99", 1000, set) == Result::OK);
+    assert(set.count == 2);
+    assert(same(set.ranges[0], 500, 100));
+    assert(same(set.ranges[1], 0, 100));
+
+    std::cout << "Coalesce test passed." << std::endl;
+}
+
+void testMaxRanges() {
+    std::cout << "Testing Max Ranges..." << std::endl;
+
+    // 每个区间之间隔一个字节，互不相邻
+    auto disjoint = [](size_t count) {
+        std::string header = "bytes=";
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                header += ",";
+            }
+            header += std::to_string(i * 2) + "-" + std::to_string(i * 2);
+        }
+        return header;
+    };
+
+    HttpRange::RangeSet set;
+    assert(HttpRange::parse(disjoint(HttpRange::kMaxRanges), 1000, set) == Result::OK);
+    assert(set.count == HttpRange::kMaxRanges);
+    assert(HttpRange::parse(disjoint(HttpRange::kMaxRanges + 1), 1000, set) == Result::IGNORE);
+    assert(set.count == 0);
+
+    // 不可满足的区间被丢弃，不占名额
+    std::string header = disjoint(HttpRange::kMaxRanges) + ",5000-6000";
+    assert(HttpRange::parse(header, 1000, set) == Result::OK);
+    assert(set.count == HttpRange::kMaxRanges);
+
+    std::cout << "Max ranges test passed." << std::endl;
+}
+
+void testIgnoreVsNotSatisfiable() {
+    std::cout << "Testing Ignore Vs Not Satisfiable..." << std::endl;
+
+    HttpRange::RangeSet set;
+    // 语法错误 / 非 bytes 单位：忽略 Range，返回 200
+    for (const char* header : {"", "bytes", "bytes=", "bytes=,", "items=0-1", "bytes 0-1", "bytes=abc",
+                               "bytes=5-2", "bytes=0-1;x", "bytes=--1", "bytes=0-1,x"}) {
+        assert(HttpRange::parse(header, 1000, set) == Result::IGNORE);
+    }
+
+    // 语法正确但没有可满足区间：416
+    assert(HttpRange::parse("bytes=2000-3000", 1000, set) == Result::NOT_SATISFIABLE);
+    assert(HttpRange::parse("bytes=2000-3000,-0", 1000, set) == Result::NOT_SATISFIABLE);
+    assert(HttpRange::parse("bytes=0-", 0, set) == Result::NOT_SATISFIABLE);
+
+    // 只要有一个可满足区间就返回 206
+    assert(HttpRange::parse("bytes=2000-3000,0-9", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 0, 10));
+
+    std::cout << "Ignore vs not satisfiable test passed." << std::endl;
+}
+
+void testSatisfiableBoundary() {
+    std::cout << "Testing Satisfiable Boundary..." << std::endl;
+
+    HttpRange::RangeSet set;
+    // 最后一个字节可满足，start == size 不可满足
+    assert(HttpRange::parse("bytes=999-", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 999, 1));
+    assert(HttpRange::parse("bytes=999-999", 1000, set) == Result::OK);
+    assert(set.count == 1 && same(set.ranges[0], 999, 1));
+    assert(HttpRange::parse("bytes=1000-", 1000, set) == Result::NOT_SATISFIABLE);
+    assert(HttpRange::parse("bytes=1000-1000", 1000, set) == Result::NOT_SATISFIABLE);
+
+    std::cout << "Satisfiable boundary test passed." << std::endl;
+}
+
+void testIfRange() {
+    std::cout << "Testing If-Range..." << std::endl;
+
+    const char* etag = "\"abc\"";
+    const char* last_modified = "Wed, 21 Oct 2015 07:28:00 GMT";
+
+    // 强实体标签精确匹配
+    assert(HttpRange::ifRangeMatches("\"abc\"", etag, last_modified));
+    assert(HttpRange::ifRangeMatches(" \"abc\" ", etag, last_modified));
+    assert(!HttpRange::ifRangeMatches("\"abd\"", etag, last_modified));
+
+    // 弱实体标签在任一侧都不满足强比较
+    assert(!HttpRange::ifRangeMatches("W/\"abc\"", etag, last_modified));
+    assert(!HttpRange::ifRangeMatches("W/\"abc\"", "W/\"abc\"", last_modified));
+    assert(!HttpRange::ifRangeMatches("\"abc\"", "W/\"abc\"", last_modified));
+
+    // 日期与 Last-Modified 精确匹配
+    assert(HttpRange::ifRangeMatches(last_modified, etag, last_modified));
+    assert(!HttpRange::ifRangeMatches("Wed, 21 Oct 2015 07:28:01 GMT", etag, last_modified));
+    assert(!HttpRange::ifRangeMatches(last_modified, etag, ""));
+
+    assert(!HttpRange::ifRangeMatches("", etag, last_modified));
+
+    std::cout << "If-Range test passed." << std::endl;
+}
+
+int main() {
+    testSingleRange();
+    testSuffixRange();
+    testOverflow();
+    testCoalesce();
+    testMaxRanges();
+    testIgnoreVsNotSatisfiable();
+    testSatisfiableBoundary();
+    testIfRange();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,300 @@
+#include "http_request.h"
+#include "http_response.h"
+#include "micro_cache.h"
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Lookup = MicroCache::Lookup;
+
+// 每个分片的预算；条目占用 = key + 响应头 + 响应体 + 128
+constexpr size_t kShardBudget = 4000;
+constexpr size_t kShards = 16;
+
+static HttpRequest makeRequest(const std::string& uri) {
+    HttpRequest req;
+    req.set_method(HttpRequest::Method::GET);
+    req.set_uri(uri);
+    return req;
+}
+
+static MicroCache::Policy makePolicy(std::chrono::milliseconds ttl, std::chrono::milliseconds swr,
+                                     std::chrono::milliseconds sie) {
+    MicroCache::Policy policy;
+    policy.ttl = ttl;
+    policy.stale_while_revalidate = swr;
+    policy.stale_if_error = sie;
+    return policy;
+}
+
+struct Probe {
+    Lookup result;
+    HttpResponse resp;
+    std::shared_ptr<MicroCache::Flight> flight;
+    MicroCache::Ticket ticket;
+};
+
+static std::unique_ptr<Probe> probe(const std::string& uri, const MicroCache::Policy& policy) {
+    auto p = std::make_unique<Probe>();
+    HttpRequest req = makeRequest(uri);
+    p->result = MicroCache::Instance().lookup(req, policy, p->resp, p->flight, p->ticket);
+    return p;
+}
+
+// 模拟处理函数产出响应并交还 ticket
+static void respond(MicroCache::Ticket& ticket, HttpResponse& resp, const std::string& body,
+                    HttpStatus status = HttpStatus::OK) {
+    resp.set_status(status);
+    resp.set_body(body);
+    ticket.complete(resp);
+}
+
+static std::string bodyOf(const HttpResponse& resp) {
+    return std::string(resp.body_view());
+}
+
+void testSingleflight() {
+    std::cout << "Testing Singleflight..." << std::endl;
+
+    auto policy = makePolicy(1h, 0ms, 0ms);
+
+    auto leader = probe("/sf", policy);
+    assert(leader->result == Lookup::Compute && leader->ticket);
+
+    // 计算期间同一 key 的请求挂起等待
+    std::vector<MicroCache::EntryPtr> results;
+    std::vector<std::unique_ptr<Probe>> followers;
+    for (int i = 0; i < 3; ++i) {
+        followers.push_back(probe("/sf", policy));
+        assert(followers.back()->result == Lookup::Wait);
+        assert(followers.back()->flight && !followers.back()->ticket);
+        followers.back()->flight->wait([&results](const MicroCache::EntryPtr& entry) { results.push_back(entry); });
+    }
+    assert(followers[0]->flight == followers[2]->flight);
+    assert(results.empty());
+
+    // 其他 key 不受影响
+    auto other = probe("/sf-other", policy);
+    assert(other->result == Lookup::Compute && other->ticket);
+
+    respond(leader->ticket, leader->resp, "v1");
+    assert(!leader->ticket);
+    assert(results.size() == 3);
+    for (const auto& entry : results) {
+        assert(entry && entry->status == HttpStatus::OK && entry->body == "v1");
+    }
+
+    // 完成后再等待立即回调
+    MicroCache::EntryPtr late;
+    followers[0]->flight->wait([&late](const MicroCache::EntryPtr& entry) { late = entry; });
+    assert(late == results[0]);
+
+    // 之后直接命中，响应体引用条目内存
+    auto hit = probe("/sf", policy);
+    assert(hit->result == Lookup::Served && !hit->ticket);
+    assert(hit->resp.has_external_body() && bodyOf(hit->resp) == "v1");
+    assert(hit->resp.is_handled());
+
+    // 负责计算的请求未 complete 即放弃：等待者收到空结果，下一个请求重新计算
+    {
+        auto abandoned = probe("/sf-other", policy);
+        assert(abandoned->result == Lookup::Wait);
+        MicroCache::EntryPtr result = std::make_shared<const MicroCache::Entry>();
+        abandoned->flight->wait([&result](const MicroCache::EntryPtr& entry) { result = entry; });
+        other.reset();
+        assert(!result);
+    }
+    auto retry = probe("/sf-other", policy);
+    assert(retry->result == Lookup::Compute && retry->ticket);
+
+    std::cout << "Singleflight test passed." << std::endl;
+}
+
+void testStaleWhileRevalidate() {
+    std::cout << "Testing Stale While Revalidate..." << std::endl;
+
+    // ttl 为 0：条目一写入即过期，但在 stale_while_revalidate 内仍可返回
+    auto policy = makePolicy(0ms, 1h, 0ms);
+
+    auto first = probe("/swr", policy);
+    assert(first->result == Lookup::Compute);
+    respond(first->ticket, first->resp, "v1");
+
+    // 第一个读到过期条目的请求拿到刷新 ticket
+    auto stale = probe("/swr", policy);
+    assert(stale->result == Lookup::Served && stale->ticket);
+    assert(bodyOf(stale->resp) == "v1");
+
+    // 刷新进行中：其余请求只拿旧响应，不再发 ticket，也不挂起
+    auto concurrent = probe("/swr", policy);
+    assert(concurrent->result == Lookup::Served && !concurrent->ticket);
+    assert(bodyOf(concurrent->resp) == "v1");
+
+    // 后台刷新完成后返回新响应
+    HttpResponse refreshed;
+    respond(stale->ticket, refreshed, "v2");
+    auto after = probe("/swr", policy);
+    assert(after->result == Lookup::Served && bodyOf(after->resp) == "v2");
+    assert(after->ticket);
+
+    // 刷新放弃（未 complete）后旧条目保留，下一个请求重新拿到 ticket
+    after.reset();
+    auto again = probe("/swr", policy);
+    assert(again->result == Lookup::Served && again->ticket);
+    assert(bodyOf(again->resp) == "v2");
+
+    // 新鲜条目不发 ticket
+    auto fresh_policy = makePolicy(1h, 1h, 0ms);
+    auto fill = probe("/swr-fresh", fresh_policy);
+    respond(fill->ticket, fill->resp, "fresh");
+    auto fresh = probe("/swr-fresh", fresh_policy);
+    assert(fresh->result == Lookup::Served && !fresh->ticket);
+
+    std::cout << "Stale while revalidate test passed." << std::endl;
+}
+
+void testStaleIfError() {
+    std::cout << "Testing Stale If Error..." << std::endl;
+
+    // 过期即不可直接返回，只在计算失败时兜底
+    auto policy = makePolicy(0ms, 0ms, 1h);
+
+    auto first = probe("/sie", policy);
+    respond(first->ticket, first->resp, "good");
+
+    auto failing = probe("/sie", policy);
+    assert(failing->result == Lookup::Compute && failing->ticket);
+    auto waiter = probe("/sie", policy);
+    assert(waiter->result == Lookup::Wait);
+    MicroCache::EntryPtr waited;
+    waiter->flight->wait([&waited](const MicroCache::EntryPtr& entry) { waited = entry; });
+
+    // 5xx：本请求与等待者都改用旧响应，keep-alive 保持不变
+    failing->resp.set_keep_alive(true);
+    respond(failing->ticket, failing->resp, "boom", HttpStatus::INTERNAL_ERROR);
+    assert(failing->resp.status() == HttpStatus::OK);
+    assert(bodyOf(failing->resp) == "good");
+    assert(failing->resp.keep_alive());
+    assert(waited && waited->body == "good");
+
+    // 放弃计算同样视为失败
+    auto abandoned = probe("/sie", policy);
+    assert(abandoned->result == Lookup::Compute);
+    auto abandoned_waiter = probe("/sie", policy);
+    MicroCache::EntryPtr abandoned_result;
+    abandoned_waiter->flight->wait([&abandoned_result](const MicroCache::EntryPtr& entry) {
+        abandoned_result = entry;
+    });
+    abandoned.reset();
+    assert(abandoned_result && abandoned_result->body == "good");
+
+    // 没有 stale_if_error 时错误原样返回，且不写入缓存
+    auto strict = makePolicy(0ms, 0ms, 0ms);
+    auto strict_first = probe("/sie-strict", strict);
+    respond(strict_first->ticket, strict_first->resp, "good");
+    auto strict_failing = probe("/sie-strict", strict);
+    auto strict_waiter = probe("/sie-strict", strict);
+    MicroCache::EntryPtr strict_result;
+    strict_waiter->flight->wait([&strict_result](const MicroCache::EntryPtr& entry) { strict_result = entry; });
+    respond(strict_failing->ticket, strict_failing->resp, "boom", HttpStatus::INTERNAL_ERROR);
+    assert(strict_failing->resp.status() == HttpStatus::INTERNAL_ERROR);
+    assert(bodyOf(strict_failing->resp) == "boom");
+    assert(strict_result && strict_result->status == HttpStatus::INTERNAL_ERROR);
+
+    std::cout << "Stale if error test passed." << std::endl;
+}
+
+void testUncacheable() {
+    std::cout << "Testing Uncacheable..." << std::endl;
+
+    auto policy = makePolicy(1h, 0ms, 0ms);
+
+    auto cookie = probe("/private-cookie", policy);
+    cookie->resp.add_header("Set-Cookie", "sid=1");
+    respond(cookie->ticket, cookie->resp, "mine");
+    assert(probe("/private-cookie", policy)->result == Lookup::Compute);
+
+    auto no_store = probe("/private-no-store", policy);
+    no_store->resp.add_header("Cache-Control", "no-store");
+    respond(no_store->ticket, no_store->resp, "mine");
+    assert(probe("/private-no-store", policy)->result == Lookup::Compute);
+
+    auto not_found = probe("/private-404", policy);
+    respond(not_found->ticket, not_found->resp, "missing", HttpStatus::NOT_FOUND);
+    assert(probe("/private-404", policy)->result == Lookup::Compute);
+
+    std::cout << "Uncacheable test passed." << std::endl;
+}
+
+void testLruEviction() {
+    std::cout << "Testing LRU Eviction..." << std::endl;
+
+    // 淘汰按分片进行：挑出落在同一分片的 URI（key 与 MicroCache::makeKey 一致）
+    std::vector<std::string> uris;
+    size_t target = std::hash<std::string> {}("GET /lru/0") % kShards;
+    for (int i = 0; uris.size() < 5; ++i) {
+        std::string uri = "/lru/" + std::to_string(i);
+        if (std::hash<std::string> {}("GET " + uri) % kShards == target) {
+            uris.push_back(uri);
+        }
+    }
+
+    // 每个条目约 1200 字节，单个分片放得下 3 个
+    auto policy = makePolicy(1h, 0ms, 0ms);
+    const std::string body(1000, 'x');
+    auto fill = [&](const std::string& uri) {
+        auto p = probe(uri, policy);
+        assert(p->result == Lookup::Compute);
+        respond(p->ticket, p->resp, body);
+    };
+    auto cached = [&](const std::string& uri) { return probe(uri, policy)->result == Lookup::Served; };
+
+    fill(uris[0]);
+    fill(uris[1]);
+    fill(uris[2]);
+    assert(cached(uris[0]) && cached(uris[1]) && cached(uris[2]));
+
+    // 访问 0 使其变为最近使用，新条目淘汰最久未使用的 1
+    assert(cached(uris[0]));
+    fill(uris[3]);
+    assert(!cached(uris[1]));
+    assert(cached(uris[0]) && cached(uris[2]) && cached(uris[3]));
+
+    // 单个条目超出分片预算时不缓存，也不挤掉已有条目
+    auto huge = probe(uris[4], policy);
+    respond(huge->ticket, huge->resp, std::string(kShardBudget, 'y'));
+    assert(!cached(uris[4]));
+    assert(cached(uris[0]) && cached(uris[2]) && cached(uris[3]));
+
+    std::cout << "LRU eviction test passed." << std::endl;
+}
+
+void testDisabled() {
+    std::cout << "Testing Disabled..." << std::endl;
+
+    MicroCache::Instance().init(0);
+    auto policy = makePolicy(1h, 1h, 1h);
+    auto p = probe("/sf", policy);
+    assert(p->result == Lookup::Compute && !p->ticket);
+
+    std::cout << "Disabled test passed." << std::endl;
+}
+
+int main() {
+    MicroCache::Instance().init(kShardBudget * kShards);
+
+    testSingleflight();
+    testStaleWhileRevalidate();
+    testStaleIfError();
+    testUncacheable();
+    testLruEviction();
+    testDisabled();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <vector>
 #include <cassert>
+#include <chrono>
 
 void testConnectionPoolInitialization() {
     std::cout << "Testing MySQL Connection Pool Initialization..." << std::endl;
@@ -103,6 +104,36 @@ void testExecuteQuery() {
     std::cout << "Execute query test passed." << std::endl;
 }
 
+void testAcquireTimeout() {
+    std::cout << "Testing Acquire Timeout..." << std::endl;
+    
+    auto& pool = MySQLConnectionPool::Instance();
+    auto& config = ConfigManager::Instance();
+    int pool_size = config.get<int>("mysql.pool_size", 8);
+    int timeout_ms = config.get<int>("mysql.acquire_timeout_ms", 1000);
+    
+    // 占满连接池
+    std::vector<std::shared_ptr<MySQLConnectionGuard>> connections;
+    for (int i = 0; i < pool_size; ++i) {
+        auto conn = pool.getConnection();
+        assert(conn != nullptr);
+        connections.push_back(std::move(conn));
+    }
+    
+    // 池满时应在 acquire_timeout 后返回空，而不是一直阻塞
+    auto start = std::chrono::steady_clock::now();
+    auto conn = pool.getConnection();
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    assert(conn == nullptr);
+    assert(waited.count() >= timeout_ms);
+    
+    // 归还后可以再次获取
+    connections.pop_back();
+    assert(pool.getConnection() != nullptr);
+    
+    std::cout << "Acquire timeout test passed." << std::endl;
+}
+
 int main() {
     try {
         testConnectionPoolInitialization();
@@ -110,6 +141,7 @@ int main() {
         testMultipleConnections();
         testConnectionReuse();
         testExecuteQuery();
+        testAcquireTimeout();
         
         std::cout << "All tests passed!" << std::endl;
         return 0;
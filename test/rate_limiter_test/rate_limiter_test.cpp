@@ -0,0 +1,223 @@
+#include "rate_limiter.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Bucket = RateLimiter::Bucket;
+
+// 表按 reactor 线程保存且 init 不清空，每个用例使用各自的地址段
+static RateLimiter::Options makeOptions() {
+    RateLimiter::Options options;
+    options.enabled = true;
+    options.rate = 10;
+    options.burst = 3;
+    options.credential_rate = 1;
+    options.credential_burst = 2;
+    options.max_connections = 0;
+    options.table_sets = 64;
+    return options;
+}
+
+static void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void testRefillAndBurst() {
+    std::cout << "Testing Refill And Burst..." << std::endl;
+
+    auto& limiter = RateLimiter::Instance();
+    limiter.init(makeOptions());
+    const uint32_t addr = 0x0100000a;
+
+    // 新地址从满桶开始，连续放行 burst 个请求
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(!limiter.allow(addr, Bucket::Default));
+
+    // 10/s 补充，250ms 后约 2.5 个令牌
+    sleepMs(250);
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(!limiter.allow(addr, Bucket::Default));
+
+    // 空闲再久也不超过 burst
+    sleepMs(1000);
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Default));
+    assert(!limiter.allow(addr, Bucket::Default));
+
+    // 其他地址不受影响
+    assert(limiter.allow(addr + 1, Bucket::Default));
+
+    std::cout << "Refill and burst test passed." << std::endl;
+}
+
+void testCredentialBucket() {
+    std::cout << "Testing Credential Bucket..." << std::endl;
+
+    auto& limiter = RateLimiter::Instance();
+    limiter.init(makeOptions());
+    const uint32_t addr = 0x0200000a;
+
+    // 普通请求耗尽后登录 / 注册桶仍为满
+    for (int i = 0; i < 3; ++i) {
+        assert(limiter.allow(addr, Bucket::Default));
+    }
+    assert(!limiter.allow(addr, Bucket::Default));
+    assert(limiter.allow(addr, Bucket::Credential));
+    assert(limiter.allow(addr, Bucket::Credential));
+    assert(!limiter.allow(addr, Bucket::Credential));
+
+    // 登录 / 注册桶耗尽不影响普通请求的补充
+    const uint32_t other = 0x0200010a;
+    assert(limiter.allow(other, Bucket::Credential));
+    assert(limiter.allow(other, Bucket::Credential));
+    assert(!limiter.allow(other, Bucket::Credential));
+    for (int i = 0; i < 3; ++i) {
+        assert(limiter.allow(other, Bucket::Default));
+    }
+
+    // 速率为 0 的桶不限速
+    auto options = makeOptions();
+    options.credential_rate = 0;
+    limiter.init(options);
+    for (int i = 0; i < 100; ++i) {
+        assert(limiter.allow(addr, Bucket::Credential));
+    }
+
+    std::cout << "Credential bucket test passed." << std::endl;
+}
+
+void testEviction() {
+    std::cout << "Testing Eviction..." << std::endl;
+
+    // 只有一组（4 路），第 5 个地址淘汰最久未访问的那个
+    auto& limiter = RateLimiter::Instance();
+    auto options = makeOptions();
+    options.rate = 1;
+    options.burst = 1;
+    options.table_sets = 1;
+    limiter.init(options);
+
+    const uint32_t base = 0x0300000a;
+    for (uint32_t i = 0; i < 4; ++i) {
+        assert(limiter.allow(base + (i << 24), Bucket::Default));
+        assert(!limiter.allow(base + (i << 24), Bucket::Default));
+        sleepMs(5);
+    }
+
+    // 最近访问的地址 0 变为最新，地址 1 成为最久未访问
+    assert(!limiter.allow(base, Bucket::Default));
+    sleepMs(5);
+
+    // 新地址占用地址 1 的位置
+    assert(limiter.allow(base + (4u << 24), Bucket::Default));
+    assert(!limiter.allow(base, Bucket::Default));
+    assert(!limiter.allow(base + (2u << 24), Bucket::Default));
+    assert(!limiter.allow(base + (3u << 24), Bucket::Default));
+
+    // 被淘汰的地址重新出现时从满桶开始
+    assert(limiter.allow(base + (1u << 24), Bucket::Default));
+    assert(!limiter.allow(base + (1u << 24), Bucket::Default));
+
+    std::cout << "Eviction test passed." << std::endl;
+}
+
+void testExempt() {
+    std::cout << "Testing Exempt..." << std::endl;
+
+    auto& limiter = RateLimiter::Instance();
+    auto options = makeOptions();
+    options.max_connections = 1;
+    options.exempt = {0x0100007f};
+    limiter.init(options);
+
+    for (int i = 0; i < 100; ++i) {
+        assert(limiter.allow(0x0100007f, Bucket::Default));
+        assert(limiter.allow(0x0100007f, Bucket::Credential));
+        assert(limiter.acquireConnection(0x0100007f));
+        assert(limiter.allow(0, Bucket::Default));
+    }
+    for (int i = 0; i < 100; ++i) {
+        limiter.releaseConnection(0x0100007f);
+    }
+
+    options.enabled = false;
+    limiter.init(options);
+    for (int i = 0; i < 100; ++i) {
+        assert(limiter.allow(0x0400000a, Bucket::Default));
+        assert(limiter.acquireConnection(0x0400000a));
+    }
+
+    std::cout << "Exempt test passed." << std::endl;
+}
+
+void testConnectionSlots() {
+    std::cout << "Testing Connection Slots..." << std::endl;
+
+    auto& limiter = RateLimiter::Instance();
+    auto options = makeOptions();
+    options.max_connections = 2;
+    limiter.init(options);
+    const uint32_t addr = 0x0500000a;
+
+    assert(limiter.acquireConnection(addr));
+    assert(limiter.acquireConnection(addr));
+    assert(!limiter.acquireConnection(addr));
+    assert(limiter.acquireConnection(addr + 1));
+
+    // 归还一个后可以再占用一个
+    limiter.releaseConnection(addr);
+    assert(limiter.acquireConnection(addr));
+    assert(!limiter.acquireConnection(addr));
+
+    // 全部归还后名额恢复到上限；多余的归还不会让计数变负
+    limiter.releaseConnection(addr);
+    limiter.releaseConnection(addr);
+    limiter.releaseConnection(addr);
+    limiter.releaseConnection(addr + 1);
+    assert(limiter.acquireConnection(addr));
+    assert(limiter.acquireConnection(addr));
+    assert(!limiter.acquireConnection(addr));
+    limiter.releaseConnection(addr);
+    limiter.releaseConnection(addr);
+
+    // 多线程占用 / 归还后计数保持平衡
+    const int threads = 8;
+    const int rounds = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&limiter, addr]() {
+            for (int i = 0; i < rounds; ++i) {
+                if (limiter.acquireConnection(addr)) {
+                    limiter.releaseConnection(addr);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    assert(limiter.acquireConnection(addr));
+    assert(limiter.acquireConnection(addr));
+    assert(!limiter.acquireConnection(addr));
+    limiter.releaseConnection(addr);
+    limiter.releaseConnection(addr);
+
+    std::cout << "Connection slots test passed." << std::endl;
+}
+
+int main() {
+    testRefillAndBurst();
+    testCredentialBucket();
+    testEviction();
+    testExempt();
+    testConnectionSlots();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
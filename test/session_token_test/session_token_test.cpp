@@ -0,0 +1,245 @@
+#include "session_token.h"
+#include <cassert>
+#include <ctime>
+#include <iostream>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <string>
+#include <vector>
+
+using Result = SessionToken::Result;
+
+static const std::string kSecret1 = "0123456789abcdef0123456789abcdef";
+static const std::string kSecret2 = "fedcba9876543210fedcba9876543210";
+
+// 用测试侧独立的 HMAC 实现签名任意内容，用来构造签名合法但内容畸形的令牌
+static std::string sign(const std::string& secret, const std::string& payload) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), mac, &len);
+
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (unsigned int i = 0; i < len; ++i) {
+        acc = (acc << 8) | mac[i];
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(alphabet[(acc >> bits) & 0x3F]);
+        }
+    }
+    if (bits > 0) {
+        out.push_back(alphabet[(acc << (6 - bits)) & 0x3F]);
+    }
+    return payload + "." + out;
+}
+
+static std::string future() {
+    return std::to_string(std::time(nullptr) + 3600);
+}
+
+static void useKeys(const std::vector<SessionToken::Key>& keys, const std::string& active) {
+    bool ok = SessionToken::Instance().setKeys(keys, active);
+    assert(ok);
+    (void)ok;
+}
+
+void testRoundTrip() {
+    std::cout << "Testing Round Trip..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+    tokens.setTtl(3600);
+
+    for (const char* name : {"alice", "a", "ab", "abc", "用户", "x.y.z"}) {
+        std::string token = tokens.issue(name);
+        assert(token.starts_with("k1."));
+        std::string username;
+        assert(tokens.verify(token, &username) == Result::Valid);
+        assert(username == name);
+    }
+
+    // 与独立实现的 HMAC 结果一致
+    std::string token = tokens.issue("alice");
+    assert(token == sign(kSecret1, token.substr(0, token.rfind('.'))));
+
+    std::cout << "Round trip test passed." << std::endl;
+}
+
+void testTampered() {
+    std::cout << "Testing Tampered..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+    tokens.setTtl(3600);
+
+    std::string token = tokens.issue("alice");
+    size_t kid_dot = token.find('.');
+    size_t exp_dot = token.find('.', kid_dot + 1);
+    size_t mac_dot = token.rfind('.');
+
+    // 篡改签名
+    std::string mac = token;
+    mac[mac_dot + 1] = mac[mac_dot + 1] == 'A' ? 'B' : 'A';
+    assert(tokens.verify(mac) == Result::Invalid);
+
+    // 篡改用户名（"alice" -> "bob"）
+    std::string user = token.substr(0, exp_dot + 1) + "Ym9i" + token.substr(mac_dot);
+    assert(tokens.verify(user) == Result::Invalid);
+
+    // 延长过期时间
+    std::string expiry = token.substr(0, kid_dot + 1) + std::to_string(std::time(nullptr) + 86400 * 365) +
+                         token.substr(exp_dot);
+    assert(tokens.verify(expiry) == Result::Invalid);
+
+    // 截断与多余字段
+    assert(tokens.verify(token.substr(0, token.size() - 1)) == Result::Invalid);
+    assert(tokens.verify(token + "A") == Result::Invalid);
+    assert(tokens.verify("") == Result::Invalid);
+    assert(tokens.verify("k1") == Result::Invalid);
+    assert(tokens.verify(token.substr(mac_dot)) == Result::Invalid);
+
+    // 换一把同名密钥后原令牌失效
+    useKeys({{"k1", kSecret2}}, "k1");
+    assert(tokens.verify(token) == Result::Invalid);
+
+    std::cout << "Tampered test passed." << std::endl;
+}
+
+void testExpired() {
+    std::cout << "Testing Expired..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+
+    tokens.setTtl(-1);
+    std::string token = tokens.issue("alice");
+    assert(tokens.verify(token) == Result::Expired);
+
+    // 过期时间恰好为当前时刻也视为过期
+    std::string now = sign(kSecret1, "k1." + std::to_string(std::time(nullptr)) + ".YWxpY2U");
+    assert(tokens.verify(now) == Result::Expired);
+
+    // 签名不对时先报 Invalid，不泄露过期信息
+    std::string forged = token;
+    forged.back() = forged.back() == 'A' ? 'B' : 'A';
+    assert(tokens.verify(forged) == Result::Invalid);
+
+    tokens.setTtl(3600);
+
+    std::cout << "Expired test passed." << std::endl;
+}
+
+void testUnknownKid() {
+    std::cout << "Testing Unknown Kid..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+
+    // 即使签名用的是环内密钥，kid 不在环中也拒绝
+    assert(tokens.verify(sign(kSecret1, "k9." + future() + ".YWxpY2U")) == Result::Invalid);
+    assert(tokens.verify(sign(kSecret1, "." + future() + ".YWxpY2U")) == Result::Invalid);
+    assert(tokens.verify(sign(kSecret1, "k1." + future() + ".YWxpY2U")) == Result::Valid);
+
+    // 非法配置不替换现有密钥环
+    assert(!tokens.setKeys({{"k2", kSecret2}}, "k3"));
+    assert(!tokens.setKeys({{"bad.id", kSecret2}}, "bad.id"));
+    assert(!tokens.setKeys({{"k2", kSecret2}, {"k2", kSecret1}}, "k2"));
+    assert(!tokens.setKeys({{"k2", ""}}, "k2"));
+    assert(tokens.issue("alice").starts_with("k1."));
+
+    std::cout << "Unknown kid test passed." << std::endl;
+}
+
+void testKeyRotation() {
+    std::cout << "Testing Key Rotation..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    tokens.setTtl(3600);
+    useKeys({{"k1", kSecret1}}, "k1");
+    std::string old_token = tokens.issue("alice");
+
+    // 加入新密钥并切换签发，旧令牌仍可校验
+    useKeys({{"k1", kSecret1}, {"k2", kSecret2}}, "k2");
+    std::string new_token = tokens.issue("bob");
+    assert(new_token.starts_with("k2."));
+
+    std::string username;
+    assert(tokens.verify(old_token, &username) == Result::Valid);
+    assert(username == "alice");
+    assert(tokens.verify(new_token, &username) == Result::Valid);
+    assert(username == "bob");
+
+    // 移除旧密钥后旧令牌被拒绝，新令牌不受影响
+    useKeys({{"k2", kSecret2}}, "k2");
+    assert(tokens.verify(old_token) == Result::Invalid);
+    assert(tokens.verify(new_token) == Result::Valid);
+
+    // parseKeys 解析配置，跳过没有冒号的项
+    auto keys = SessionToken::parseKeys("k1:" + kSecret1 + ",broken,k2:" + kSecret2);
+    assert(keys.size() == 2);
+    assert(keys[0].id == "k1" && keys[0].secret == kSecret1);
+    assert(keys[1].id == "k2" && keys[1].secret == kSecret2);
+
+    std::cout << "Key rotation test passed." << std::endl;
+}
+
+void testMalformedBase64() {
+    std::cout << "Testing Malformed Base64..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+
+    // 签名合法但用户名段不是 base64url
+    std::string username;
+    assert(tokens.verify(sign(kSecret1, "k1." + future() + ".YWx+aWNl"), &username) == Result::Invalid);
+    assert(tokens.verify(sign(kSecret1, "k1." + future() + ".YWxpY2U="), &username) == Result::Invalid);
+
+    // 签名合法但过期时间不是整数
+    assert(tokens.verify(sign(kSecret1, "k1.12x4.YWxpY2U")) == Result::Invalid);
+    assert(tokens.verify(sign(kSecret1, "k1..YWxpY2U")) == Result::Invalid);
+
+    // 签名段含非法字符或带填充
+    std::string token = tokens.issue("alice");
+    std::string bad_mac = token;
+    bad_mac.back() = '+';
+    assert(tokens.verify(bad_mac) == Result::Invalid);
+    assert(tokens.verify(token + "=") == Result::Invalid);
+
+    std::cout << "Malformed base64 test passed." << std::endl;
+}
+
+void testCookie() {
+    std::cout << "Testing Cookie..." << std::endl;
+
+    auto& tokens = SessionToken::Instance();
+    useKeys({{"k1", kSecret1}}, "k1");
+    tokens.setCookie("sid", false);
+
+    std::string value = tokens.setCookieValue("alice");
+    assert(value.starts_with("sid=k1."));
+    std::string token = value.substr(4, value.find(';') - 4);
+
+    std::string header = "theme=dark; sidx=1; sid=" + token + "; lang=zh";
+    assert(tokens.findCookie(header) == token);
+    assert(tokens.findCookie("theme=dark; sidx=1").empty());
+    assert(tokens.clearCookieValue().starts_with("sid=;"));
+
+    std::cout << "Cookie test passed." << std::endl;
+}
+
+int main() {
+    testRoundTrip();
+    testTampered();
+    testExpired();
+    testUnknownKid();
+    testKeyRotation();
+    testMalformedBase64();
+    testCookie();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
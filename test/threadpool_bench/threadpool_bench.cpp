@@ -0,0 +1,199 @@
+// 线程池吞吐量对比：工作窃取 FThreadPool vs 原先的单队列 + 互斥锁 + 条件变量实现
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "threadpool.h"
+
+// -------------------------- 测试参数配置（可按需调整）--------------------------
+const int WORKERS = 8;                // 线程池工作线程数
+const int PRODUCERS = 4;              // 外部提交线程数（模拟 SubReactor）
+const int TASKS_PER_PRODUCER = 250000; // 每个提交线程的任务数
+const int FANOUT_DEPTH = 16;          // 派生测试：二叉递归深度，共 2^depth - 1 个任务
+const int BURST_TASK_MS = 20;         // 突发测试：每个任务阻塞的毫秒数，共 WORKERS 个任务
+// -----------------------------------------------------------------------------------
+
+// 原实现：一个 std::queue<std::function> + 一把锁 + 一个条件变量
+class LegacyPool {
+public:
+    explicit LegacyPool(size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            threads_.emplace_back([this, i] { worker(i); });
+        }
+    }
+
+    ~LegacyPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        condition_.notify_all();
+        for (auto& t : threads_) {
+            t.join();
+        }
+    }
+
+    template<typename F>
+    void pushTask(const F& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push(std::function<void(size_t)>(task));
+            ++pending_;
+        }
+        condition_.notify_one();
+    }
+
+    void waitTasksFinish() const {
+        while (pending_ != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    void worker(size_t id) {
+        while (true) {
+            std::function<void(size_t)> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this] { return !running_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task(id);
+            --pending_;
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool running_ = true;
+    std::queue<std::function<void(size_t)>> tasks_;
+    std::atomic<size_t> pending_ {0};
+    std::vector<std::thread> threads_;
+};
+
+// 多个外部线程并发提交小任务（捕获 40 字节左右的状态，与 SubReactor 投递的回调相当）
+template<typename Pool>
+double runSubmit(Pool& pool, std::atomic<uint64_t>& sum) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&pool, &sum, p] {
+            for (int i = 0; i < TASKS_PER_PRODUCER; ++i) {
+                uint64_t a = p, b = i, c = 1, d = 2;
+                pool.pushTask([&sum, a, b, c, d](size_t) { sum.fetch_add(a + b + c + d - 3, std::memory_order_relaxed); });
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    pool.waitTasksFinish();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 任务内部继续派生任务（二叉递归），考察工作线程本地提交与窃取
+template<typename Pool>
+void spawn(Pool& pool, std::atomic<uint64_t>& count, int depth) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    if (depth > 1) {
+        pool.pushTask([&pool, &count, depth](size_t) { spawn(pool, count, depth - 1); });
+        pool.pushTask([&pool, &count, depth](size_t) { spawn(pool, count, depth - 1); });
+    }
+}
+
+template<typename Pool>
+double runFanout(Pool& pool, std::atomic<uint64_t>& count) {
+    auto start = std::chrono::steady_clock::now();
+    pool.pushTask([&pool, &count](size_t) { spawn(pool, count, FANOUT_DEPTH); });
+    pool.waitTasksFinish();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 突发提交：池刚处理完一个任务（有线程正在自旋）时一次提交 WORKERS 个阻塞任务，应分散到各个工作线程并行执行，
+// 耗时接近单个任务而不是 WORKERS 倍
+template<typename Pool>
+double runBurst(Pool& pool, size_t& threads_used) {
+    pool.pushTask([](size_t) {});
+    pool.waitTasksFinish();
+    // 让刚执行完任务的线程进入自旋找任务的阶段
+    std::this_thread::yield();
+
+    std::mutex mutex;
+    std::set<std::thread::id> used;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < WORKERS; ++i) {
+        pool.pushTask([&mutex, &used](size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(BURST_TASK_MS));
+            std::lock_guard<std::mutex> lock(mutex);
+            used.insert(std::this_thread::get_id());
+        });
+    }
+    pool.waitTasksFinish();
+    threads_used = used.size();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Pool>
+bool bench(const char* name) {
+    Pool pool(WORKERS);
+    const uint64_t total = static_cast<uint64_t>(PRODUCERS) * TASKS_PER_PRODUCER;
+    uint64_t expected_sum = 0;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        expected_sum += static_cast<uint64_t>(p) * TASKS_PER_PRODUCER +
+                        static_cast<uint64_t>(TASKS_PER_PRODUCER) * (TASKS_PER_PRODUCER - 1) / 2;
+    }
+
+    std::atomic<uint64_t> sum {0};
+    double submit_sec = runSubmit(pool, sum);
+
+    std::atomic<uint64_t> count {0};
+    double fanout_sec = runFanout(pool, count);
+    const uint64_t fanout_total = (1ULL << FANOUT_DEPTH) - 1;
+
+    size_t burst_threads = 0;
+    double burst_sec = runBurst(pool, burst_threads);
+
+    std::cout << std::left << std::setw(16) << name << std::fixed << std::setprecision(0)
+              << "submit: " << std::setw(12) << total / submit_sec << " tasks/s   "
+              << "fanout: " << std::setw(12) << fanout_total / fanout_sec << " tasks/s   "
+              << "burst: " << burst_sec * 1000 << " ms on " << burst_threads << " threads\n";
+
+    if (sum != expected_sum || count != fanout_total) {
+        std::cout << "  结果校验失败: sum=" << sum << " expected=" << expected_sum
+                  << " count=" << count << " expected=" << fanout_total << "\n";
+        return false;
+    }
+    // 突发的任务都在阻塞，串行执行需要 WORKERS 倍单任务耗时；并行时应远小于一半
+    if (burst_sec * 1000 >= WORKERS * BURST_TASK_MS / 2.0) {
+        std::cout << "  突发提交未分散到多个工作线程: " << burst_threads << " threads\n";
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << "===================== 线程池吞吐量测试 =====================\n";
+    std::cout << "  - 工作线程数: " << WORKERS << "\n";
+    std::cout << "  - 提交线程数: " << PRODUCERS << " x " << TASKS_PER_PRODUCER << " 任务\n";
+    std::cout << "  - 派生深度: " << FANOUT_DEPTH << "\n";
+    std::cout << "  - 突发: " << WORKERS << " x " << BURST_TASK_MS << " ms 阻塞任务\n";
+    std::cout << "============================================================\n";
+
+    bool ok = bench<LegacyPool>("mutex+condvar");
+    ok = bench<FThreadPool>("work-stealing") && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
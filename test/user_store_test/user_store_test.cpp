@@ -0,0 +1,193 @@
+#include "log_user_store.h"
+#include <atomic>
+#include <cassert>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static LogUserStore::Options makeOptions(const fs::path& dir) {
+    LogUserStore::Options options;
+    options.dir = dir.string();
+    options.shards = 8;
+    options.snapshot_bytes = 0;
+    return options;
+}
+
+void testInsertAndFind(const fs::path& dir) {
+    std::cout << "Testing Insert And Find..." << std::endl;
+
+    LogUserStore store(makeOptions(dir));
+    assert(store.init());
+
+    assert(store.insert("alice", "pw1") == UserStore::InsertResult::Created);
+    assert(store.insert("alice", "other") == UserStore::InsertResult::Duplicate);
+
+    std::string passwd;
+    assert(store.find("alice", passwd) == UserStore::FindResult::Found);
+    assert(passwd == "pw1");
+    assert(store.find("bob", passwd) == UserStore::FindResult::Absent);
+
+    std::cout << "Insert and find test passed." << std::endl;
+}
+
+void testReplay(const fs::path& dir) {
+    std::cout << "Testing Replay..." << std::endl;
+
+    {
+        LogUserStore store(makeOptions(dir));
+        assert(store.init());
+        assert(store.size() == 1);
+        assert(store.insert("bob", "pw2") == UserStore::InsertResult::Created);
+    }
+
+    // 模拟崩溃时写了一半的记录
+    {
+        std::ofstream log(dir / "users.log", std::ios::binary | std::ios::app);
+        log.write("\x01\x02\x03", 3);
+    }
+
+    LogUserStore store(makeOptions(dir));
+    assert(store.init());
+    assert(store.size() == 2);
+    std::string passwd;
+    assert(store.find("bob", passwd) == UserStore::FindResult::Found);
+    assert(passwd == "pw2");
+    // 损坏的尾部已被截掉，之后的写入可以正常回放
+    assert(store.insert("carol", "pw3") == UserStore::InsertResult::Created);
+
+    std::cout << "Replay test passed." << std::endl;
+}
+
+void testSnapshot(const fs::path& dir) {
+    std::cout << "Testing Snapshot..." << std::endl;
+
+    {
+        LogUserStore store(makeOptions(dir));
+        assert(store.init());
+        assert(store.snapshot());
+        assert(fs::exists(dir / "users.snap"));
+        assert(!fs::exists(dir / "users.log.old"));
+        assert(fs::file_size(dir / "users.log") == 0);
+        assert(store.insert("dave", "pw4") == UserStore::InsertResult::Created);
+    }
+
+    LogUserStore store(makeOptions(dir));
+    assert(store.init());
+    assert(store.size() == 4);
+    std::string passwd;
+    assert(store.find("carol", passwd) == UserStore::FindResult::Found);
+    assert(store.find("dave", passwd) == UserStore::FindResult::Found);
+
+    std::cout << "Snapshot test passed." << std::endl;
+}
+
+void testConcurrentInsert(const fs::path& dir) {
+    std::cout << "Testing Concurrent Insert..." << std::endl;
+
+    const int threads = 8;
+    const int per_thread = 200;
+    {
+        auto options = makeOptions(dir);
+        options.snapshot_bytes = 4096; // 写入过程中触发后台快照
+        LogUserStore store(options);
+        assert(store.init());
+
+        std::atomic<int> created {0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&store, &created, t] {
+                for (int i = 0; i < per_thread; ++i) {
+                    // 每个用户名由两个线程竞争注册
+                    std::string name = "user" + std::to_string((t / 2) * per_thread + i);
+                    if (store.insert(name, "pw") == UserStore::InsertResult::Created) {
+                        ++created;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        assert(created == threads / 2 * per_thread);
+    }
+
+    LogUserStore store(makeOptions(dir));
+    assert(store.init());
+    assert(store.size() == static_cast<size_t>(4 + threads / 2 * per_thread));
+
+    std::cout << "Concurrent insert test passed." << std::endl;
+}
+
+void testWriteFailureAfterInsert(const fs::path& dir) {
+    std::cout << "Testing Write Failure After Insert..." << std::endl;
+
+    {
+        LogUserStore store(makeOptions(dir));
+        assert(store.init());
+        assert(store.insert("grace", "pw5") == UserStore::InsertResult::Created);
+
+        // 日志文件不能再增长：之后的刷写以 EFBIG 失败
+        rlimit saved {};
+        getrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limit = saved;
+        limit.rlim_cur = static_cast<rlim_t>(fs::file_size(dir / "users.log"));
+        setrlimit(RLIMIT_FSIZE, &limit);
+
+        bool rejected = false;
+        try {
+            store.insert("heidi", "pw6");
+        } catch (const DatabaseUnavailable&) {
+            rejected = true;
+        }
+        setrlimit(RLIMIT_FSIZE, &saved);
+        assert(rejected);
+
+        // 未落盘的注册对查找不可见，也不会被快照写进去
+        std::string passwd;
+        assert(store.find("heidi", passwd) == UserStore::FindResult::Absent);
+        assert(store.find("grace", passwd) == UserStore::FindResult::Found);
+        assert(!store.snapshot());
+        assert(!fs::exists(dir / "users.snap"));
+
+        // 存储已只读
+        rejected = false;
+        try {
+            store.insert("heidi", "pw6");
+        } catch (const DatabaseUnavailable&) {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+
+    LogUserStore store(makeOptions(dir));
+    assert(store.init());
+    std::string passwd;
+    assert(store.find("grace", passwd) == UserStore::FindResult::Found);
+    assert(store.find("heidi", passwd) == UserStore::FindResult::Absent);
+
+    std::cout << "Write failure after insert test passed." << std::endl;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("user_store_test_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+
+    testInsertAndFind(dir);
+    testReplay(dir);
+    testSnapshot(dir);
+    testConcurrentInsert(dir);
+    testWriteFailureAfterInsert(dir / "write_failure");
+
+    fs::remove_all(dir);
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}